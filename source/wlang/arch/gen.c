@@ -1,64 +1,60 @@
 #include <wlang/arch/gen.h>
-#include <wlang/pim.h>
 
-DEFINE_LIST_TYPE(AssemblyLine)
-
-void AssemblyOutput_NewLine(AssemblyOutput* self, int indent)
-{
-    AssemblyLine nl;
-    AssemblyLine_Initialize(&nl, indent);
-    AssemblyLineList_PushRef(&self->lines, PIM_MOVE(&nl));
-}
-
-AssemblyLine* AssemblyOutput_Line(AssemblyOutput* self)
+void AssemblyOutput_Reserve(AssemblyOutput* self, size_t size)
 {
-    return &self->lines.data[self->lines.count - 1];
+    if(self->count + size <= self->capacity) return;
+    size_t capacity = self->capacity ? self->capacity * 2 : ASSEMBLY_OUTPUT_FLUSH_SIZE;
+    while(capacity < self->count + size) capacity *= 2;
+    self->data = realloc(self->data, capacity);
+    self->capacity = capacity;
 }
 
-static void AssemblyOutput__FlushLine(AssemblyOutput* self, AssemblyLine* line, FILE* target)
+void AssemblyOutput_Flush(AssemblyOutput* self, FILE* target)
 {
-    if(!line) return;
-
-    for(int i = 0; i < line->indent * self->tab_width; ++i)
-        fputc(' ', target);
-    
-    if(line->line)
-        fprintf(target, "%s\n", line->line);
+    if(self->count) fwrite(self->data, 1, self->count, target);
+    self->count = 0;
 }
 
-void AssemblyOutput_Flush(AssemblyOutput* self, FILE* target)
+char* AssemblyGenerator_Reserve(AssemblyGenerator* self, int indent, size_t size)
 {
-    for(size_t i = 0; i < self->lines.count; ++i)
-        AssemblyOutput__FlushLine(self, &self->lines.data[i], target);
-    
-    AssemblyLineList_Free(&self->lines);
+    AssemblyOutput* output = &self->output;
+    size_t spaces = (size_t)(indent * output->tab_width);
+    AssemblyOutput_Reserve(output, spaces + size + 2);
+    memset(output->data + output->count, ' ', spaces);
+    output->count += spaces;
+    return output->data + output->count;
 }
 
-char* AssemblyGenerator__StackOffsetString(size_t offset)
+void AssemblyGenerator_Commit(AssemblyGenerator* self, size_t length)
 {
-    char* m = malloc(32);
-    snprintf(m, 32, "qword ptr [rbp - %zu]", offset);
-    return m;
+    AssemblyOutput* output = &self->output;
+    output->count += length;
+    output->data[output->count++] = '\n';
+    output->lines++;
 }
 
-AssemblyLine* AssemblyGenerator_WriteIndentV(AssemblyGenerator* self, int indent, const char *fmt, va_list va)
+void AssemblyGenerator_WriteIndentV(AssemblyGenerator* self, int indent, const char *fmt, va_list va)
 {
     va_list va2;
     va_copy(va2, va);
 
-    AssemblyOutput_NewLine(&self->output, indent);
-    size_t nsz = vsnprintf(NULL, 0, fmt, va);
-    AssemblyOutput_Line(&self->output)->line = malloc(nsz + 1);
-    vsnprintf(AssemblyOutput_Line(&self->output)->line, nsz + 1, fmt, va2);
+    char* line = AssemblyGenerator_Reserve(self, indent, ASSEMBLY_LINE_GUESS);
+    size_t length = (size_t)vsnprintf(line, ASSEMBLY_LINE_GUESS + 1, fmt, va);
+    if(length > ASSEMBLY_LINE_GUESS)
+    {
+        // The indentation is already there, only the room after it has to grow.
+        AssemblyOutput_Reserve(&self->output, length + 2);
+        vsnprintf(self->output.data + self->output.count, length + 1, fmt, va2);
+    }
+    AssemblyGenerator_Commit(self, length);
 
     va_end(va2);
-    return AssemblyOutput_Line(&self->output);
 }
 void AssemblyGenerator_Write(AssemblyGenerator* self, const char* fmt, ...)
 {
     va_list va;
     va_start(va, fmt);
-    AssemblyGenerator__WriteIndentV(self, self->indent, fmt, va);
+    AssemblyGenerator_WriteIndentV(self, self->indent, fmt, va);
     va_end(va);
 }
 void AssemblyGenerator_WriteNoIndent(AssemblyGenerator* self, const char* fmt, ...)
@@ -1,42 +1,42 @@
 #ifndef WLANG_HEADER_GEN_
 #define WLANG_HEADER_GEN_
+#include <stdarg.h>
 #include <wlang/util.h>
 #include <wlang/type.h>
 #include <wlang/common.h>
 
-typedef struct { char* line; int indent; } AssemblyLine;
-inline void AssemblyLine_Initialize(AssemblyLine* self, int indent)
-{
-    self->line = NULL;
-    self->indent = indent;
-}
-inline void AssemblyLine_Free(AssemblyLine* self)
-{
-    if(self->line) free(self->line);
-}
-
-DECLARE_LIST_TYPE(AssemblyLine)
+// How much output is collected before it is worth writing out.
+#define ASSEMBLY_OUTPUT_FLUSH_SIZE (64 * 1024)
+// Most lines are shorter, so this is reserved for one before knowing how long it is.
+#define ASSEMBLY_LINE_GUESS 128
 
+// Lines of assembly, one after another in a single buffer, so that writing one allocates
+// nothing once the buffer is big enough and flushing it is one write.
 typedef struct
 {
-    AssemblyLineList lines;
+    char* data;
+    size_t count, capacity;
+    size_t lines; // Written so far, flushed or not.
     int tab_width;
 } AssemblyOutput;
 
-inline void AssemblyOutput_Initialize(AssemblyOutput* self, int tab_width)
+static inline void AssemblyOutput_Initialize(AssemblyOutput* self, int tab_width)
 {
+    self->data = NULL;
+    self->count = self->capacity = 0;
+    self->lines = 0;
     self->tab_width = tab_width;
-    AssemblyLineList_Initialize(&self->lines);
 }
 
-inline void AssemblyOutput_Free(AssemblyOutput* self)
+static inline void AssemblyOutput_Free(AssemblyOutput* self)
 {
-    AssemblyLineList_ForEachRef(&self->lines, &AssemblyLine_Free);
-    AssemblyLineList_Free(&self->lines);
+    free(self->data);
+    self->data = NULL;
+    self->count = self->capacity = 0;
 }
 
-void AssemblyOutput_NewLine(AssemblyOutput* self, int indent);
-AssemblyLine* AssemblyOutput_Line(AssemblyOutput* self);
+// Room for at least `size` more characters after `count`.
+void AssemblyOutput_Reserve(AssemblyOutput* self, size_t size);
 void AssemblyOutput_Flush(AssemblyOutput* self, FILE* target);
 
 typedef struct
@@ -45,21 +45,26 @@ typedef struct
     AssemblyOutput output;
 } AssemblyGenerator;
 
-inline void AssemblyGenerator_Initialize(AssemblyGenerator* self)
+static inline void AssemblyGenerator_Initialize(AssemblyGenerator* self)
 {
     self->indent = 0;
     self->tab_width = 4;
     AssemblyOutput_Initialize(&self->output, self->tab_width);
 }
 
-inline void AssemblyGenerator_Free(AssemblyGenerator* self)
+static inline void AssemblyGenerator_Free(AssemblyGenerator* self)
 {
     AssemblyOutput_Free(&self->output);
 }
 
-inline void AssemblyGenerator_End(AssemblyGenerator* self) { self->indent--; }
+static inline void AssemblyGenerator_End(AssemblyGenerator* self) { self->indent--; }
+
+// Starts a line at `indent` and returns where its text goes, with room for `size`
+// characters and a terminator, to be formatted in place. AssemblyGenerator_Commit ends it.
+char* AssemblyGenerator_Reserve(AssemblyGenerator* self, int indent, size_t size);
+void AssemblyGenerator_Commit(AssemblyGenerator* self, size_t length);
 
-AssemblyLine* AssemblyGenerator_WriteIndentV(AssemblyGenerator* self, int indent, const char *fmt, va_list va);
+void AssemblyGenerator_WriteIndentV(AssemblyGenerator* self, int indent, const char *fmt, va_list va);
 void AssemblyGenerator_Write(AssemblyGenerator* self, const char* fmt, ...);
 void AssemblyGenerator_WriteNoIndent(AssemblyGenerator* self, const char* fmt, ...);
 void AssemblyGenerator_Begin(AssemblyGenerator* self, const char* fmt, ...);
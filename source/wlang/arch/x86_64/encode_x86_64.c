@@ -0,0 +1,310 @@
+#include <wlang/arch/x86_64/object_x86_64.h>
+#include <stdio.h>
+
+// Longest an instruction can be.
+#define X86_MAX_LENGTH 15
+
+typedef struct { uint8_t bytes[X86_MAX_LENGTH]; uint8_t length; } X86_Encoding;
+
+static inline bool X86__FitsImm8(long v) { return v >= INT8_MIN && v <= INT8_MAX; }
+static inline bool X86__FitsImm32(long v) { return v >= INT32_MIN && v <= INT32_MAX; }
+
+static inline void X86__Write32(uint8_t* out, int32_t v)
+{
+    for(int i = 0; i < 4; ++i) out[i] = (uint8_t)((uint32_t)v >> (8 * i));
+}
+
+// spl, bpl, sil and dil can only be named with a REX prefix, without one they are ah to bh.
+static inline bool X86__NeedsRex(X86_Operand op)
+{
+    return op.type == X86_OperandType_Reg && op.size == 1 && op.reg >= X86_Reg_Rsp && op.reg <= X86_Reg_Rdi;
+}
+
+// Writes [REX] opcode ModRM [SIB] [disp], with `reg` in the reg field of ModRM, which is
+// a register or an opcode extension, and `rm` the register or memory operand.
+static size_t X86__EncodeRM(uint8_t* out, bool wide, bool rex, const uint8_t* opcode, size_t opcode_length,
+                            int reg, X86_Operand rm)
+{
+    size_t n = 0;
+    uint8_t prefix = 0x40 | (wide << 3) | (((reg >> 3) & 1) << 2) | ((rm.reg >> 3) & 1);
+    if(rm.type == X86_OperandType_Mem && rm.index != X86_REG_NONE) prefix |= ((rm.index >> 3) & 1) << 1;
+    if(prefix != 0x40 || rex) out[n++] = prefix;
+    memcpy(out + n, opcode, opcode_length);
+    n += opcode_length;
+
+    if(rm.type == X86_OperandType_Reg)
+    {
+        out[n++] = (uint8_t)(0xC0 | (reg & 7) << 3 | (rm.reg & 7));
+        return n;
+    }
+
+    // rbp and r13 as a base without displacement would mean rip-relative or no base, so
+    // they get a zero one, and rsp and r12 as a base always need a SIB byte.
+    long disp = rm.value;
+    int mod = disp == 0 && (rm.reg & 7) != X86_Reg_Rbp ? 0 : X86__FitsImm8(disp) ? 1 : 2;
+    bool sib = rm.index != X86_REG_NONE || (rm.reg & 7) == X86_Reg_Rsp;
+    out[n++] = (uint8_t)(mod << 6 | (reg & 7) << 3 | (sib ? 4 : rm.reg & 7));
+    if(sib)
+    {
+        int scale = rm.scale == 8 ? 3 : rm.scale == 4 ? 2 : rm.scale == 2 ? 1 : 0;
+        int index = rm.index == X86_REG_NONE ? 4 : rm.index & 7;
+        out[n++] = (uint8_t)(scale << 6 | index << 3 | (rm.reg & 7));
+    }
+    if(mod == 1) out[n++] = (uint8_t)disp;
+    else if(mod == 2)
+    {
+        X86__Write32(out + n, (int32_t)disp);
+        n += 4;
+    }
+    return n;
+}
+
+#define X86__OPCODE(...) (const uint8_t[]){ __VA_ARGS__ }, sizeof((const uint8_t[]){ __VA_ARGS__ })
+
+// An instruction with only `rm` as an operand and the opcode extension `ext`.
+static size_t X86__EncodeUnary(uint8_t* out, uint8_t opcode, int ext, X86_Operand rm)
+{
+    return X86__EncodeRM(out, rm.size == 8, X86__NeedsRex(rm), X86__OPCODE(opcode), ext, rm);
+}
+
+// An immediate after an instruction, `size` bytes of it.
+static size_t X86__EncodeImm(uint8_t* out, size_t n, long value, int size)
+{
+    if(size == 1) out[n++] = (uint8_t)value;
+    else
+    {
+        X86__Write32(out + n, (int32_t)value);
+        n += 4;
+    }
+    return n;
+}
+
+// add, or, and, sub, xor and cmp share their encodings, which only differ in `ext`.
+static size_t X86__EncodeArith(uint8_t* out, int ext, X86_Operand dst, X86_Operand src)
+{
+    bool wide = dst.size == 8 || (dst.type == X86_OperandType_Mem && src.size == 8);
+    bool byte = dst.size == 1 || src.size == 1;
+    bool rex = X86__NeedsRex(dst) || X86__NeedsRex(src);
+    if(src.type == X86_OperandType_Reg)
+        return X86__EncodeRM(out, wide, rex, X86__OPCODE((uint8_t)(ext * 8 + (byte ? 0 : 1))), src.reg, dst);
+    if(src.type == X86_OperandType_Mem && dst.type == X86_OperandType_Reg)
+        return X86__EncodeRM(out, wide, rex, X86__OPCODE((uint8_t)(ext * 8 + (byte ? 2 : 3))), dst.reg, src);
+    if(src.type != X86_OperandType_Imm || !X86__FitsImm32(src.value)) return 0;
+
+    if(byte) return X86__EncodeImm(out, X86__EncodeRM(out, false, rex, X86__OPCODE(0x80), ext, dst), src.value, 1);
+    if(X86__FitsImm8(src.value))
+        return X86__EncodeImm(out, X86__EncodeRM(out, wide, false, X86__OPCODE(0x83), ext, dst), src.value, 1);
+    // rax has a form of its own without ModRM.
+    if(X86_Operand_IsReg(dst, X86_Reg_Rax))
+    {
+        size_t n = 0;
+        if(wide) out[n++] = 0x48;
+        out[n++] = (uint8_t)(ext * 8 + 5);
+        return X86__EncodeImm(out, n, src.value, 4);
+    }
+    return X86__EncodeImm(out, X86__EncodeRM(out, wide, false, X86__OPCODE(0x81), ext, dst), src.value, 4);
+}
+
+static size_t X86__EncodeMov(uint8_t* out, X86_Operand dst, X86_Operand src)
+{
+    bool wide = dst.size == 8 || (dst.type == X86_OperandType_Mem && src.size == 8);
+    bool byte = dst.size == 1 || src.size == 1;
+    bool rex = X86__NeedsRex(dst) || X86__NeedsRex(src);
+    if(src.type == X86_OperandType_Reg)
+        return X86__EncodeRM(out, wide, rex, X86__OPCODE(byte ? 0x88 : 0x89), src.reg, dst);
+    if(src.type == X86_OperandType_Mem && dst.type == X86_OperandType_Reg)
+        return X86__EncodeRM(out, wide, rex, X86__OPCODE(byte ? 0x8A : 0x8B), dst.reg, src);
+    if(src.type != X86_OperandType_Imm || byte) return 0;
+
+    if(X86__FitsImm32(src.value) && (wide || dst.type == X86_OperandType_Mem))
+        return X86__EncodeImm(out, X86__EncodeRM(out, wide, false, X86__OPCODE(0xC7), 0, dst), src.value, 4);
+    if(dst.type != X86_OperandType_Reg) return 0;
+
+    // mov r, imm with the register in the opcode, with all 64 bits if they are needed.
+    size_t n = 0;
+    if(wide || dst.reg >= X86_Reg_R8) out[n++] = (uint8_t)(0x40 | (wide << 3) | ((dst.reg >> 3) & 1));
+    out[n++] = (uint8_t)(0xB8 + (dst.reg & 7));
+    uint64_t value = (uint64_t)src.value;
+    for(int i = 0; i < (wide ? 8 : 4); ++i) out[n++] = (uint8_t)(value >> (8 * i));
+    return n;
+}
+
+// Push and pop, which have the register in the opcode.
+static size_t X86__EncodeStack(uint8_t* out, uint8_t opcode, X86_Operand reg)
+{
+    if(reg.type != X86_OperandType_Reg) return 0;
+    size_t n = 0;
+    if(reg.reg >= X86_Reg_R8) out[n++] = 0x41;
+    out[n++] = (uint8_t)(opcode + (reg.reg & 7));
+    return n;
+}
+
+// Encodes anything but labels, jumps and calls. Returns 0 for an instruction it has no
+// encoding for.
+static size_t X86__Encode(const X86_Instr* in, uint8_t* out)
+{
+    X86_Operand dst = in->dst, src = in->src;
+    switch(in->op)
+    {
+    case X86_Op_Mov: return X86__EncodeMov(out, dst, src);
+    case X86_Op_Movzx:
+        if(dst.type != X86_OperandType_Reg || src.size != 1) return 0;
+        return X86__EncodeRM(out, dst.size == 8, X86__NeedsRex(src), X86__OPCODE(0x0F, 0xB6), dst.reg, src);
+    case X86_Op_Lea:
+        if(dst.type != X86_OperandType_Reg || src.type != X86_OperandType_Mem) return 0;
+        return X86__EncodeRM(out, dst.size == 8, false, X86__OPCODE(0x8D), dst.reg, src);
+    case X86_Op_Add: return X86__EncodeArith(out, 0, dst, src);
+    case X86_Op_Or: return X86__EncodeArith(out, 1, dst, src);
+    case X86_Op_And: return X86__EncodeArith(out, 4, dst, src);
+    case X86_Op_Sub: return X86__EncodeArith(out, 5, dst, src);
+    case X86_Op_Xor: return X86__EncodeArith(out, 6, dst, src);
+    case X86_Op_Cmp: return X86__EncodeArith(out, 7, dst, src);
+    case X86_Op_Test:
+        if(src.type != X86_OperandType_Reg) return 0;
+        return X86__EncodeRM(out, src.size == 8, X86__NeedsRex(dst) || X86__NeedsRex(src),
+                             X86__OPCODE(src.size == 1 ? 0x84 : 0x85), src.reg, dst);
+    case X86_Op_Imul:
+        if(dst.type != X86_OperandType_Reg) return 0;
+        if(src.type != X86_OperandType_Imm)
+            return X86__EncodeRM(out, dst.size == 8, false, X86__OPCODE(0x0F, 0xAF), dst.reg, src);
+        if(X86__FitsImm8(src.value))
+            return X86__EncodeImm(out, X86__EncodeRM(out, dst.size == 8, false, X86__OPCODE(0x6B), dst.reg, dst), src.value, 1);
+        if(!X86__FitsImm32(src.value)) return 0;
+        return X86__EncodeImm(out, X86__EncodeRM(out, dst.size == 8, false, X86__OPCODE(0x69), dst.reg, dst), src.value, 4);
+    case X86_Op_Not: return X86__EncodeUnary(out, 0xF7, 2, dst);
+    case X86_Op_Neg: return X86__EncodeUnary(out, 0xF7, 3, dst);
+    case X86_Op_Idiv: return X86__EncodeUnary(out, 0xF7, 7, dst);
+    case X86_Op_Inc: return X86__EncodeUnary(out, 0xFF, 0, dst);
+    case X86_Op_Dec: return X86__EncodeUnary(out, 0xFF, 1, dst);
+    case X86_Op_Shl:
+    case X86_Op_Sar:
+    {
+        int ext = in->op == X86_Op_Shl ? 4 : 7;
+        if(src.type != X86_OperandType_Imm) return 0;
+        if(src.value == 1) return X86__EncodeUnary(out, 0xD1, ext, dst);
+        return X86__EncodeImm(out, X86__EncodeUnary(out, 0xC1, ext, dst), src.value, 1);
+    }
+    case X86_Op_Cqo: out[0] = 0x48; out[1] = 0x99; return 2;
+    case X86_Op_Setcc:
+        return X86__EncodeRM(out, false, X86__NeedsRex(dst), X86__OPCODE(0x0F, (uint8_t)(0x90 + in->cond)), 0, dst);
+    case X86_Op_Ret: out[0] = 0xC3; return 1;
+    case X86_Op_Push: return X86__EncodeStack(out, 0x50, dst);
+    case X86_Op_Pop: return X86__EncodeStack(out, 0x58, dst);
+    case X86_Op_Syscall: out[0] = 0x0F; out[1] = 0x05; return 2;
+    default: return 0;
+    }
+}
+
+// Lengths of jumps in their short (rel8) and near (rel32) forms.
+static inline size_t X86__JumpLength(const X86_Instr* in, bool near)
+{
+    if(!near) return 2;
+    return in->op == X86_Op_Jmp ? 5 : 6;
+}
+
+void X86_Object_AddProc(X86_Object* self, Symbol name, const X86_Instr* code, size_t count,
+                        size_t label_count, Arena* scratch)
+{
+    X86_Encoding* encodings = ARENA_ARRAY(scratch, X86_Encoding, count);
+    size_t* offsets = ARENA_ARRAY(scratch, size_t, count + 1);
+    size_t* labels = ARENA_ARRAY(scratch, size_t, label_count + 1);
+    bool* near = ARENA_ARRAY(scratch, bool, count);
+    memset(near, 0, sizeof(bool) * count);
+    for(size_t b = 0; b < label_count; ++b) labels[b] = SIZE_MAX;
+    for(size_t i = 0; i < count; ++i)
+        if(code[i].op == X86_Op_Label && code[i].dst.value >= 0 && (size_t)code[i].dst.value < label_count)
+            labels[code[i].dst.value] = 0;
+
+    size_t errors = self->errors;
+    for(size_t i = 0; i < count; ++i)
+    {
+        const X86_Instr* in = &code[i];
+        X86_Encoding* e = &encodings[i];
+        e->length = 0;
+        if(in->op == X86_Op_Nop) continue;
+        if(in->op == X86_Op_Label || X86_Instr_IsJump(in))
+        {
+            long label = in->dst.value;
+            if(in->dst.type == X86_OperandType_Label && label >= 0 && (size_t)label < label_count && labels[label] != SIZE_MAX) continue;
+        }
+        else if(in->op == X86_Op_Call)
+        {
+            if(in->dst.type == X86_OperandType_Symbol) continue;
+        }
+        else if((e->length = (uint8_t)X86__Encode(in, e->bytes))) continue;
+
+        char line[128];
+        X86_Instr_Format(in, Symbol_Name(name), line, sizeof(line));
+        fprintf(stderr, "\033[0;31mError:\033[0;0m No encoding for '%s' in '%s'.\n", line, Symbol_Name(name));
+        self->errors++;
+    }
+    if(self->errors != errors) return;
+
+    // Jumps only ever grow, so this ends once none of them has to.
+    for(bool grew = true; grew;)
+    {
+        grew = false;
+        size_t offset = 0;
+        for(size_t i = 0; i < count; ++i)
+        {
+            const X86_Instr* in = &code[i];
+            offsets[i] = offset;
+            if(in->op == X86_Op_Label) labels[in->dst.value] = offset;
+            else if(X86_Instr_IsJump(in)) offset += X86__JumpLength(in, near[i]);
+            else if(in->op == X86_Op_Call) offset += 5;
+            else offset += encodings[i].length;
+        }
+        offsets[count] = offset;
+
+        for(size_t i = 0; i < count; ++i)
+        {
+            if(!X86_Instr_IsJump(&code[i]) || near[i]) continue;
+            long distance = (long)labels[code[i].dst.value] - (long)(offsets[i] + 2);
+            if(X86__FitsImm8(distance)) continue;
+            near[i] = true;
+            grew = true;
+        }
+    }
+
+    X86_ObjectSymbol* symbol = X86_Object_Symbol(self, name);
+    symbol->defined = true;
+    symbol->offset = self->text.count;
+    symbol->size = offsets[count];
+
+    size_t base = self->text.count;
+    X86_ByteList_Reserve(&self->text, base + offsets[count]);
+    for(size_t i = 0; i < count; ++i)
+    {
+        const X86_Instr* in = &code[i];
+        uint8_t bytes[X86_MAX_LENGTH];
+        size_t n = 0;
+        if(X86_Instr_IsJump(in))
+        {
+            size_t length = X86__JumpLength(in, near[i]);
+            int32_t distance = (int32_t)((long)labels[in->dst.value] - (long)(offsets[i] + length));
+            if(near[i] && in->op == X86_Op_Jcc) { bytes[n++] = 0x0F; bytes[n++] = (uint8_t)(0x80 + in->cond); }
+            else if(near[i]) bytes[n++] = 0xE9;
+            else bytes[n++] = in->op == X86_Op_Jmp ? 0xEB : (uint8_t)(0x70 + in->cond);
+            if(near[i])
+            {
+                X86__Write32(bytes + n, distance);
+                n += 4;
+            }
+            else bytes[n++] = (uint8_t)distance;
+        }
+        else if(in->op == X86_Op_Call)
+        {
+            bytes[n++] = 0xE8;
+            X86__Write32(bytes + n, 0);
+            n += 4;
+            X86_Object_Symbol(self, (Symbol)in->dst.value);
+            X86_RelocList_PushValue(&self->relocs, (X86_Reloc){ .offset = base + offsets[i] + 1, .symbol = (Symbol)in->dst.value });
+        }
+        else
+        {
+            memcpy(bytes, encodings[i].bytes, encodings[i].length);
+            n = encodings[i].length;
+        }
+        X86_ByteList_Append(&self->text, bytes, n);
+    }
+}
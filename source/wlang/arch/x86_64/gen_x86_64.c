@@ -1,7 +1,718 @@
 #include <wlang/arch/x86_64/arch.h>
-#include <wlang/ir.h>
+#include <wlang/arch/x86_64/gen_x86_64.h>
+#include <limits.h>
+#include <stdint.h>
+#include <string.h>
 
+DEFINE_LIST_TYPE(X86_Home)
+
+static const X86_Reg Generator_x86_64__arg_regs[] = {
+    X86_Reg_Rdi, X86_Reg_Rsi, X86_Reg_Rdx, X86_Reg_Rcx, X86_Reg_R8, X86_Reg_R9,
+};
+#define X86_ARG_REG_COUNT (sizeof(Generator_x86_64__arg_regs) / sizeof(Generator_x86_64__arg_regs[0]))
+
+void Generator_x86_64_Initialize(Generator_x86_64* self)
+{
+    AssemblyGenerator_Initialize(&self->gen);
+    X86_InstrList_Initialize(&self->code);
+    X86_HomeList_Initialize(&self->homes);
+    self->text = true;
+    self->object = NULL;
+    self->optimize = false;
+    self->proc = NULL;
+    self->uses = NULL;
+    self->fused = NULL;
+    self->saved = 0;
+    self->saved_size = 0;
+    self->frame_size = 0;
+}
+
+void Generator_x86_64_Free(Generator_x86_64* self)
+{
+    AssemblyGenerator_Free(&self->gen);
+    X86_InstrList_Free(&self->code);
+    X86_HomeList_Free(&self->homes);
+}
+
+static inline void Generator_x86_64__Emit(Generator_x86_64* self, X86_Op op, X86_Operand dst, X86_Operand src)
+{
+    X86_InstrList_PushValue(&self->code, (X86_Instr){ .op = op, .dst = dst, .src = src });
+}
+
+static inline void Generator_x86_64__EmitCond(Generator_x86_64* self, X86_Op op, X86_Cond cond, X86_Operand dst)
+{
+    X86_InstrList_PushValue(&self->code, (X86_Instr){ .op = op, .cond = cond, .dst = dst, .src = X86_NONE });
+}
+
+static inline bool X86__FitsImm32(long v) { return v >= INT32_MIN && v <= INT32_MAX; }
+
+// The machine register `v` is in, if it is in one.
+static X86_Reg Generator_x86_64__Register(Generator_x86_64* self, IR_Value v)
+{
+    return v.type == IR_ValueType_Reg ? self->homes.data[v.value].reg : X86_REG_NONE;
+}
+
+static bool Generator_x86_64__InMemory(Generator_x86_64* self, IR_Value v)
+{
+    return v.type == IR_ValueType_Slot || (v.type == IR_ValueType_Reg && self->homes.data[v.value].reg == X86_REG_NONE);
+}
+
+static X86_Operand Generator_x86_64__Operand(Generator_x86_64* self, IR_Value v)
+{
+    switch(v.type)
+    {
+    case IR_ValueType_Imm: return X86_IMM(IR_Value_Imm(v));
+    case IR_ValueType_Reg:
+    {
+        const X86_Home* home = &self->homes.data[v.value];
+        return home->reg != X86_REG_NONE ? X86_REG(home->reg) : X86_MEM(X86_Reg_Rsp, (long)self->frame_size - home->offset);
+    }
+    case IR_ValueType_Slot: return X86_MEM(X86_Reg_Rsp, (long)self->frame_size - 8 * (long)(v.value + 1));
+    default: return X86_IMM(0);
+    }
+}
+
+static void Generator_x86_64__Load(Generator_x86_64* self, X86_Reg reg, IR_Value v)
+{
+    if(Generator_x86_64__Register(self, v) == reg) return;
+    Generator_x86_64__Emit(self, X86_Op_Mov, X86_REG(reg), Generator_x86_64__Operand(self, v));
+}
+
+// Source operand of an ALU instruction. Immediates wider than 32 bits go through rcx.
+static X86_Operand Generator_x86_64__Source(Generator_x86_64* self, IR_Value v)
+{
+    if(v.type == IR_ValueType_Imm && !X86__FitsImm32(IR_Value_Imm(v)))
+    {
+        Generator_x86_64__Load(self, X86_Reg_Rcx, v);
+        return X86_REG(X86_Reg_Rcx);
+    }
+    return Generator_x86_64__Operand(self, v);
+}
+
+// Register to compute the result for `dst` in: its own, or rax if it was spilled.
+static X86_Reg Generator_x86_64__Target(Generator_x86_64* self, IR_V dst)
+{
+    X86_Reg reg = dst == IR_NO_REG ? X86_REG_NONE : self->homes.data[dst].reg;
+    return reg == X86_REG_NONE ? X86_Reg_Rax : reg;
+}
+
+static void Generator_x86_64__Save(Generator_x86_64* self, IR_V dst, X86_Reg reg)
+{
+    if(dst == IR_NO_REG || self->homes.data[dst].reg == reg) return;
+    Generator_x86_64__Emit(self, X86_Op_Mov, Generator_x86_64__Operand(self, IR_VALUE_REG(dst)), X86_REG(reg));
+}
+
+// Writes `v` to `to`, which is a register or in memory. Memory to memory goes through rax.
+static void Generator_x86_64__Copy(Generator_x86_64* self, IR_Value to, IR_Value v)
+{
+    X86_Reg reg = Generator_x86_64__Register(self, to);
+    if(reg != X86_REG_NONE) Generator_x86_64__Load(self, reg, v);
+    else if(IR_Value_Equal(to, v)) return;
+    else if(Generator_x86_64__InMemory(self, v) || (v.type == IR_ValueType_Imm && !X86__FitsImm32(IR_Value_Imm(v))))
+    {
+        Generator_x86_64__Load(self, X86_Reg_Rax, v);
+        Generator_x86_64__Emit(self, X86_Op_Mov, Generator_x86_64__Operand(self, to), X86_REG(X86_Reg_Rax));
+    }
+    else Generator_x86_64__Emit(self, X86_Op_Mov, Generator_x86_64__Operand(self, to), Generator_x86_64__Operand(self, v));
+}
+
+// A move of a parallel copy: to register `dst`, or to the home of `home` if that is none.
+// The source is register `src`, or `value` if that is none.
+typedef struct { X86_Reg dst; IR_V home; X86_Reg src; IR_Value value; } X86_Move;
+
+// Does the moves as if at once: a move can go when no other pending one still reads its
+// destination. When only cycles are left, the destination of one is saved to rax first.
+static void Generator_x86_64__ParallelMove(Generator_x86_64* self, X86_Move* moves, size_t count)
+{
+    while(count)
+    {
+        bool progress = false;
+        for(size_t i = 0; i < count; ++i)
+        {
+            bool read = false;
+            for(size_t j = 0; j < count && !read; ++j)
+                read = j != i && moves[i].dst != X86_REG_NONE && moves[j].src == moves[i].dst;
+            if(read) continue;
+
+            X86_Move m = moves[i];
+            moves[i--] = moves[--count];
+            progress = true;
+            if(m.src != X86_REG_NONE && m.src == m.dst) continue;
+            X86_Operand dst = m.dst != X86_REG_NONE ? X86_REG(m.dst) : Generator_x86_64__Operand(self, IR_VALUE_REG(m.home));
+            X86_Operand src = m.src != X86_REG_NONE ? X86_REG(m.src) : Generator_x86_64__Operand(self, m.value);
+            Generator_x86_64__Emit(self, X86_Op_Mov, dst, src);
+        }
+        if(progress) continue;
+
+        X86_Reg cycle = moves[0].dst;
+        Generator_x86_64__Emit(self, X86_Op_Mov, X86_REG(X86_Reg_Rax), X86_REG(cycle));
+        for(size_t j = 0; j < count; ++j)
+            if(moves[j].src == cycle) moves[j].src = X86_Reg_Rax;
+    }
+}
+
+// Passes the arguments collected since the last call in their registers.
+static void Generator_x86_64__PassArgs(Generator_x86_64* self, const IR_Instr* args, size_t count)
+{
+    X86_Move moves[X86_ARG_REG_COUNT];
+    size_t move_count = 0;
+    for(size_t i = 0; i < count; ++i)
+    {
+        // Passing arguments on the stack isn't supported, the compiler warns about it.
+        if(args[i].label >= X86_ARG_REG_COUNT) continue;
+        X86_Reg src = Generator_x86_64__Register(self, args[i].lhs);
+        moves[move_count++] = (X86_Move){ Generator_x86_64__arg_regs[args[i].label], IR_NO_REG, src, args[i].lhs };
+    }
+    Generator_x86_64__ParallelMove(self, moves, move_count);
+}
+
+// Moves the parameters to their homes. The first six come in registers, the rest above
+// the return address, past the frame and the saved registers.
+static void Generator_x86_64__TakeParams(Generator_x86_64* self, const IR_Instr* params, size_t count)
+{
+    X86_Move moves[X86_ARG_REG_COUNT];
+    size_t move_count = 0;
+    for(size_t i = 0; i < count; ++i)
+    {
+        if(params[i].label >= X86_ARG_REG_COUNT || !X86_Home_IsUsed(&self->homes.data[params[i].dst])) continue;
+        moves[move_count++] = (X86_Move){
+            self->homes.data[params[i].dst].reg, params[i].dst,
+            Generator_x86_64__arg_regs[params[i].label], IR_VALUE_NONE
+        };
+    }
+    Generator_x86_64__ParallelMove(self, moves, move_count);
+
+    for(size_t i = 0; i < count; ++i)
+    {
+        if(params[i].label < X86_ARG_REG_COUNT || !X86_Home_IsUsed(&self->homes.data[params[i].dst])) continue;
+        X86_Reg reg = Generator_x86_64__Target(self, params[i].dst);
+        Generator_x86_64__Emit(self, X86_Op_Mov, X86_REG(reg),
+                               X86_MEM(X86_Reg_Rsp, (long)(self->frame_size + self->saved_size + 8
+                                                           + 8 * (params[i].label - X86_ARG_REG_COUNT))));
+        Generator_x86_64__Save(self, params[i].dst, reg);
+    }
+}
+
+// There is no frame pointer, rsp stays where the prologue put it for the whole procedure.
+static void Generator_x86_64__Prologue(Generator_x86_64* self)
+{
+    for(int r = 0; r < X86_Reg__Count; ++r)
+        if(self->saved & X86_REG_BIT(r)) Generator_x86_64__Emit(self, X86_Op_Push, X86_REG(r), X86_NONE);
+    if(self->frame_size) Generator_x86_64__Emit(self, X86_Op_Sub, X86_REG(X86_Reg_Rsp), X86_IMM(self->frame_size));
+}
+
+static void Generator_x86_64__Epilogue(Generator_x86_64* self)
+{
+    if(self->frame_size) Generator_x86_64__Emit(self, X86_Op_Add, X86_REG(X86_Reg_Rsp), X86_IMM(self->frame_size));
+    for(int r = X86_Reg__Count; r --> 0;)
+        if(self->saved & X86_REG_BIT(r)) Generator_x86_64__Emit(self, X86_Op_Pop, X86_REG(r), X86_NONE);
+    Generator_x86_64__Emit(self, X86_Op_Ret, X86_NONE, X86_NONE);
+}
+
+// Jumps from the end of `block` to `target`, unless that is where it falls through anyway.
+static void Generator_x86_64__Goto(Generator_x86_64* self, size_t target, size_t block)
+{
+    if(target != block + 1) Generator_x86_64__Emit(self, X86_Op_Jmp, X86_LABEL(target), X86_NONE);
+}
+
+static X86_Cond X86__Condition(enum IR_OpType op)
+{
+    switch(op)
+    {
+    case IR_OpType_Eql: return X86_Cond_E;
+    case IR_OpType_Neq: return X86_Cond_NE;
+    case IR_OpType_Grt: return X86_Cond_G;
+    case IR_OpType_Lst: return X86_Cond_L;
+    case IR_OpType_Geq: return X86_Cond_GE;
+    default: return X86_Cond_LE;
+    }
+}
+
+static inline bool IR__IsCompare(enum IR_OpType op) { return op >= IR_OpType_Eql && op <= IR_OpType_Leq; }
+
+// Compares the operands of `in` and returns the condition that holds if it is true.
+static X86_Cond Generator_x86_64__Compare(Generator_x86_64* self, const IR_Instr* in)
+{
+    // cmp takes an immediate only on the right, so `imm < x` is done as `x > imm`.
+    if(in->lhs.type == IR_ValueType_Imm && in->rhs.type != IR_ValueType_Imm)
+    {
+        X86_Operand lhs = Generator_x86_64__Operand(self, in->rhs);
+        X86_Operand rhs = Generator_x86_64__Source(self, in->lhs);
+        Generator_x86_64__Emit(self, X86_Op_Cmp, lhs, rhs);
+        return X86_Cond_Swap(X86__Condition(in->type));
+    }
+
+    X86_Operand lhs = Generator_x86_64__Operand(self, in->lhs);
+    if(in->lhs.type == IR_ValueType_Imm || (Generator_x86_64__InMemory(self, in->lhs) && Generator_x86_64__InMemory(self, in->rhs)))
+    {
+        Generator_x86_64__Load(self, X86_Reg_Rax, in->lhs);
+        lhs = X86_REG(X86_Reg_Rax);
+    }
+    X86_Operand rhs = Generator_x86_64__Source(self, in->rhs);
+    Generator_x86_64__Emit(self, X86_Op_Cmp, lhs, rhs);
+    return X86__Condition(in->type);
+}
+
+// Ends `block` with the branch `br`, which goes to its `label` if `cond` holds.
+static void Generator_x86_64__Branch(Generator_x86_64* self, X86_Cond cond, const IR_Instr* br, size_t block)
+{
+    if(br->label == block + 1) Generator_x86_64__EmitCond(self, X86_Op_Jcc, X86_Cond_Negate(cond), X86_LABEL(br->label_else));
+    else
+    {
+        Generator_x86_64__EmitCond(self, X86_Op_Jcc, cond, X86_LABEL(br->label));
+        Generator_x86_64__Goto(self, br->label_else, block);
+    }
+}
+
+// The branch that is the only reader of the comparison `instrs->data[i]`, if it comes
+// later in the block with nothing but copies in between, which leave the flags alone.
+static const IR_Instr* Generator_x86_64__FusedBranch(Generator_x86_64* self, const IR_InstrList* instrs, size_t i)
+{
+    IR_V dst = instrs->data[i].dst;
+    if(self->uses[dst] != 1) return NULL;
+    for(size_t j = i + 1; j < instrs->count; ++j)
+    {
+        const IR_Instr* in = &instrs->data[j];
+        if(in->type == IR_OpType_Br) return in->lhs.type == IR_ValueType_Reg && in->lhs.value == dst ? in : NULL;
+        if(in->type != IR_OpType_Mov) return NULL;
+    }
+    return NULL;
+}
+
+// Sets `dst` to 1 if `cond` holds after the flags were set and to 0 otherwise.
+static void Generator_x86_64__SetFlag(Generator_x86_64* self, X86_Cond cond, X86_Reg dst)
+{
+    Generator_x86_64__EmitCond(self, X86_Op_Setcc, cond, X86_REG_SIZED(dst, 1));
+    Generator_x86_64__Emit(self, X86_Op_Movzx, X86_REG_SIZED(dst, 4), X86_REG_SIZED(dst, 1));
+}
+
+static void Generator_x86_64__EmitInstr(Generator_x86_64* self, const IR_Instr* in, size_t block)
+{
+    switch(in->type)
+    {
+    case IR_OpType_Add:
+    case IR_OpType_Sub:
+    case IR_OpType_Mul:
+    case IR_OpType_Bnd:
+    case IR_OpType_Bor:
+    case IR_OpType_Xor:
+    {
+        static const X86_Op ops[] = {
+            [IR_OpType_Add] = X86_Op_Add, [IR_OpType_Sub] = X86_Op_Sub, [IR_OpType_Mul] = X86_Op_Imul,
+            [IR_OpType_Bnd] = X86_Op_And, [IR_OpType_Bor] = X86_Op_Or, [IR_OpType_Xor] = X86_Op_Xor,
+        };
+        IR_Value lhs = in->lhs, rhs = in->rhs;
+        X86_Reg dst = Generator_x86_64__Target(self, in->dst);
+        // Loading the left operand would overwrite the right one, which can only swap
+        // places with it if the op is commutative.
+        if(Generator_x86_64__Register(self, rhs) == dst && Generator_x86_64__Register(self, lhs) != dst)
+        {
+            if(in->type == IR_OpType_Sub) dst = X86_Reg_Rax;
+            else
+            {
+                rhs = in->lhs;
+                lhs = in->rhs;
+            }
+        }
+        Generator_x86_64__Load(self, dst, lhs);
+        X86_Operand src = Generator_x86_64__Source(self, rhs);
+        Generator_x86_64__Emit(self, ops[in->type], X86_REG(dst), src);
+        Generator_x86_64__Save(self, in->dst, dst);
+    } break;
+    case IR_OpType_Div:
+    case IR_OpType_Mod:
+    {
+        Generator_x86_64__Load(self, X86_Reg_Rax, in->lhs);
+        X86_Operand divisor = X86_REG(X86_Reg_Rcx);
+        if(in->rhs.type == IR_ValueType_Imm) Generator_x86_64__Load(self, X86_Reg_Rcx, in->rhs);
+        else divisor = Generator_x86_64__Operand(self, in->rhs);
+        Generator_x86_64__Emit(self, X86_Op_Cqo, X86_NONE, X86_NONE);
+        Generator_x86_64__Emit(self, X86_Op_Idiv, divisor, X86_NONE);
+        Generator_x86_64__Save(self, in->dst, in->type == IR_OpType_Div ? X86_Reg_Rax : X86_Reg_Rdx);
+    } break;
+    case IR_OpType_Eql:
+    case IR_OpType_Neq:
+    case IR_OpType_Grt:
+    case IR_OpType_Lst:
+    case IR_OpType_Geq:
+    case IR_OpType_Leq:
+    {
+        X86_Reg dst = Generator_x86_64__Target(self, in->dst);
+        Generator_x86_64__SetFlag(self, Generator_x86_64__Compare(self, in), dst);
+        Generator_x86_64__Save(self, in->dst, dst);
+    } break;
+    case IR_OpType_And:
+    case IR_OpType_Cor:
+    {
+        Generator_x86_64__Load(self, X86_Reg_Rax, in->lhs);
+        Generator_x86_64__Load(self, X86_Reg_Rcx, in->rhs);
+        Generator_x86_64__Emit(self, X86_Op_Test, X86_REG(X86_Reg_Rax), X86_REG(X86_Reg_Rax));
+        Generator_x86_64__EmitCond(self, X86_Op_Setcc, X86_Cond_NE, X86_REG_SIZED(X86_Reg_Rax, 1));
+        Generator_x86_64__Emit(self, X86_Op_Test, X86_REG(X86_Reg_Rcx), X86_REG(X86_Reg_Rcx));
+        Generator_x86_64__EmitCond(self, X86_Op_Setcc, X86_Cond_NE, X86_REG_SIZED(X86_Reg_Rcx, 1));
+        Generator_x86_64__Emit(self, in->type == IR_OpType_And ? X86_Op_And : X86_Op_Or,
+                               X86_REG_SIZED(X86_Reg_Rax, 1), X86_REG_SIZED(X86_Reg_Rcx, 1));
+        Generator_x86_64__Emit(self, X86_Op_Movzx, X86_REG_SIZED(X86_Reg_Rax, 4), X86_REG_SIZED(X86_Reg_Rax, 1));
+        Generator_x86_64__Save(self, in->dst, X86_Reg_Rax);
+    } break;
+    case IR_OpType_Neg:
+    case IR_OpType_Bno:
+    {
+        X86_Reg dst = Generator_x86_64__Target(self, in->dst);
+        Generator_x86_64__Load(self, dst, in->lhs);
+        Generator_x86_64__Emit(self, in->type == IR_OpType_Neg ? X86_Op_Neg : X86_Op_Not, X86_REG(dst), X86_NONE);
+        Generator_x86_64__Save(self, in->dst, dst);
+    } break;
+    case IR_OpType_Not:
+    {
+        X86_Reg dst = Generator_x86_64__Target(self, in->dst);
+        Generator_x86_64__Load(self, X86_Reg_Rax, in->lhs);
+        Generator_x86_64__Emit(self, X86_Op_Test, X86_REG(X86_Reg_Rax), X86_REG(X86_Reg_Rax));
+        Generator_x86_64__SetFlag(self, X86_Cond_E, dst);
+        Generator_x86_64__Save(self, in->dst, dst);
+    } break;
+    case IR_OpType_Mov:
+    case IR_OpType_Load:
+    {
+        Generator_x86_64__Copy(self, IR_VALUE_REG(in->dst), in->lhs);
+    } break;
+    case IR_OpType_Store:
+    {
+        Generator_x86_64__Copy(self, in->lhs, in->rhs);
+    } break;
+    case IR_OpType_Param:
+    case IR_OpType_Arg: break; // Done a whole run at a time, see Generator_x86_64__EmitBlock.
+    case IR_OpType_Call:
+    {
+        Generator_x86_64__Emit(self, X86_Op_Call, X86_SYMBOL(in->label), X86_NONE);
+        Generator_x86_64__Save(self, in->dst, X86_Reg_Rax);
+    } break;
+    case IR_OpType_Jmp:
+    {
+        Generator_x86_64__Goto(self, in->label, block);
+    } break;
+    case IR_OpType_Br:
+    {
+        if(in->lhs.type == IR_ValueType_Imm)
+        {
+            Generator_x86_64__Goto(self, IR_Value_Imm(in->lhs) ? in->label : in->label_else, block);
+            break;
+        }
+        X86_Reg cond = Generator_x86_64__Register(self, in->lhs);
+        if(cond != X86_REG_NONE) Generator_x86_64__Emit(self, X86_Op_Test, X86_REG(cond), X86_REG(cond));
+        else Generator_x86_64__Emit(self, X86_Op_Cmp, Generator_x86_64__Operand(self, in->lhs), X86_IMM(0));
+        Generator_x86_64__Branch(self, X86_Cond_NE, in, block);
+    } break;
+    case IR_OpType_Ret:
+    {
+        if(in->lhs.type != IR_ValueType_None) Generator_x86_64__Load(self, X86_Reg_Rax, in->lhs);
+        Generator_x86_64__Epilogue(self);
+    } break;
+    default: break;
+    }
+}
+
+// log2 of `v` if it is a power of two from 2 up, 0 otherwise.
+static int X86__Shift(long v)
+{
+    if(v < 2 || (v & (v - 1))) return 0;
+    int shift = 0;
+    while(v >>= 1) ++shift;
+    return shift;
+}
+
+// The register `v` is in, or `scratch` after loading it there.
+static X86_Reg Generator_x86_64__InRegister(Generator_x86_64* self, IR_Value v, X86_Reg scratch)
+{
+    X86_Reg reg = Generator_x86_64__Register(self, v);
+    if(reg != X86_REG_NONE) return reg;
+    Generator_x86_64__Load(self, scratch, v);
+    return scratch;
+}
+
+// Splits `in` into its operand that isn't an immediate and the other one, if that is an
+// immediate. For a commutative op that can be on either side.
+static bool IR__SplitImm(const IR_Instr* in, IR_Value* value, long* imm)
+{
+    bool commutes = in->type == IR_OpType_Add || in->type == IR_OpType_Mul;
+    if(in->rhs.type == IR_ValueType_Imm && in->lhs.type != IR_ValueType_Imm)
+    {
+        *value = in->lhs;
+        *imm = IR_Value_Imm(in->rhs);
+        return true;
+    }
+    if(commutes && in->lhs.type == IR_ValueType_Imm && in->rhs.type != IR_ValueType_Imm)
+    {
+        *value = in->rhs;
+        *imm = IR_Value_Imm(in->lhs);
+        return true;
+    }
+    return false;
+}
+
+// t = x * 2^k; d = y + t -> lea d, [y + x * 2^k], when t has no other reader.
+static size_t Generator_x86_64__SelectIndex(Generator_x86_64* self, const IR_Instr* in, size_t left)
+{
+    IR_Value x; long scale;
+    if(in->type != IR_OpType_Mul || left < 2 || !IR__SplitImm(in, &x, &scale)) return 0;
+    if((scale != 2 && scale != 4 && scale != 8) || self->uses[in->dst] != 1) return 0;
+    const IR_Instr* add = in + 1;
+    if(add->type != IR_OpType_Add) return 0;
+    IR_Value t = IR_VALUE_REG(in->dst), y;
+    if(IR_Value_Equal(add->rhs, t)) y = add->lhs;
+    else if(IR_Value_Equal(add->lhs, t)) y = add->rhs;
+    else return 0;
+    if(y.type == IR_ValueType_Imm) return 0;
+
+    X86_Reg dst = Generator_x86_64__Target(self, add->dst);
+    X86_Reg base = Generator_x86_64__InRegister(self, y, X86_Reg_Rax);
+    X86_Reg index = Generator_x86_64__InRegister(self, x, X86_Reg_Rcx);
+    Generator_x86_64__Emit(self, X86_Op_Lea, X86_REG(dst), X86_ADDR(base, index, scale, 0));
+    Generator_x86_64__Save(self, add->dst, dst);
+    return 2;
+}
+
+// d = x * 3, 5 or 9 -> lea d, [x + x * 2, 4 or 8]
+static size_t Generator_x86_64__SelectScale(Generator_x86_64* self, const IR_Instr* in, size_t left)
+{
+    IR_Value x; long factor;
+    if(in->type != IR_OpType_Mul || !IR__SplitImm(in, &x, &factor)) return 0;
+    if(factor != 3 && factor != 5 && factor != 9) return 0;
+    X86_Reg dst = Generator_x86_64__Target(self, in->dst);
+    X86_Reg reg = Generator_x86_64__InRegister(self, x, dst);
+    Generator_x86_64__Emit(self, X86_Op_Lea, X86_REG(dst), X86_ADDR(reg, reg, factor - 1, 0));
+    Generator_x86_64__Save(self, in->dst, dst);
+    return 1;
+}
+
+// d = x * 2^k -> shl d, k
+static size_t Generator_x86_64__SelectShift(Generator_x86_64* self, const IR_Instr* in, size_t left)
+{
+    IR_Value x; long factor;
+    if(in->type != IR_OpType_Mul || !IR__SplitImm(in, &x, &factor) || !X86__Shift(factor)) return 0;
+    X86_Reg dst = Generator_x86_64__Target(self, in->dst);
+    Generator_x86_64__Load(self, dst, x);
+    Generator_x86_64__Emit(self, X86_Op_Shl, X86_REG(dst), X86_IMM(X86__Shift(factor)));
+    Generator_x86_64__Save(self, in->dst, dst);
+    return 1;
+}
+
+// Splits an add or sub of an immediate into x + imm. There is no such imm for
+// x - LONG_MIN, which doesn't negate.
+static bool IR__SplitAddend(const IR_Instr* in, IR_Value* value, long* imm)
+{
+    if((in->type != IR_OpType_Add && in->type != IR_OpType_Sub) || !IR__SplitImm(in, value, imm)) return false;
+    if(in->type == IR_OpType_Add) return true;
+    if(*imm == LONG_MIN) return false;
+    *imm = -*imm;
+    return true;
+}
+
+// d = x + 1 -> inc d, and the same for dec, when x isn't in a register that d could be
+// computed from with a lea instead.
+static size_t Generator_x86_64__SelectIncDec(Generator_x86_64* self, const IR_Instr* in, size_t left)
+{
+    IR_Value x; long imm;
+    if(!IR__SplitAddend(in, &x, &imm) || (imm != 1 && imm != -1)) return 0;
+    X86_Reg dst = Generator_x86_64__Target(self, in->dst), reg = Generator_x86_64__Register(self, x);
+    if(reg != X86_REG_NONE && reg != dst) return 0;
+    Generator_x86_64__Load(self, dst, x);
+    Generator_x86_64__Emit(self, imm == 1 ? X86_Op_Inc : X86_Op_Dec, X86_REG(dst), X86_NONE);
+    Generator_x86_64__Save(self, in->dst, dst);
+    return 1;
+}
+
+// d = x + y -> lea d, [x + y] and d = x +- imm -> lea d, [x +- imm], when x and y are in
+// registers other than d's, which saves copying one of them to d first.
+static size_t Generator_x86_64__SelectAdd(Generator_x86_64* self, const IR_Instr* in, size_t left)
+{
+    if(in->type != IR_OpType_Add && in->type != IR_OpType_Sub) return 0;
+    X86_Reg dst = Generator_x86_64__Target(self, in->dst);
+    X86_Operand address;
+    IR_Value x; long imm;
+    if(IR__SplitAddend(in, &x, &imm))
+    {
+        X86_Reg reg = Generator_x86_64__Register(self, x);
+        if(reg == X86_REG_NONE || reg == dst || !X86__FitsImm32(imm)) return 0;
+        address = X86_ADDR(reg, X86_REG_NONE, 1, imm);
+    }
+    else
+    {
+        X86_Reg a = Generator_x86_64__Register(self, in->lhs), b = Generator_x86_64__Register(self, in->rhs);
+        if(in->type != IR_OpType_Add || a == X86_REG_NONE || b == X86_REG_NONE || a == dst || b == dst) return 0;
+        address = X86_ADDR(a, b, 1, 0);
+    }
+    Generator_x86_64__Emit(self, X86_Op_Lea, X86_REG(dst), address);
+    Generator_x86_64__Save(self, in->dst, dst);
+    return 1;
+}
+
+// An instruction selection pattern gets the IR instruction to emit and how many are left
+// in its block, counting itself. It returns how many it emitted, 0 if it doesn't match.
 typedef struct
 {
+    const char* name;
+    size_t (*select)(Generator_x86_64* self, const IR_Instr* in, size_t left);
+} X86_SelectPattern;
+
+// Tried in order, anything that none of them matches is emitted by
+// Generator_x86_64__EmitInstr with both operands in general form.
+static const X86_SelectPattern Generator_x86_64__patterns[] =
+{
+    { "lea-index",          Generator_x86_64__SelectIndex },
+    { "lea-scale",          Generator_x86_64__SelectScale },
+    { "shl",                Generator_x86_64__SelectShift },
+    { "inc-dec",            Generator_x86_64__SelectIncDec },
+    { "lea-add",            Generator_x86_64__SelectAdd },
+};
+#define X86_SELECT_PATTERN_COUNT (sizeof(Generator_x86_64__patterns) / sizeof(Generator_x86_64__patterns[0]))
+
+static size_t Generator_x86_64__pattern_counts[X86_SELECT_PATTERN_COUNT];
+
+// Emits `instrs->data[i]` and maybe some that follow with the first pattern that matches.
+// Returns how many it emitted.
+static size_t Generator_x86_64__Select(Generator_x86_64* self, const IR_InstrList* instrs, size_t i)
+{
+    if(!self->optimize) return 0;
+    const IR_Instr* in = &instrs->data[i];
+    if(in->dst == IR_NO_REG) return 0;
+    for(size_t p = 0; p < X86_SELECT_PATTERN_COUNT; ++p)
+    {
+        size_t count = Generator_x86_64__patterns[p].select(self, in, instrs->count - i);
+        if(!count) continue;
+        Generator_x86_64__pattern_counts[p]++;
+        return count;
+    }
+    return 0;
+}
+
+void Generator_x86_64_PrintStats(FILE* f)
+{
+    size_t total = 0;
+    fprintf(f, "Instruction selection:\n");
+    for(size_t p = 0; p < X86_SELECT_PATTERN_COUNT; ++p)
+    {
+        fprintf(f, "  %-18s %10zu\n", Generator_x86_64__patterns[p].name, Generator_x86_64__pattern_counts[p]);
+        total += Generator_x86_64__pattern_counts[p];
+    }
+    fprintf(f, "  %-18s %10zu\n", "total", total);
+}
+
+static void Generator_x86_64__EmitBlock(Generator_x86_64* self, size_t block)
+{
+    const IR_InstrList* instrs = &self->proc->blocks.data[block].instrs;
+    for(size_t i = 0; i < instrs->count; ++i)
+    {
+        // Parameters and arguments are moved in and out of their registers all at once,
+        // as the values can be in each other's registers. Arguments go right before
+        // their call, with nothing in between.
+        const IR_Instr* in = &instrs->data[i];
+        if(in->type == IR_OpType_Param || in->type == IR_OpType_Arg)
+        {
+            size_t count = 1;
+            while(i + count < instrs->count && instrs->data[i + count].type == in->type) ++count;
+            if(in->type == IR_OpType_Param) Generator_x86_64__TakeParams(self, in, count);
+            else Generator_x86_64__PassArgs(self, in, count);
+            i += count - 1;
+            continue;
+        }
+
+        // A comparison that only decides a branch sets the flags for it and nothing else.
+        const IR_Instr* br = IR__IsCompare(in->type) ? Generator_x86_64__FusedBranch(self, instrs, i) : NULL;
+        if(br)
+        {
+            X86_Cond cond = Generator_x86_64__Compare(self, in);
+            while(&instrs->data[++i] != br) Generator_x86_64__EmitInstr(self, &instrs->data[i], block);
+            Generator_x86_64__Branch(self, cond, br, block);
+            continue;
+        }
+
+        size_t selected = Generator_x86_64__Select(self, instrs, i);
+        if(selected) i += selected - 1;
+        else Generator_x86_64__EmitInstr(self, in, block);
+    }
+}
+
+// Formats `instr` straight into the output. Only a line longer than most, with long
+// names in it, is formatted a second time.
+static void Generator_x86_64__WriteInstr(Generator_x86_64* self, const X86_Instr* instr, const char* proc, int indent)
+{
+    char* line = AssemblyGenerator_Reserve(&self->gen, indent, ASSEMBLY_LINE_GUESS);
+    size_t length = X86_Instr_Format(instr, proc, line, ASSEMBLY_LINE_GUESS + 1);
+    if(length > ASSEMBLY_LINE_GUESS)
+    {
+        AssemblyOutput_Reserve(&self->gen.output, length + 2);
+        X86_Instr_Format(instr, proc, self->gen.output.data + self->gen.output.count, length + 1);
+    }
+    AssemblyGenerator_Commit(&self->gen, length);
+}
+
+// Prints `code` as the procedure `name` and encodes it, whichever of the two are wanted.
+static void Generator_x86_64__Output(Generator_x86_64* self, Symbol name, size_t label_count, Arena* scratch)
+{
+    if(self->object) X86_Object_AddProc(self->object, name, self->code.data, self->code.count, label_count, scratch);
+    if(!self->text) return;
+
+    const char* proc = Symbol_Name(name);
+    AssemblyGenerator_WriteNoIndent(&self->gen, ".global %s", proc);
+    AssemblyGenerator_Begin(&self->gen, "%s:", proc);
+        for(size_t i = 0; i < self->code.count; ++i)
+        {
+            const X86_Instr* instr = &self->code.data[i];
+            if(instr->op == X86_Op_Nop) continue;
+            Generator_x86_64__WriteInstr(self, instr, proc, instr->op == X86_Op_Label ? 0 : self->gen.indent);
+        }
+    AssemblyGenerator_End(&self->gen);
+}
+
+void Generator_x86_64_EmitProc(Generator_x86_64* self, const IR_Proc* proc, Arena* scratch)
+{
+    self->proc = proc;
+    X86_InstrList_Clear(&self->code);
+
+    self->uses = ARENA_ARRAY(scratch, uint32_t, proc->reg_count);
+    memset(self->uses, 0, proc->reg_count * sizeof(uint32_t));
+    for(size_t b = 0; b < proc->blocks.count; ++b)
+    {
+        const IR_InstrList* instrs = &proc->blocks.data[b].instrs;
+        for(size_t i = 0; i < instrs->count; ++i)
+        {
+            if(instrs->data[i].lhs.type == IR_ValueType_Reg) self->uses[instrs->data[i].lhs.value]++;
+            if(instrs->data[i].rhs.type == IR_ValueType_Reg) self->uses[instrs->data[i].rhs.value]++;
+        }
+    }
+    self->fused = ARENA_ARRAY(scratch, bool, proc->reg_count);
+    memset(self->fused, 0, proc->reg_count * sizeof(bool));
+    for(size_t b = 0; b < proc->blocks.count; ++b)
+    {
+        const IR_InstrList* instrs = &proc->blocks.data[b].instrs;
+        for(size_t i = 0; i < instrs->count; ++i)
+            if(IR__IsCompare(instrs->data[i].type) && Generator_x86_64__FusedBranch(self, instrs, i))
+                self->fused[instrs->data[i].dst] = true;
+    }
+    Generator_x86_64_AllocateRegisters(self, proc, scratch);
+
+    Generator_x86_64__Prologue(self);
 
-} Generator_x86_64;
+    for(size_t b = 0; b < proc->blocks.count; ++b)
+    {
+        if(b != 0) Generator_x86_64__Emit(self, X86_Op_Label, X86_LABEL(b), X86_NONE);
+        Generator_x86_64__EmitBlock(self, b);
+    }
+
+    if(self->optimize) X86_Peephole(&self->code, proc->blocks.count, scratch);
+    Generator_x86_64__Output(self, proc->name, proc->blocks.count, scratch);
+    self->proc = NULL;
+    self->uses = NULL;
+    self->fused = NULL;
+}
+
+void Generator_x86_64_EmitStart(Generator_x86_64* self, Symbol main, long exit_syscall, Arena* scratch)
+{
+    X86_InstrList_Clear(&self->code);
+    Generator_x86_64__Emit(self, X86_Op_Call, X86_SYMBOL(main), X86_NONE);
+    Generator_x86_64__Emit(self, X86_Op_Mov, X86_REG(X86_Reg_Rdi), X86_REG(X86_Reg_Rax));
+    Generator_x86_64__Emit(self, X86_Op_Mov, X86_REG_SIZED(X86_Reg_Rax, 4), X86_IMM(exit_syscall));
+    Generator_x86_64__Emit(self, X86_Op_Syscall, X86_NONE, X86_NONE);
+    Generator_x86_64__Output(self, Symbol_Intern("_start", 6), 0, scratch);
+}
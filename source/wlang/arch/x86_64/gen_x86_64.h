@@ -0,0 +1,81 @@
+#ifndef WLANG_HEADER_GEN_X86_64_
+#define WLANG_HEADER_GEN_X86_64_
+#include <wlang/arch/gen.h>
+#include <wlang/arch/x86_64/instr_x86_64.h>
+#include <wlang/arch/x86_64/object_x86_64.h>
+#include <wlang/arena.h>
+#include <wlang/ir.h>
+
+//:==========----------- x86-64 Code Generation -----------==========://
+
+// Registers a called procedure has to give back unchanged (System V). There is no frame
+// pointer, so rbp is one of them like any other.
+#define X86_CALLEE_SAVED (X86_REG_BIT(X86_Reg_Rbx) | X86_REG_BIT(X86_Reg_R12) | X86_REG_BIT(X86_Reg_R13) \
+                        | X86_REG_BIT(X86_Reg_R14) | X86_REG_BIT(X86_Reg_R15) | X86_REG_BIT(X86_Reg_Rbp))
+
+// How far below rsp a procedure that calls nothing may keep its locals without moving rsp
+// (the System V red zone).
+#define X86_RED_ZONE 128
+
+// rax, rcx and rdx are kept free for the code generator, which needs them for division,
+// results and wide immediates, and rsp holds the frame.
+#define X86_ALLOCATABLE (X86_CALLEE_SAVED | X86_REG_BIT(X86_Reg_Rsi) | X86_REG_BIT(X86_Reg_Rdi) \
+                       | X86_REG_BIT(X86_Reg_R8) | X86_REG_BIT(X86_Reg_R9) | X86_REG_BIT(X86_Reg_R10) \
+                       | X86_REG_BIT(X86_Reg_R11))
+
+// Where a virtual register lives while its procedure runs: a machine register, or if it
+// was spilled, an offset below the top of the locals, which is `frame_size` above rsp.
+typedef struct { X86_Reg reg; long offset; } X86_Home;
+DECLARE_LIST_TYPE(X86_Home)
+
+// Registers that no instruction mentions get no home.
+static inline bool X86_Home_IsUsed(const X86_Home* self) { return self->reg != X86_REG_NONE || self->offset; }
+
+typedef struct
+{
+    AssemblyGenerator gen;
+    X86_InstrList code; // Of the procedure being emitted, output at its end.
+    bool text; // Whether to print the code to `gen` as assembly.
+    X86_Object* object; // Where to encode the code to, if anywhere.
+    bool optimize; // Whether to select instructions by pattern and run the peephole optimizer.
+    const IR_Proc* proc; // Procedure being emitted.
+    X86_HomeList homes; // Indexed by virtual register.
+    uint32_t* uses; // Per virtual register, how many instructions read it.
+    bool* fused; // Per virtual register, whether it is a comparison only setting the flags for a branch.
+    unsigned saved; // Callee-saved registers the procedure uses, pushed on entry.
+    size_t saved_size;
+    size_t frame_size; // Below the saved registers. 0 in a leaf whose locals fit in the red zone.
+} Generator_x86_64;
+
+void Generator_x86_64_Initialize(Generator_x86_64* self);
+void Generator_x86_64_Free(Generator_x86_64* self);
+
+// Linear scan register allocation (Poletto and Sarkar, with the holes of Traub et al.) over
+// the live ranges of `proc`. First the source and destination of each copy are coalesced
+// into one web when they are never live at once, which makes the copy disappear. A web
+// gets a register that others only have in its holes, callee-saved if it survives a call.
+// Under pressure the web that ends last is spilled to the frame as a whole. Comparisons
+// in `fused` get no home. Fills in `homes`, `saved` and the frame layout.
+void Generator_x86_64_AllocateRegisters(Generator_x86_64* self, const IR_Proc* proc, Arena* scratch);
+
+// Emits `proc` as Intel-syntax assembly into `self->gen.output` and as machine code into
+// `self->object`, as far as they are wanted. With `optimize` the instructions are selected
+// by patterns that use lea, shifts, inc and dec where they fit.
+void Generator_x86_64_EmitProc(Generator_x86_64* self, const IR_Proc* proc, Arena* scratch);
+
+// Emits the entry point `_start`, which calls `main` and exits with what it returns.
+void Generator_x86_64_EmitStart(Generator_x86_64* self, Symbol main, long exit_syscall, Arena* scratch);
+
+// How often each instruction selection pattern applied over the whole compilation, for `-stats`.
+void Generator_x86_64_PrintStats(FILE* f);
+
+//:==========----------- Peephole Optimizer -----------==========://
+
+// Rewrites the code of one procedure with a table of local patterns, in passes until
+// none applies any more. `label_count` is the number of blocks the labels are for.
+void X86_Peephole(X86_InstrList* code, size_t label_count, Arena* scratch);
+
+// How often each pattern applied over the whole compilation, for `-stats`.
+void X86_Peephole_PrintStats(FILE* f);
+
+#endif//WLANG_HEADER_GEN_X86_64_
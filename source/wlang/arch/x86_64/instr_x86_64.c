@@ -0,0 +1,94 @@
+#include <wlang/arch/x86_64/instr_x86_64.h>
+#include <wlang/symbol.h>
+#include <stdarg.h>
+
+DEFINE_LIST_TYPE(X86_Instr)
+
+static const char* X86__reg_names[][3] =
+{
+    { "rax", "eax", "al" },
+    { "rcx", "ecx", "cl" },
+    { "rdx", "edx", "dl" },
+    { "rbx", "ebx", "bl" },
+    { "rsp", "esp", "spl" },
+    { "rbp", "ebp", "bpl" },
+    { "rsi", "esi", "sil" },
+    { "rdi", "edi", "dil" },
+    { "r8", "r8d", "r8b" },
+    { "r9", "r9d", "r9b" },
+    { "r10", "r10d", "r10b" },
+    { "r11", "r11d", "r11b" },
+    { "r12", "r12d", "r12b" },
+    { "r13", "r13d", "r13b" },
+    { "r14", "r14d", "r14b" },
+    { "r15", "r15d", "r15b" },
+};
+
+const char* X86_Reg_Name(X86_Reg reg, int size)
+{
+    return X86__reg_names[reg][size == 8 ? 0 : size == 4 ? 1 : 2];
+}
+
+static const char* X86__mnemonics[] =
+{
+    [X86_Op_Mov] = "mov", [X86_Op_Movzx] = "movzx", [X86_Op_Lea] = "lea",
+    [X86_Op_Add] = "add", [X86_Op_Sub] = "sub", [X86_Op_Imul] = "imul",
+    [X86_Op_And] = "and", [X86_Op_Or] = "or", [X86_Op_Xor] = "xor",
+    [X86_Op_Cmp] = "cmp", [X86_Op_Test] = "test", [X86_Op_Neg] = "neg", [X86_Op_Not] = "not",
+    [X86_Op_Inc] = "inc", [X86_Op_Dec] = "dec", [X86_Op_Shl] = "shl", [X86_Op_Sar] = "sar",
+    [X86_Op_Cqo] = "cqo", [X86_Op_Idiv] = "idiv", [X86_Op_Setcc] = "set", [X86_Op_Jmp] = "jmp",
+    [X86_Op_Jcc] = "j", [X86_Op_Call] = "call", [X86_Op_Ret] = "ret", [X86_Op_Push] = "push",
+    [X86_Op_Pop] = "pop", [X86_Op_Syscall] = "syscall",
+};
+
+static const char* X86__cond_names[] =
+{
+    "o", "no", "b", "ae", "e", "ne", "be", "a", "s", "ns", "p", "np", "l", "ge", "le", "g",
+};
+
+// Formats after the first `n` characters of `buffer` as much as fits in `size`, and returns
+// where the text would end had it all fit, like snprintf.
+static size_t X86__Print(char* buffer, size_t size, size_t n, const char* fmt, ...)
+{
+    va_list va;
+    va_start(va, fmt);
+    int written = n < size ? vsnprintf(buffer + n, size - n, fmt, va) : vsnprintf(NULL, 0, fmt, va);
+    va_end(va);
+    return n + (size_t)written;
+}
+
+static size_t X86__FormatOperand(X86_Operand op, const char* proc, char* buffer, size_t size, size_t n)
+{
+    switch(op.type)
+    {
+    case X86_OperandType_Reg: return X86__Print(buffer, size, n, "%s", X86_Reg_Name(op.reg, op.size));
+    case X86_OperandType_Imm: return X86__Print(buffer, size, n, "%ld", op.value);
+    case X86_OperandType_Label: return X86__Print(buffer, size, n, ".L%s_%ld", proc, op.value);
+    case X86_OperandType_Symbol: return X86__Print(buffer, size, n, "%s", Symbol_Name((Symbol)op.value));
+    case X86_OperandType_Mem:
+    {
+        // Without a size it is only an address, as for lea.
+        n = X86__Print(buffer, size, n, "%s[%s", op.size == 8 ? "qword ptr " : "", X86_Reg_Name(op.reg, 8));
+        if(op.index != X86_REG_NONE) n = X86__Print(buffer, size, n, " + %s", X86_Reg_Name(op.index, 8));
+        if(op.index != X86_REG_NONE && op.scale != 1) n = X86__Print(buffer, size, n, " * %d", op.scale);
+        if(op.value) n = X86__Print(buffer, size, n, " %c %ld", op.value < 0 ? '-' : '+', op.value < 0 ? -op.value : op.value);
+        return X86__Print(buffer, size, n, "]");
+    }
+    default: return n;
+    }
+}
+
+size_t X86_Instr_Format(const X86_Instr* self, const char* proc, char* buffer, size_t size)
+{
+    if(self->op == X86_Op_Label)
+        return X86__Print(buffer, size, X86__FormatOperand(self->dst, proc, buffer, size, 0), ":");
+
+    size_t n = X86__Print(buffer, size, 0, "%s", X86__mnemonics[self->op]);
+    if(self->op == X86_Op_Jcc || self->op == X86_Op_Setcc)
+        n = X86__Print(buffer, size, n, "%s", X86__cond_names[self->cond]);
+    if(self->dst.type != X86_OperandType_None)
+        n = X86__FormatOperand(self->dst, proc, buffer, size, X86__Print(buffer, size, n, " "));
+    if(self->src.type != X86_OperandType_None)
+        n = X86__FormatOperand(self->src, proc, buffer, size, X86__Print(buffer, size, n, ", "));
+    return n;
+}
@@ -0,0 +1,159 @@
+#ifndef WLANG_HEADER_INSTR_X86_64_
+#define WLANG_HEADER_INSTR_X86_64_
+#include <stdint.h>
+#include <stdio.h>
+#include <wlang/type.h>
+
+//:==========----------- x86-64 Instructions -----------==========://
+
+typedef enum
+{
+    X86_Reg_Rax,
+    X86_Reg_Rcx,
+    X86_Reg_Rdx,
+    X86_Reg_Rbx,
+    X86_Reg_Rsp,
+    X86_Reg_Rbp,
+    X86_Reg_Rsi,
+    X86_Reg_Rdi,
+    X86_Reg_R8,
+    X86_Reg_R9,
+    X86_Reg_R10,
+    X86_Reg_R11,
+    X86_Reg_R12,
+    X86_Reg_R13,
+    X86_Reg_R14,
+    X86_Reg_R15,
+    X86_Reg__Count,
+    X86_REG_NONE = -1,
+} X86_Reg;
+
+#define X86_REG_BIT(R) (1u << (R))
+
+// Name of `reg` when used as a `size` byte register.
+const char* X86_Reg_Name(X86_Reg reg, int size);
+
+// Condition codes in the order of their encoding, so the opposite of a condition only
+// differs in the lowest bit.
+typedef enum
+{
+    X86_Cond_O, X86_Cond_NO, X86_Cond_B, X86_Cond_AE, X86_Cond_E, X86_Cond_NE, X86_Cond_BE, X86_Cond_A,
+    X86_Cond_S, X86_Cond_NS, X86_Cond_P, X86_Cond_NP, X86_Cond_L, X86_Cond_GE, X86_Cond_LE, X86_Cond_G,
+} X86_Cond;
+
+static inline X86_Cond X86_Cond_Negate(X86_Cond c) { return (X86_Cond)(c ^ 1); }
+
+// The condition that holds for `cmp b, a` when `c` holds for `cmp a, b`.
+static inline X86_Cond X86_Cond_Swap(X86_Cond c)
+{
+    switch(c)
+    {
+    case X86_Cond_L: return X86_Cond_G;
+    case X86_Cond_G: return X86_Cond_L;
+    case X86_Cond_LE: return X86_Cond_GE;
+    case X86_Cond_GE: return X86_Cond_LE;
+    case X86_Cond_B: return X86_Cond_A;
+    case X86_Cond_A: return X86_Cond_B;
+    case X86_Cond_BE: return X86_Cond_AE;
+    case X86_Cond_AE: return X86_Cond_BE;
+    default: return c;
+    }
+}
+
+typedef enum
+{
+    X86_Op_Nop, // Removed, skipped when printing.
+    X86_Op_Label, // `dst` is the label, not an instruction.
+    X86_Op_Mov,
+    X86_Op_Movzx,
+    X86_Op_Lea,
+    X86_Op_Add,
+    X86_Op_Sub,
+    X86_Op_Imul,
+    X86_Op_And,
+    X86_Op_Or,
+    X86_Op_Xor,
+    X86_Op_Cmp,
+    X86_Op_Test,
+    X86_Op_Neg,
+    X86_Op_Not,
+    X86_Op_Inc,
+    X86_Op_Dec,
+    X86_Op_Shl,
+    X86_Op_Sar,
+    X86_Op_Cqo,
+    X86_Op_Idiv,
+    X86_Op_Setcc,
+    X86_Op_Jmp,
+    X86_Op_Jcc,
+    X86_Op_Call,
+    X86_Op_Ret,
+    X86_Op_Push,
+    X86_Op_Pop,
+    X86_Op_Syscall,
+    X86_Op__Last,
+} X86_Op;
+
+typedef enum
+{
+    X86_OperandType_None,
+    X86_OperandType_Reg,
+    X86_OperandType_Imm,
+    X86_OperandType_Mem,    // [base + index * scale + disp]
+    X86_OperandType_Label,  // A block of the procedure being emitted.
+    X86_OperandType_Symbol, // A procedure.
+} X86_OperandType;
+
+typedef struct
+{
+    uint8_t type;
+    uint8_t size;  // In bytes, for registers and memory.
+    int8_t reg;    // The register, or the base of a memory operand.
+    int8_t index;  // Memory operands, X86_REG_NONE if there is none.
+    uint8_t scale;
+    long value;    // Immediate, displacement, block or Symbol.
+} X86_Operand;
+
+typedef struct
+{
+    uint8_t op;
+    uint8_t cond; // Jcc and Setcc.
+    X86_Operand dst, src;
+} X86_Instr;
+DECLARE_LIST_TYPE(X86_Instr)
+
+#define X86_NONE ((X86_Operand){ .type = X86_OperandType_None })
+#define X86_REG_SIZED(R, SIZE) ((X86_Operand){ .type = X86_OperandType_Reg, .size = (SIZE), .reg = (int8_t)(R), .index = X86_REG_NONE })
+#define X86_REG(R) X86_REG_SIZED(R, 8)
+#define X86_IMM(V) ((X86_Operand){ .type = X86_OperandType_Imm, .index = X86_REG_NONE, .value = (long)(V) })
+#define X86_MEM(BASE, DISP) ((X86_Operand){ .type = X86_OperandType_Mem, .size = 8, .reg = (int8_t)(BASE), .index = X86_REG_NONE, .scale = 1, .value = (long)(DISP) })
+// An address without a size, for lea: [base + index * scale + disp].
+#define X86_ADDR(BASE, INDEX, SCALE, DISP) ((X86_Operand){ .type = X86_OperandType_Mem, .reg = (int8_t)(BASE), .index = (int8_t)(INDEX), .scale = (uint8_t)(SCALE), .value = (long)(DISP) })
+#define X86_LABEL(BLOCK) ((X86_Operand){ .type = X86_OperandType_Label, .index = X86_REG_NONE, .value = (long)(BLOCK) })
+#define X86_SYMBOL(SYM) ((X86_Operand){ .type = X86_OperandType_Symbol, .index = X86_REG_NONE, .value = (long)(SYM) })
+
+static inline bool X86_Operand_Equal(X86_Operand a, X86_Operand b)
+{
+    return a.type == b.type && a.size == b.size && a.reg == b.reg && a.index == b.index
+        && a.scale == b.scale && a.value == b.value;
+}
+
+static inline bool X86_Operand_IsReg(X86_Operand op, X86_Reg reg)
+{ return op.type == X86_OperandType_Reg && op.reg == reg; }
+
+// Whether `op` reads or writes register `reg`, in any size, also as part of an address.
+static inline bool X86_Operand_Mentions(X86_Operand op, X86_Reg reg)
+{
+    return (op.type == X86_OperandType_Reg && op.reg == reg)
+        || (op.type == X86_OperandType_Mem && (op.reg == reg || op.index == reg));
+}
+
+static inline bool X86_Instr_IsJump(const X86_Instr* self)
+{ return self->op == X86_Op_Jmp || self->op == X86_Op_Jcc; }
+
+// Writes `self` as a line of Intel-syntax assembly, without indentation. Labels are
+// named after the procedure, `.L<proc>_<block>`. Returns the length of the line, which
+// is only all in `buffer` if it is less than `size`, like snprintf.
+size_t X86_Instr_Format(const X86_Instr* self, const char* proc, char* buffer, size_t size);
+
+#endif//WLANG_HEADER_INSTR_X86_64_
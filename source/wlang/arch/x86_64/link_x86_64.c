@@ -0,0 +1,190 @@
+#include <wlang/arch/x86_64/object_x86_64.h>
+#include <wlang/elf.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+// Where the executable is loaded, as ld does for static x86-64 executables.
+#define X86_LINK_BASE 0x400000
+#define X86_LINK_PAGE 0x1000
+#define X86_LINK_TEXT_ALIGN 16
+
+static inline size_t X86__AlignUp(size_t value, size_t alignment) { return (value + alignment - 1) / alignment * alignment; }
+
+// Writes `size` bytes to a new file at `path` that anyone may execute, within the umask.
+static bool X86__WriteExecutable(const char* path, const void* data, size_t size)
+{
+    unlink(path);
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0777);
+    if(fd < 0) return false;
+    const char* at = data;
+    while(size)
+    {
+        ssize_t n = write(fd, at, size);
+        if(n <= 0) break;
+        at += n;
+        size -= (size_t)n;
+    }
+    return close(fd) == 0 && size == 0;
+}
+
+// Puts the definitions of `objects` into `globals` with their offsets in an image where the
+// text of each starts at its base. Reports a symbol that is defined more than once and
+// returns in `missing` one that isn't defined at all.
+static X86_LinkResult X86__Resolve(X86_Object* objects, size_t count, const size_t* bases,
+                                   X86_ObjectSymbolHashMap* globals, Symbol* missing)
+{
+    for(size_t o = 0; o < count; ++o)
+    {
+        for(size_t i = 0; i < objects[o].symbols.count; ++i)
+        {
+            const X86_ObjectSymbol* symbol = &objects[o].symbols.data[i];
+            if(!symbol->defined) continue;
+            if(X86_ObjectSymbolHashMap_Find(globals, symbol->name))
+            {
+                fprintf(stderr, "\033[0;31mError:\033[0;0m Multiple definitions of '%s'.\n", Symbol_Name(symbol->name));
+                return X86_LinkResult_Failed;
+            }
+            X86_ObjectSymbol global = *symbol;
+            global.offset += bases[o];
+            X86_ObjectSymbolHashMap_Insert(globals, symbol->name, global);
+        }
+    }
+    for(size_t o = 0; o < count; ++o)
+    {
+        for(size_t i = 0; i < objects[o].symbols.count; ++i)
+        {
+            if(X86_ObjectSymbolHashMap_Find(globals, objects[o].symbols.data[i].name)) continue;
+            *missing = objects[o].symbols.data[i].name;
+            return X86_LinkResult_Undefined;
+        }
+    }
+    return X86_LinkResult_Done;
+}
+
+// Copies the texts into `image` at their bases and fills in the distances of the calls.
+// The distances are the same wherever the image is loaded.
+static void X86__Relocate(X86_Object* objects, size_t count, const size_t* bases,
+                          X86_ObjectSymbolHashMap* globals, uint8_t* image)
+{
+    for(size_t o = 0; o < count; ++o)
+    {
+        memcpy(image + bases[o], objects[o].text.data, objects[o].text.count);
+        for(size_t r = 0; r < objects[o].relocs.count; ++r)
+        {
+            const X86_Reloc* reloc = &objects[o].relocs.data[r];
+            size_t field = bases[o] + reloc->offset;
+            int32_t distance = (int32_t)((long)X86_ObjectSymbolHashMap_Find(globals, reloc->symbol)->offset - (long)(field + 4));
+            for(int i = 0; i < 4; ++i) image[field + i] = (uint8_t)((uint32_t)distance >> (8 * i));
+        }
+    }
+}
+
+// Offsets of the texts of `objects` one after another from `start`. Returns where the last one ends.
+static size_t X86__Layout(X86_Object* objects, size_t count, size_t start, size_t* bases)
+{
+    size_t end = X86__AlignUp(start, X86_LINK_TEXT_ALIGN);
+    for(size_t o = 0; o < count; ++o)
+    {
+        bases[o] = end;
+        end = X86__AlignUp(end + objects[o].text.count, X86_LINK_TEXT_ALIGN);
+    }
+    return end;
+}
+
+X86_LinkResult X86_Link(X86_Object* objects, size_t count, Symbol entry, const char* path)
+{
+    // The headers come first in the segment, the texts after them.
+    size_t* bases = malloc(sizeof(size_t) * count);
+    size_t end = X86__Layout(objects, count, sizeof(ELF_Header) + 2 * sizeof(ELF_Segment), bases);
+
+    X86_ObjectSymbolHashMap globals;
+    X86_ObjectSymbolHashMap_Initialize(&globals, &Symbol_Hash, &X86_ObjectSymbol_HasName);
+    Symbol missing = entry;
+    X86_LinkResult result = X86__Resolve(objects, count, bases, &globals, &missing);
+    const X86_ObjectSymbol* start = X86_ObjectSymbolHashMap_Find(&globals, entry);
+    if(result == X86_LinkResult_Done && !start) result = X86_LinkResult_Undefined;
+    if(result != X86_LinkResult_Done)
+    {
+        X86_ObjectSymbolHashMap_Free(&globals);
+        free(bases);
+        return result;
+    }
+
+    X86_ByteList image;
+    X86_ByteList_Initialize(&image);
+    X86_ByteList_Reserve(&image, end);
+    image.count = end;
+    memset(image.data, 0, end);
+
+    ELF_Header header = {
+        .ident = { 0x7F, 'E', 'L', 'F', ELF_Class_64, ELF_Data_LSB, ELF_Version_Current },
+        .type = ELF_Type_Exec, .machine = ELF_Machine_X86_64, .version = ELF_Version_Current,
+        .entry = X86_LINK_BASE + start->offset, .phoff = sizeof(ELF_Header),
+        .ehsize = sizeof(ELF_Header), .phentsize = sizeof(ELF_Segment), .phnum = 2,
+    };
+    ELF_Segment segments[2] = {
+        {
+            .type = ELF_SegmentType_Load, .flags = ELF_SegmentFlag_Read | ELF_SegmentFlag_Exec,
+            .vaddr = X86_LINK_BASE, .paddr = X86_LINK_BASE, .filesz = end, .memsz = end, .align = X86_LINK_PAGE,
+        },
+        // Without this the kernel would make the stack executable.
+        { .type = ELF_SegmentType_GnuStack, .flags = ELF_SegmentFlag_Read | ELF_SegmentFlag_Write, .align = 16 },
+    };
+    memcpy(image.data, &header, sizeof(header));
+    memcpy(image.data + sizeof(header), segments, sizeof(segments));
+    X86__Relocate(objects, count, bases, &globals, image.data);
+
+    if(!X86__WriteExecutable(path, image.data, image.count))
+    {
+        fprintf(stderr, "\033[0;31mError:\033[0;0m Could not write the executable '%s'.\n", path);
+        result = X86_LinkResult_Failed;
+    }
+    X86_ByteList_Free(&image);
+    X86_ObjectSymbolHashMap_Free(&globals);
+    free(bases);
+    return result;
+}
+
+bool X86_Run(X86_Object* objects, size_t count, Symbol entry, long* result)
+{
+    size_t* bases = malloc(sizeof(size_t) * count);
+    size_t size = X86__AlignUp(X86__Layout(objects, count, 0, bases), X86_LINK_PAGE);
+
+    X86_ObjectSymbolHashMap globals;
+    X86_ObjectSymbolHashMap_Initialize(&globals, &Symbol_Hash, &X86_ObjectSymbol_HasName);
+    Symbol missing = entry;
+    X86_LinkResult resolved = X86__Resolve(objects, count, bases, &globals, &missing);
+    const X86_ObjectSymbol* start = X86_ObjectSymbolHashMap_Find(&globals, entry);
+    if(resolved == X86_LinkResult_Done && !start) resolved = X86_LinkResult_Undefined;
+    if(resolved == X86_LinkResult_Undefined)
+        fprintf(stderr, "\033[0;31mError:\033[0;0m Undefined procedure '%s'.\n", Symbol_Name(missing));
+
+    // Written while it is only writable and then only made executable, never both at once.
+    uint8_t* image = MAP_FAILED;
+    if(resolved == X86_LinkResult_Done)
+        image = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    bool ran = image != MAP_FAILED;
+    if(ran)
+    {
+        X86__Relocate(objects, count, bases, &globals, image);
+        ran = mprotect(image, size, PROT_READ | PROT_EXEC) == 0;
+        if(!ran) fprintf(stderr, "\033[0;31mError:\033[0;0m Could not make the code executable.\n");
+    }
+    else if(resolved == X86_LinkResult_Done)
+        fprintf(stderr, "\033[0;31mError:\033[0;0m Could not map memory for the code.\n");
+
+    if(ran)
+    {
+        // Through a void* as ISO C has no conversion from object to function pointers.
+        long (*proc)(void);
+        void* address = image + start->offset;
+        memcpy(&proc, &address, sizeof(proc));
+        *result = proc();
+    }
+    if(image != MAP_FAILED) munmap(image, size);
+    X86_ObjectSymbolHashMap_Free(&globals);
+    free(bases);
+    return ran;
+}
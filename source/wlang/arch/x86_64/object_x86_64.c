@@ -0,0 +1,156 @@
+#include <wlang/arch/x86_64/object_x86_64.h>
+#include <wlang/elf.h>
+#include <stdio.h>
+
+DEFINE_LIST_TYPE(X86_Byte)
+DEFINE_HASHMAP_TYPE(X86_ObjectSymbol, Symbol)
+DEFINE_LIST_TYPE(X86_Reloc)
+
+void X86_Object_Initialize(X86_Object* self)
+{
+    X86_ByteList_Initialize(&self->text);
+    X86_ObjectSymbolHashMap_Initialize(&self->symbols, &Symbol_Hash, &X86_ObjectSymbol_HasName);
+    X86_RelocList_Initialize(&self->relocs);
+    self->errors = 0;
+}
+
+void X86_Object_Free(X86_Object* self)
+{
+    X86_ByteList_Free(&self->text);
+    X86_ObjectSymbolHashMap_Free(&self->symbols);
+    X86_RelocList_Free(&self->relocs);
+}
+
+X86_ObjectSymbol* X86_Object_Symbol(X86_Object* self, Symbol name)
+{
+    X86_ObjectSymbol* symbol = X86_ObjectSymbolHashMap_Find(&self->symbols, name);
+    if(symbol) return symbol;
+    return X86_ObjectSymbolHashMap_Insert(&self->symbols, name, (X86_ObjectSymbol){ .name = name });
+}
+
+//:==========----------- ELF Relocatable Files -----------==========://
+
+// Sections of the file, in this order after the null one.
+enum
+{
+    X86_ElfSection_Text = 1,
+    X86_ElfSection_Rela,
+    X86_ElfSection_Symtab,
+    X86_ElfSection_Strtab,
+    X86_ElfSection_Shstrtab,
+    X86_ElfSection_Stack, // .note.GNU-stack, empty, so the stack doesn't become executable.
+    X86_ElfSection__Count,
+};
+
+static const char X86__elf_section_names[] = "\0.text\0.rela.text\0.symtab\0.strtab\0.shstrtab\0.note.GNU-stack";
+
+static inline void X86__ElfAppend(X86_ByteList* out, const void* data, size_t size)
+{
+    X86_ByteList_Append(out, (const X86_Byte*)data, size);
+}
+
+static inline void X86__ElfAlign(X86_ByteList* out, size_t alignment)
+{
+    while(out->count % alignment) X86_ByteList_PushValue(out, 0);
+}
+
+// Offset of `name` in X86__elf_section_names.
+static uint32_t X86__ElfSectionName(const char* name)
+{
+    const char* at = X86__elf_section_names;
+    while(strcmp(at, name) != 0) at += strlen(at) + 1;
+    return (uint32_t)(at - X86__elf_section_names);
+}
+
+bool X86_Object_WriteElf(X86_Object* self, const char* path)
+{
+    // The symbols keep their order, after the null symbol, so a relocation's symbol is
+    // found at its index in the map. They are all global, there are no locals before them.
+    X86_ByteList out, strtab;
+    X86_ByteList_Initialize(&out);
+    X86_ByteList_Initialize(&strtab);
+    X86_ByteList_PushValue(&strtab, 0);
+
+    ELF_Section sections[X86_ElfSection__Count];
+    memset(sections, 0, sizeof(sections));
+    ELF_Header header = {
+        .ident = { 0x7F, 'E', 'L', 'F', ELF_Class_64, ELF_Data_LSB, ELF_Version_Current },
+        .type = ELF_Type_Rel, .machine = ELF_Machine_X86_64, .version = ELF_Version_Current,
+        .ehsize = sizeof(ELF_Header), .shentsize = sizeof(ELF_Section),
+        .shnum = X86_ElfSection__Count, .shstrndx = X86_ElfSection_Shstrtab,
+    };
+    X86__ElfAppend(&out, &header, sizeof(header));
+
+    X86__ElfAlign(&out, 16);
+    sections[X86_ElfSection_Text] = (ELF_Section){
+        .name = X86__ElfSectionName(".text"), .type = ELF_SectionType_Progbits,
+        .flags = ELF_SectionFlag_Alloc | ELF_SectionFlag_Exec,
+        .offset = out.count, .size = self->text.count, .addralign = 16,
+    };
+    X86__ElfAppend(&out, self->text.data, self->text.count);
+
+    X86__ElfAlign(&out, 8);
+    sections[X86_ElfSection_Rela] = (ELF_Section){
+        .name = X86__ElfSectionName(".rela.text"), .type = ELF_SectionType_Rela, .flags = ELF_SectionFlag_InfoLink,
+        .offset = out.count, .size = self->relocs.count * sizeof(ELF_Rela),
+        .link = X86_ElfSection_Symtab, .info = X86_ElfSection_Text, .addralign = 8, .entsize = sizeof(ELF_Rela),
+    };
+    for(size_t i = 0; i < self->relocs.count; ++i)
+    {
+        const X86_Reloc* reloc = &self->relocs.data[i];
+        X86_ObjectSymbol* symbol = X86_ObjectSymbolHashMap_Find(&self->symbols, reloc->symbol);
+        size_t index = (size_t)(symbol - self->symbols.data) + 1;
+        // The field is 4 bytes before the end of the call it is measured from.
+        ELF_Rela rela = { .offset = reloc->offset, .info = ELF_RELA_INFO(index, ELF_Reloc_X86_64_PLT32), .addend = -4 };
+        X86__ElfAppend(&out, &rela, sizeof(rela));
+    }
+
+    sections[X86_ElfSection_Symtab] = (ELF_Section){
+        .name = X86__ElfSectionName(".symtab"), .type = ELF_SectionType_Symtab, .offset = out.count,
+        .size = (self->symbols.count + 1) * sizeof(ELF_Symbol), .link = X86_ElfSection_Strtab, .info = 1,
+        .addralign = 8, .entsize = sizeof(ELF_Symbol),
+    };
+    ELF_Symbol null_symbol = { 0 };
+    X86__ElfAppend(&out, &null_symbol, sizeof(null_symbol));
+    for(size_t i = 0; i < self->symbols.count; ++i)
+    {
+        const X86_ObjectSymbol* symbol = &self->symbols.data[i];
+        const char* name = Symbol_Name(symbol->name);
+        ELF_Symbol entry = {
+            .name = (uint32_t)strtab.count,
+            .info = ELF_SYMBOL_INFO(ELF_SymbolBind_Global, symbol->defined ? ELF_SymbolType_Func : ELF_SymbolType_NoType),
+            .shndx = symbol->defined ? X86_ElfSection_Text : ELF_SECTION_UNDEF,
+            .value = symbol->defined ? symbol->offset : 0, .size = symbol->defined ? symbol->size : 0,
+        };
+        X86__ElfAppend(&out, &entry, sizeof(entry));
+        X86__ElfAppend(&strtab, name, strlen(name) + 1);
+    }
+
+    sections[X86_ElfSection_Strtab] = (ELF_Section){
+        .name = X86__ElfSectionName(".strtab"), .type = ELF_SectionType_Strtab,
+        .offset = out.count, .size = strtab.count, .addralign = 1,
+    };
+    X86__ElfAppend(&out, strtab.data, strtab.count);
+
+    sections[X86_ElfSection_Shstrtab] = (ELF_Section){
+        .name = X86__ElfSectionName(".shstrtab"), .type = ELF_SectionType_Strtab,
+        .offset = out.count, .size = sizeof(X86__elf_section_names), .addralign = 1,
+    };
+    X86__ElfAppend(&out, X86__elf_section_names, sizeof(X86__elf_section_names));
+
+    sections[X86_ElfSection_Stack] = (ELF_Section){
+        .name = X86__ElfSectionName(".note.GNU-stack"), .type = ELF_SectionType_Progbits,
+        .offset = out.count, .addralign = 1,
+    };
+
+    X86__ElfAlign(&out, 8);
+    ((ELF_Header*)out.data)->shoff = out.count;
+    X86__ElfAppend(&out, sections, sizeof(sections));
+
+    FILE* f = fopen(path, "wb");
+    bool written = f && fwrite(out.data, 1, out.count, f) == out.count;
+    if(f) written &= fclose(f) == 0;
+    X86_ByteList_Free(&out);
+    X86_ByteList_Free(&strtab);
+    return written;
+}
@@ -0,0 +1,68 @@
+#ifndef WLANG_HEADER_OBJECT_X86_64_
+#define WLANG_HEADER_OBJECT_X86_64_
+#include <wlang/arch/x86_64/instr_x86_64.h>
+#include <wlang/arena.h>
+#include <wlang/symbol.h>
+
+//:==========----------- x86-64 Objects -----------==========://
+
+typedef uint8_t X86_Byte;
+DECLARE_LIST_TYPE(X86_Byte)
+
+// A procedure in the text, or one that is called but not `defined` in it.
+typedef struct { Symbol name; bool defined; size_t offset, size; } X86_ObjectSymbol;
+DECLARE_HASHMAP_TYPE(X86_ObjectSymbol, Symbol)
+
+static inline bool X86_ObjectSymbol_HasName(X86_ObjectSymbol* self, Symbol name) { return self->name == name; }
+
+// The 32-bit field at `offset` in the text is to hold the distance from its own end to
+// `symbol`, which is the only kind of relocation calls need.
+typedef struct { size_t offset; Symbol symbol; } X86_Reloc;
+DECLARE_LIST_TYPE(X86_Reloc)
+
+// Machine code of a whole compilation, as the built-in assembler makes it.
+typedef struct
+{
+    X86_ByteList text;
+    X86_ObjectSymbolHashMap symbols; // In the order they were first mentioned in.
+    X86_RelocList relocs;
+    size_t errors; // Instructions that had no encoding.
+} X86_Object;
+
+void X86_Object_Initialize(X86_Object* self);
+void X86_Object_Free(X86_Object* self);
+
+// The entry of `name`, which is added as undefined if it isn't there yet.
+X86_ObjectSymbol* X86_Object_Symbol(X86_Object* self, Symbol name);
+
+// Encodes `code` to the end of the text as the procedure `name`, whose labels are
+// numbered below `label_count`. Jumps start out in their two byte form and the ones whose
+// target turns out to be too far away are made near, until all of them reach. Calls get
+// a relocation.
+void X86_Object_AddProc(X86_Object* self, Symbol name, const X86_Instr* code, size_t count,
+                        size_t label_count, Arena* scratch);
+
+// Writes the object as an ELF64 relocatable file, with its procedures as global symbols.
+bool X86_Object_WriteElf(X86_Object* self, const char* path);
+
+//:==========----------- Linking -----------==========://
+
+typedef enum
+{
+    X86_LinkResult_Done,
+    X86_LinkResult_Undefined, // A symbol none of the objects defines, nothing was written.
+    X86_LinkResult_Failed,
+} X86_LinkResult;
+
+// Links `objects` into a static executable that starts at `entry`. Their texts go one
+// after another into a single segment and the calls between them are resolved. A symbol
+// that none of them defines could still come from a library, which is left to the system
+// linker.
+X86_LinkResult X86_Link(X86_Object* objects, size_t count, Symbol entry, const char* path);
+
+// Loads `objects` into executable memory of this process the same way and calls `entry`
+// there, which gets no arguments. Returns whether it could, and what `entry` returned in
+// `result`.
+bool X86_Run(X86_Object* objects, size_t count, Symbol entry, long* result);
+
+#endif//WLANG_HEADER_OBJECT_X86_64_
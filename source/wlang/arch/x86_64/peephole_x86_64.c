@@ -0,0 +1,252 @@
+#include <wlang/arch/x86_64/gen_x86_64.h>
+#include <string.h>
+
+#define X86_PEEPHOLE_WINDOW 4
+#define X86_PEEPHOLE_MAX_PASSES 8
+
+typedef struct
+{
+    X86_Instr* code;
+    size_t count;
+    size_t* labels; // Per block, the index of its label or SIZE_MAX.
+    size_t* jumps;  // Per block, how many jumps go to it.
+    size_t label_count;
+} X86_PeepholeContext;
+
+// A rewrite pattern gets the indices of the next instructions that are still there, the
+// first of which it tries to match at. `length` of them are guaranteed to exist.
+typedef struct
+{
+    const char* name;
+    size_t length;
+    bool (*apply)(X86_PeepholeContext* self, const size_t* at);
+} X86_PeepholePattern;
+
+static inline X86_Instr* X86_Peephole__At(X86_PeepholeContext* self, const size_t* at, size_t i) { return &self->code[at[i]]; }
+
+static inline void X86_Peephole__Remove(X86_PeepholeContext* self, size_t index) { self->code[index].op = X86_Op_Nop; }
+
+static inline bool X86__IsReg64(X86_Operand op) { return op.type == X86_OperandType_Reg && op.size == 8; }
+
+// The first instruction control reaches when jumping to `block`.
+static const X86_Instr* X86_Peephole__Target(X86_PeepholeContext* self, long block)
+{
+    if(block < 0 || (size_t)block >= self->label_count || self->labels[block] == SIZE_MAX) return NULL;
+    for(size_t i = self->labels[block]; i < self->count; ++i)
+        if(self->code[i].op != X86_Op_Nop && self->code[i].op != X86_Op_Label) return &self->code[i];
+    return NULL;
+}
+
+// Whether `block`'s label comes after `index` with nothing but other labels in between.
+static bool X86_Peephole__LabelFollows(X86_PeepholeContext* self, size_t index, long block)
+{
+    for(size_t i = index + 1; i < self->count; ++i)
+    {
+        const X86_Instr* in = &self->code[i];
+        if(in->op == X86_Op_Nop) continue;
+        if(in->op != X86_Op_Label) return false;
+        if(in->dst.value == block) return true;
+    }
+    return false;
+}
+
+// mov r, r
+static bool X86_Peephole__MovSelf(X86_PeepholeContext* self, const size_t* at)
+{
+    X86_Instr* a = X86_Peephole__At(self, at, 0);
+    if(a->op != X86_Op_Mov || !X86__IsReg64(a->dst) || !X86_Operand_Equal(a->dst, a->src)) return false;
+    X86_Peephole__Remove(self, at[0]);
+    return true;
+}
+
+// mov a, b; mov b, a -> mov a, b
+static bool X86_Peephole__MovBack(X86_PeepholeContext* self, const size_t* at)
+{
+    X86_Instr* a = X86_Peephole__At(self, at, 0), *b = X86_Peephole__At(self, at, 1);
+    if(a->op != X86_Op_Mov || b->op != X86_Op_Mov) return false;
+    if(!X86_Operand_Equal(a->dst, b->src) || !X86_Operand_Equal(a->src, b->dst)) return false;
+    X86_Peephole__Remove(self, at[1]);
+    return true;
+}
+
+// mov r, x; mov r, y -> mov r, y, when y doesn't read r.
+static bool X86_Peephole__MovOverwritten(X86_PeepholeContext* self, const size_t* at)
+{
+    X86_Instr* a = X86_Peephole__At(self, at, 0), *b = X86_Peephole__At(self, at, 1);
+    if(a->op != X86_Op_Mov || !X86__IsReg64(a->dst)) return false;
+    if((b->op != X86_Op_Mov && b->op != X86_Op_Lea) || !X86__IsReg64(b->dst) || b->dst.reg != a->dst.reg) return false;
+    if(X86_Operand_Mentions(b->src, a->dst.reg)) return false;
+    X86_Peephole__Remove(self, at[0]);
+    return true;
+}
+
+// push a; pop b -> mov b, a
+static bool X86_Peephole__PushPop(X86_PeepholeContext* self, const size_t* at)
+{
+    X86_Instr* a = X86_Peephole__At(self, at, 0), *b = X86_Peephole__At(self, at, 1);
+    if(a->op != X86_Op_Push || b->op != X86_Op_Pop || a->dst.type != X86_OperandType_Reg) return false;
+    X86_Peephole__Remove(self, at[0]);
+    if(X86_Operand_Equal(a->dst, b->dst)) X86_Peephole__Remove(self, at[1]);
+    else *b = (X86_Instr){ .op = X86_Op_Mov, .dst = b->dst, .src = a->dst };
+    return true;
+}
+
+// mov [m], r; mov s, [m] -> mov [m], r; mov s, r
+static bool X86_Peephole__StoreLoad(X86_PeepholeContext* self, const size_t* at)
+{
+    X86_Instr* a = X86_Peephole__At(self, at, 0), *b = X86_Peephole__At(self, at, 1);
+    if(a->op != X86_Op_Mov || b->op != X86_Op_Mov || a->dst.type != X86_OperandType_Mem) return false;
+    if(!X86__IsReg64(a->src) || !X86__IsReg64(b->dst) || !X86_Operand_Equal(a->dst, b->src)) return false;
+    if(b->dst.reg == a->src.reg) X86_Peephole__Remove(self, at[1]);
+    else b->src = a->src;
+    return true;
+}
+
+// cmp r, 0 -> test r, r, which sets the flags the same way and is shorter.
+static bool X86_Peephole__CmpZero(X86_PeepholeContext* self, const size_t* at)
+{
+    X86_Instr* a = X86_Peephole__At(self, at, 0);
+    if(a->op != X86_Op_Cmp || a->dst.type != X86_OperandType_Reg) return false;
+    if(a->src.type != X86_OperandType_Imm || a->src.value != 0) return false;
+    *a = (X86_Instr){ .op = X86_Op_Test, .dst = a->dst, .src = a->dst };
+    return true;
+}
+
+// setcc r8; movzx r32, r8; test r, r; jne l -> setcc r8; movzx r32, r8; jcc l
+// The flags of the comparison are still there, so testing its result again is not needed.
+static bool X86_Peephole__SetBranch(X86_PeepholeContext* self, const size_t* at)
+{
+    X86_Instr* set = X86_Peephole__At(self, at, 0), *ext = X86_Peephole__At(self, at, 1);
+    X86_Instr* test = X86_Peephole__At(self, at, 2), *jump = X86_Peephole__At(self, at, 3);
+    if(set->op != X86_Op_Setcc || ext->op != X86_Op_Movzx || test->op != X86_Op_Test || jump->op != X86_Op_Jcc) return false;
+    X86_Reg reg = set->dst.reg;
+    if(!X86_Operand_IsReg(ext->dst, reg) || !X86_Operand_IsReg(ext->src, reg)) return false;
+    if(!X86_Operand_IsReg(test->dst, reg) || !X86_Operand_IsReg(test->src, reg)) return false;
+    if(jump->cond != X86_Cond_E && jump->cond != X86_Cond_NE) return false;
+    jump->cond = jump->cond == X86_Cond_NE ? set->cond : X86_Cond_Negate(set->cond);
+    X86_Peephole__Remove(self, at[2]);
+    return true;
+}
+
+// jmp l; l: -> l:
+static bool X86_Peephole__JumpNext(X86_PeepholeContext* self, const size_t* at)
+{
+    X86_Instr* a = X86_Peephole__At(self, at, 0);
+    if(a->op != X86_Op_Jmp || !X86_Peephole__LabelFollows(self, at[0], a->dst.value)) return false;
+    X86_Peephole__Remove(self, at[0]);
+    return true;
+}
+
+// jcc l; jmp m; l: -> jncc m; l:
+static bool X86_Peephole__BranchOverJump(X86_PeepholeContext* self, const size_t* at)
+{
+    X86_Instr* a = X86_Peephole__At(self, at, 0), *b = X86_Peephole__At(self, at, 1);
+    if(a->op != X86_Op_Jcc || b->op != X86_Op_Jmp || !X86_Peephole__LabelFollows(self, at[1], a->dst.value)) return false;
+    a->cond = X86_Cond_Negate(a->cond);
+    a->dst = b->dst;
+    X86_Peephole__Remove(self, at[1]);
+    return true;
+}
+
+// jmp l; ...; l: jmp m -> jmp m
+static bool X86_Peephole__JumpThread(X86_PeepholeContext* self, const size_t* at)
+{
+    X86_Instr* a = X86_Peephole__At(self, at, 0);
+    if(!X86_Instr_IsJump(a)) return false;
+    const X86_Instr* target = X86_Peephole__Target(self, a->dst.value);
+    if(!target || target->op != X86_Op_Jmp || target->dst.value == a->dst.value) return false;
+    a->dst = target->dst;
+    return true;
+}
+
+// Nothing after a jmp or ret runs until the next label.
+static bool X86_Peephole__Unreachable(X86_PeepholeContext* self, const size_t* at)
+{
+    X86_Instr* a = X86_Peephole__At(self, at, 0), *b = X86_Peephole__At(self, at, 1);
+    if((a->op != X86_Op_Jmp && a->op != X86_Op_Ret) || b->op == X86_Op_Label) return false;
+    X86_Peephole__Remove(self, at[1]);
+    return true;
+}
+
+// A label nothing jumps to, which control only ever falls through. Rewrites only move
+// jumps to labels that already had one, so the counts of the pass stay good enough.
+static bool X86_Peephole__UnusedLabel(X86_PeepholeContext* self, const size_t* at)
+{
+    X86_Instr* a = X86_Peephole__At(self, at, 0);
+    if(a->op != X86_Op_Label || self->jumps[a->dst.value]) return false;
+    X86_Peephole__Remove(self, at[0]);
+    return true;
+}
+
+static const X86_PeepholePattern X86_Peephole__patterns[] =
+{
+    { "mov-self",           1, X86_Peephole__MovSelf },
+    { "mov-back",           2, X86_Peephole__MovBack },
+    { "mov-overwritten",    2, X86_Peephole__MovOverwritten },
+    { "push-pop",           2, X86_Peephole__PushPop },
+    { "store-load",         2, X86_Peephole__StoreLoad },
+    { "cmp-zero",           1, X86_Peephole__CmpZero },
+    { "set-branch",         4, X86_Peephole__SetBranch },
+    { "jump-next",          1, X86_Peephole__JumpNext },
+    { "branch-over-jump",   2, X86_Peephole__BranchOverJump },
+    { "jump-thread",        1, X86_Peephole__JumpThread },
+    { "unreachable",        2, X86_Peephole__Unreachable },
+    { "unused-label",       1, X86_Peephole__UnusedLabel },
+};
+#define X86_PEEPHOLE_PATTERN_COUNT (sizeof(X86_Peephole__patterns) / sizeof(X86_Peephole__patterns[0]))
+
+static size_t X86_Peephole__counts[X86_PEEPHOLE_PATTERN_COUNT];
+
+void X86_Peephole(X86_InstrList* code, size_t label_count, Arena* scratch)
+{
+    X86_PeepholeContext self = {
+        code->data, code->count,
+        ARENA_ARRAY(scratch, size_t, label_count + 1), ARENA_ARRAY(scratch, size_t, label_count + 1), label_count
+    };
+
+    bool changed = true;
+    for(int pass = 0; changed && pass < X86_PEEPHOLE_MAX_PASSES; ++pass)
+    {
+        changed = false;
+        for(size_t b = 0; b < label_count; ++b) { self.labels[b] = SIZE_MAX; self.jumps[b] = 0; }
+        for(size_t i = 0; i < self.count; ++i)
+        {
+            if(self.code[i].op == X86_Op_Label) self.labels[self.code[i].dst.value] = i;
+            else if(X86_Instr_IsJump(&self.code[i])) self.jumps[self.code[i].dst.value]++;
+        }
+
+        for(size_t i = 0; i < self.count; ++i)
+        {
+            if(self.code[i].op == X86_Op_Nop) continue;
+            size_t at[X86_PEEPHOLE_WINDOW], length = 0;
+            for(size_t j = i; j < self.count && length < X86_PEEPHOLE_WINDOW; ++j)
+                if(self.code[j].op != X86_Op_Nop) at[length++] = j;
+
+            for(size_t p = 0; p < X86_PEEPHOLE_PATTERN_COUNT; ++p)
+            {
+                const X86_PeepholePattern* pattern = &X86_Peephole__patterns[p];
+                if(pattern->length > length || !pattern->apply(&self, at)) continue;
+                X86_Peephole__counts[p]++;
+                changed = true;
+                break;
+            }
+        }
+    }
+
+    size_t kept = 0;
+    for(size_t i = 0; i < code->count; ++i)
+        if(code->data[i].op != X86_Op_Nop) code->data[kept++] = code->data[i];
+    code->count = kept;
+}
+
+void X86_Peephole_PrintStats(FILE* f)
+{
+    size_t total = 0;
+    fprintf(f, "Peephole rewrites:\n");
+    for(size_t p = 0; p < X86_PEEPHOLE_PATTERN_COUNT; ++p)
+    {
+        fprintf(f, "  %-18s %10zu\n", X86_Peephole__patterns[p].name, X86_Peephole__counts[p]);
+        total += X86_Peephole__counts[p];
+    }
+    fprintf(f, "  %-18s %10zu\n", "total", total);
+}
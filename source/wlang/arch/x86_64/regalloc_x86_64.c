@@ -0,0 +1,255 @@
+#include <wlang/arch/x86_64/gen_x86_64.h>
+#include <wlang/iropt.h>
+#include <string.h>
+
+// Caller-saved registers come first, so that short intervals don't make the procedure
+// save anything. The argument registers are last among them, calls need those.
+static const X86_Reg X86__allocation_order[] = {
+    X86_Reg_R10, X86_Reg_R11, X86_Reg_R9, X86_Reg_R8, X86_Reg_Rsi, X86_Reg_Rdi,
+    X86_Reg_Rbx, X86_Reg_R12, X86_Reg_R13, X86_Reg_R14, X86_Reg_R15, X86_Reg_Rbp,
+};
+
+static const X86_Reg X86__arg_regs[] = {
+    X86_Reg_Rdi, X86_Reg_Rsi, X86_Reg_Rdx, X86_Reg_Rcx, X86_Reg_R8, X86_Reg_R9,
+};
+
+// The virtual registers that share a home, and the ranges they are live in together.
+typedef struct { IR_Interval* ranges; size_t count; } X86_Web;
+
+// A web that has a register, and the first of its ranges that doesn't end before where
+// the scan is.
+typedef struct { IR_V web; size_t range; } X86_Active;
+
+static IR_V X86__WebOf(IR_V* parent, IR_V v)
+{
+    while(parent[v] != v) v = parent[v] = parent[parent[v]];
+    return v;
+}
+
+// Whether the ranges overlap anywhere, from `a`'s range `i` and `b`'s range `j` on.
+static bool X86__Overlap(const X86_Web* a, size_t i, const X86_Web* b, size_t j)
+{
+    while(i < a->count && j < b->count)
+    {
+        if(a->ranges[i].end < b->ranges[j].start) ++i;
+        else if(b->ranges[j].end < a->ranges[i].start) ++j;
+        else return true;
+    }
+    return false;
+}
+
+// The ranges of both, in order, with ranges that meet made one.
+static X86_Web X86__Merge(const X86_Web* a, const X86_Web* b, Arena* scratch)
+{
+    X86_Web web = { ARENA_ARRAY(scratch, IR_Interval, a->count + b->count), 0 };
+    size_t i = 0, j = 0;
+    while(i < a->count || j < b->count)
+    {
+        IR_Interval next = j == b->count || (i < a->count && a->ranges[i].start < b->ranges[j].start)
+                         ? a->ranges[i++] : b->ranges[j++];
+        if(web.count && next.start <= web.ranges[web.count - 1].end + 1)
+        {
+            if(next.end > web.ranges[web.count - 1].end) web.ranges[web.count - 1].end = next.end;
+        }
+        else web.ranges[web.count++] = next;
+    }
+    return web;
+}
+
+// Moves `active` on to `position`: the first of its ranges that doesn't end before it.
+// Returns false if all of them do.
+static bool X86__Advance(X86_Active* active, const X86_Web* webs, size_t position)
+{
+    const X86_Web* web = &webs[active->web];
+    while(active->range < web->count && web->ranges[active->range].end < position) active->range++;
+    return active->range < web->count;
+}
+
+void Generator_x86_64_AllocateRegisters(Generator_x86_64* self, const IR_Proc* proc, Arena* scratch)
+{
+    IR_Liveness live;
+    IR_Liveness_Compute(&live, proc, scratch);
+    size_t reg_count = proc->reg_count;
+
+    X86_HomeList_Clear(&self->homes);
+    X86_HomeList_Reserve(&self->homes, reg_count);
+    self->homes.count = reg_count;
+    for(IR_V r = 0; r < reg_count; ++r) self->homes.data[r] = (X86_Home){ X86_REG_NONE, 0 };
+
+    // Each register starts out as a web of its own.
+    IR_V* parent = ARENA_ARRAY(scratch, IR_V, reg_count);
+    X86_Web* webs = ARENA_ARRAY(scratch, X86_Web, reg_count);
+    for(IR_V r = 0; r < reg_count; ++r)
+    {
+        parent[r] = r;
+        webs[r] = (X86_Web){ live.ranges + live.range_start[r], live.range_start[r + 1] - live.range_start[r] };
+    }
+
+    // Hints: the argument register a parameter comes in or an argument goes out in.
+    X86_Reg* prefer = ARENA_ARRAY(scratch, X86_Reg, reg_count);
+    for(IR_V r = 0; r < reg_count; ++r) prefer[r] = X86_REG_NONE;
+
+    size_t position = 0, params_end = 0;
+    bool calls = false;
+    for(size_t b = 0; b < proc->blocks.count; ++b)
+    {
+        const IR_InstrList* instrs = &proc->blocks.data[b].instrs;
+        for(size_t i = 0; i < instrs->count; ++i, position += 2)
+        {
+            const IR_Instr* in = &instrs->data[i];
+            bool in_reg = in->label < sizeof(X86__arg_regs) / sizeof(X86__arg_regs[0]);
+            if(in->type == IR_OpType_Call) calls = true;
+            else if(in->type == IR_OpType_Param)
+            {
+                if(in_reg) prefer[in->dst] = X86__arg_regs[in->label];
+                params_end = position + 1;
+            }
+            else if(in->type == IR_OpType_Arg && in_reg && in->lhs.type == IR_ValueType_Reg
+                 && prefer[in->lhs.value] == X86_REG_NONE)
+                prefer[in->lhs.value] = X86__arg_regs[in->label];
+        }
+    }
+
+    // Parameters are moved in all at once, so they all have to be live from the start.
+    const IR_InstrList* entry = &proc->blocks.data[0].instrs;
+    for(size_t i = 0; i < entry->count && entry->data[i].type == IR_OpType_Param; ++i)
+    {
+        X86_Web* web = &webs[entry->data[i].dst];
+        if(!web->count) continue;
+        X86_Web start = { &(IR_Interval){ 0, params_end }, 1 };
+        *web = X86__Merge(web, &start, scratch);
+    }
+
+    // Copies whose source and destination are never live at once are coalesced, both get
+    // the same home and the copy disappears. After leaving SSA form these are mostly the
+    // copies that took the place of phis.
+    for(size_t b = 0; b < proc->blocks.count; ++b)
+    {
+        const IR_InstrList* instrs = &proc->blocks.data[b].instrs;
+        for(size_t i = 0; i < instrs->count; ++i)
+        {
+            const IR_Instr* in = &instrs->data[i];
+            if(in->type != IR_OpType_Mov || in->lhs.type != IR_ValueType_Reg) continue;
+            IR_V a = X86__WebOf(parent, in->dst), c = X86__WebOf(parent, in->lhs.value);
+            if(a == c || self->fused[a] || self->fused[c]) continue;
+            if(!webs[a].count || !webs[c].count || X86__Overlap(&webs[a], 0, &webs[c], 0)) continue;
+            // Only one of them can be a parameter, which has its register to come in.
+            if(prefer[a] != X86_REG_NONE && prefer[c] != X86_REG_NONE && prefer[a] != prefer[c]) continue;
+            webs[a] = X86__Merge(&webs[a], &webs[c], scratch);
+            if(prefer[a] == X86_REG_NONE) prefer[a] = prefer[c];
+            parent[c] = a;
+        }
+    }
+
+    // Counting sort of the webs by start, leaving out comparisons that only set the flags.
+    size_t* first = ARENA_ARRAY(scratch, size_t, position + 2);
+    IR_V* order = ARENA_ARRAY(scratch, IR_V, reg_count);
+    memset(first, 0, sizeof(size_t) * (position + 2));
+    for(IR_V r = 1; r < reg_count; ++r)
+        if(parent[r] == r && webs[r].count && !self->fused[r]) ++first[webs[r].ranges[0].start + 1];
+    for(size_t p = 1; p < position + 2; ++p) first[p] += first[p - 1];
+    size_t order_count = first[position + 1];
+    for(IR_V r = 1; r < reg_count; ++r)
+        if(parent[r] == r && webs[r].count && !self->fused[r]) order[first[webs[r].ranges[0].start]++] = r;
+
+    // Webs with a register are active where one of their ranges covers the scan position
+    // and inactive in their holes, where others may have the register for a while.
+    X86_Active* active = ARENA_ARRAY(scratch, X86_Active, order_count + 1);
+    X86_Active* inactive = ARENA_ARRAY(scratch, X86_Active, order_count + 1);
+    size_t active_count = 0, inactive_count = 0;
+    unsigned used = 0;
+    IR_V* spilled = ARENA_ARRAY(scratch, IR_V, order_count + 1);
+    size_t spill_count = 0;
+
+    for(size_t o = 0; o < order_count; ++o)
+    {
+        IR_V v = order[o];
+        const X86_Web* web = &webs[v];
+        size_t start = web->ranges[0].start;
+
+        size_t kept = 0;
+        for(size_t a = 0; a < active_count; ++a)
+        {
+            if(!X86__Advance(&active[a], webs, start)) continue;
+            if(webs[active[a].web].ranges[active[a].range].start > start) inactive[inactive_count++] = active[a];
+            else active[kept++] = active[a];
+        }
+        active_count = kept;
+        kept = 0;
+        for(size_t a = 0; a < inactive_count; ++a)
+        {
+            if(!X86__Advance(&inactive[a], webs, start)) continue;
+            if(webs[inactive[a].web].ranges[inactive[a].range].start <= start) active[active_count++] = inactive[a];
+            else inactive[kept++] = inactive[a];
+        }
+        inactive_count = kept;
+
+        // A register is free if no active web has it, and no inactive one that needs it
+        // again while this web does.
+        unsigned available = X86_ALLOCATABLE, blocked = 0;
+        for(size_t a = 0; a < active_count; ++a) available &= ~X86_REG_BIT(self->homes.data[active[a].web].reg);
+        for(size_t a = 0; a < inactive_count; ++a)
+            if(X86__Overlap(&webs[inactive[a].web], inactive[a].range, web, 0))
+                blocked |= X86_REG_BIT(self->homes.data[inactive[a].web].reg);
+        available &= ~blocked;
+
+        unsigned usable = IR_Liveness_CrossesCall(&live, web->ranges, web->count) ? X86_CALLEE_SAVED : X86_ALLOCATABLE;
+        unsigned allowed = available & usable;
+        X86_Reg chosen = X86_REG_NONE;
+        if(prefer[v] != X86_REG_NONE && (allowed & X86_REG_BIT(prefer[v]))) chosen = prefer[v];
+        else
+        {
+            for(size_t i = 0; i < sizeof(X86__allocation_order) / sizeof(X86__allocation_order[0]); ++i)
+            {
+                if(!(allowed & X86_REG_BIT(X86__allocation_order[i]))) continue;
+                chosen = X86__allocation_order[i];
+                break;
+            }
+        }
+
+        if(chosen == X86_REG_NONE)
+        {
+            // Out of registers: of this web and the active ones it could take a register
+            // from, the one that ends last is spilled.
+            size_t victim = active_count;
+            for(size_t a = 0; a < active_count; ++a)
+            {
+                unsigned bit = X86_REG_BIT(self->homes.data[active[a].web].reg);
+                if(!(usable & bit) || (blocked & bit)) continue;
+                const X86_Web* candidate = &webs[active[a].web];
+                if(victim == active_count || candidate->ranges[candidate->count - 1].end
+                   > webs[active[victim].web].ranges[webs[active[victim].web].count - 1].end) victim = a;
+            }
+            if(victim == active_count
+               || webs[active[victim].web].ranges[webs[active[victim].web].count - 1].end <= web->ranges[web->count - 1].end)
+            {
+                spilled[spill_count++] = v;
+                continue;
+            }
+            IR_V taken = active[victim].web;
+            chosen = self->homes.data[taken].reg;
+            self->homes.data[taken].reg = X86_REG_NONE;
+            spilled[spill_count++] = taken;
+            active[victim] = active[--active_count];
+        }
+
+        self->homes.data[v].reg = chosen;
+        used |= X86_REG_BIT(chosen);
+        active[active_count++] = (X86_Active){ v, 0 };
+    }
+
+    // Frame, from the return address down: the saved registers, the local slots, the
+    // spilled webs. A procedure that calls nothing keeps as much of it as fits in the
+    // red zone without moving rsp at all.
+    self->saved = used & X86_CALLEE_SAVED;
+    self->saved_size = 8 * (size_t)__builtin_popcount(self->saved);
+    for(size_t s = 0; s < spill_count; ++s)
+        self->homes.data[spilled[s]].offset = 8 * (proc->slot_count + s + 1);
+    for(IR_V r = 1; r < reg_count; ++r)
+        if(webs[r].count) self->homes.data[r] = self->homes.data[X86__WebOf(parent, r)];
+
+    size_t locals = 8 * (proc->slot_count + spill_count);
+    if(calls) // Keeps rsp 16-byte aligned at calls, the return address is 8 bytes.
+        self->frame_size = ((8 + self->saved_size + locals + 15) & ~(size_t)15) - 8 - self->saved_size;
+    else self->frame_size = locals <= X86_RED_ZONE ? 0 : locals;
+}
@@ -0,0 +1,65 @@
+#include <wlang/arena.h>
+#include <stdlib.h>
+#include <string.h>
+
+void Arena_Initialize(Arena* self, size_t chunk_size)
+{
+    self->first = NULL;
+    self->current = NULL;
+    self->chunk_size = chunk_size ? chunk_size : ARENA_DEFAULT_CHUNK_SIZE;
+}
+
+void Arena_Free(Arena* self)
+{
+    for(ArenaChunk* c = self->first; c;)
+    {
+        ArenaChunk* next = c->next;
+        free(c);
+        c = next;
+    }
+    self->first = NULL;
+    self->current = NULL;
+}
+
+void Arena_Reset(Arena* self)
+{
+    // Later chunks get their `used` cleared when allocation reaches them again.
+    self->current = self->first;
+    if(self->current) self->current->used = 0;
+}
+
+static ArenaChunk* Arena__NewChunk(size_t size)
+{
+    ArenaChunk* c = malloc(sizeof(ArenaChunk) + size);
+    c->next = NULL;
+    c->size = size;
+    c->used = 0;
+    return c;
+}
+
+void* Arena__AllocSlow(Arena* self, size_t size)
+{
+    // Move on to the next kept chunk if it is big enough, otherwise put a new one
+    // in front of it. Oversized requests get a chunk of their own.
+    ArenaChunk* c = self->current;
+    ArenaChunk* next = c ? c->next : self->first;
+    if(next && next->size >= size) next->used = 0;
+    else
+    {
+        ArenaChunk* fresh = Arena__NewChunk(size > self->chunk_size ? size : self->chunk_size);
+        fresh->next = next;
+        if(c) c->next = fresh;
+        else self->first = fresh;
+        next = fresh;
+    }
+    self->current = next;
+    next->used = size;
+    return next->data;
+}
+
+void* Arena_Copy(Arena* self, const void* source, size_t size)
+{
+    void* m = Arena_Alloc(self, size);
+    if(size) memcpy(m, source, size);
+    return m;
+}
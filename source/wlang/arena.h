@@ -0,0 +1,48 @@
+#ifndef WLANG_HEADER_ARENA_
+#define WLANG_HEADER_ARENA_
+#include <stddef.h>
+
+//:==========----------- Arena Allocator -----------==========://
+
+// Bump allocator over a chain of chunks. Everything allocated from an arena is
+// released at once by Arena_Reset, which is O(1) and keeps the chunks for reuse.
+#define ARENA_ALIGN 16
+#define ARENA_DEFAULT_CHUNK_SIZE (64 * 1024)
+
+typedef struct ArenaChunk
+{
+    struct ArenaChunk* next;
+    size_t size, used;
+    _Alignas(ARENA_ALIGN) char data[];
+} ArenaChunk;
+
+typedef struct
+{
+    ArenaChunk* first;
+    ArenaChunk* current;
+    size_t chunk_size;
+} Arena;
+
+void Arena_Initialize(Arena* self, size_t chunk_size);
+void Arena_Free(Arena* self);
+void Arena_Reset(Arena* self);
+void* Arena__AllocSlow(Arena* self, size_t size);
+void* Arena_Copy(Arena* self, const void* source, size_t size);
+
+static inline void* Arena_Alloc(Arena* self, size_t size)
+{
+    size = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+    ArenaChunk* c = self->current;
+    if(c && c->size - c->used >= size)
+    {
+        void* m = c->data + c->used;
+        c->used += size;
+        return m;
+    }
+    return Arena__AllocSlow(self, size);
+}
+
+#define ARENA_NEW(ARENA, T) ((T*)Arena_Alloc((ARENA), sizeof(T)))
+#define ARENA_ARRAY(ARENA, T, N) ((T*)Arena_Alloc((ARENA), sizeof(T) * (N)))
+
+#endif//WLANG_HEADER_ARENA_
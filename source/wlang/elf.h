@@ -0,0 +1,82 @@
+#ifndef WLANG_HEADER_ELF_
+#define WLANG_HEADER_ELF_
+#include <stdint.h>
+
+//:==========----------- ELF64 -----------==========://
+
+// The parts of the ELF64 format (System V gABI) that the built-in assembler and linker
+// write. The structures are written as they are in memory, which is only right on
+// little-endian hosts.
+
+enum { ELF_Class_64 = 2, ELF_Data_LSB = 1, ELF_Version_Current = 1 };
+enum { ELF_Type_Rel = 1, ELF_Type_Exec = 2 };
+enum { ELF_Machine_X86_64 = 62 };
+
+typedef struct
+{
+    uint8_t ident[16];
+    uint16_t type, machine;
+    uint32_t version;
+    uint64_t entry, phoff, shoff;
+    uint32_t flags;
+    uint16_t ehsize, phentsize, phnum, shentsize, shnum, shstrndx;
+} ELF_Header;
+
+enum ELF_SectionType
+{
+    ELF_SectionType_Null = 0,
+    ELF_SectionType_Progbits = 1,
+    ELF_SectionType_Symtab = 2,
+    ELF_SectionType_Strtab = 3,
+    ELF_SectionType_Rela = 4,
+};
+
+enum
+{
+    ELF_SectionFlag_Write = 0x1,
+    ELF_SectionFlag_Alloc = 0x2,
+    ELF_SectionFlag_Exec = 0x4,
+    ELF_SectionFlag_InfoLink = 0x40, // sh_info is the index of a section.
+};
+
+typedef struct
+{
+    uint32_t name, type;
+    uint64_t flags, addr, offset, size;
+    uint32_t link, info;
+    uint64_t addralign, entsize;
+} ELF_Section;
+
+enum { ELF_SymbolBind_Local = 0, ELF_SymbolBind_Global = 1 };
+enum { ELF_SymbolType_NoType = 0, ELF_SymbolType_Func = 2 };
+#define ELF_SYMBOL_INFO(BIND, TYPE) ((uint8_t)(((BIND) << 4) | (TYPE)))
+#define ELF_SECTION_UNDEF 0
+
+typedef struct
+{
+    uint32_t name;
+    uint8_t info, other;
+    uint16_t shndx;
+    uint64_t value, size;
+} ELF_Symbol;
+
+enum { ELF_SegmentType_Load = 1, ELF_SegmentType_GnuStack = 0x6474e551 };
+enum { ELF_SegmentFlag_Exec = 0x1, ELF_SegmentFlag_Write = 0x2, ELF_SegmentFlag_Read = 0x4 };
+
+typedef struct
+{
+    uint32_t type, flags;
+    uint64_t offset, vaddr, paddr, filesz, memsz, align;
+} ELF_Segment;
+
+// Relocation types of the x86-64 psABI.
+enum { ELF_Reloc_X86_64_PC32 = 2, ELF_Reloc_X86_64_PLT32 = 4 };
+#define ELF_RELA_INFO(SYMBOL, TYPE) (((uint64_t)(SYMBOL) << 32) | (uint32_t)(TYPE))
+
+typedef struct
+{
+    uint64_t offset, info;
+    int64_t addend;
+} ELF_Rela;
+
+#endif//WLANG_HEADER_ELF_
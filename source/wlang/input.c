@@ -0,0 +1,92 @@
+#include <wlang/input.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static bool InputFile__TooBig(const InputFile* self)
+{
+    fprintf(stderr, "\033[0;31mError:\033[0;0m The input '%s' is larger than %u bytes!\n", self->path, INPUT_MAX_SIZE);
+    return false;
+}
+
+static bool InputFile__ReadAll(InputFile* self, int fd)
+{
+    size_t capacity = 64 * 1024, size = 0;
+    char* data = malloc(capacity);
+    for(;;)
+    {
+        if(size == capacity) data = realloc(data, capacity *= 2);
+        ssize_t n = read(fd, data + size, capacity - size);
+        if(n < 0) { perror("Failed to read file"); free(data); return false; }
+        if(n == 0) break;
+        size += (size_t)n;
+        if(size > INPUT_MAX_SIZE) { free(data); return InputFile__TooBig(self); }
+    }
+    self->data = data;
+    self->size = size;
+    self->mapped = false;
+    return true;
+}
+
+bool InputFile_Open(InputFile* self, const char* path)
+{
+    self->data = NULL;
+    self->size = 0;
+    self->path = path;
+    self->mapped = false;
+
+    if(strcmp(path, "-") == 0)
+    {
+        self->path = "<stdin>";
+        return InputFile__ReadAll(self, STDIN_FILENO);
+    }
+
+    int fd = open(path, O_RDONLY);
+    if(fd < 0) { perror("Failed to open file"); return false; }
+
+    struct stat st;
+    bool ok = true;
+    if(fstat(fd, &st) == 0 && S_ISREG(st.st_mode))
+    {
+        // mmap cannot map an empty file, but there is nothing to read then anyway.
+        if((unsigned long long)st.st_size > INPUT_MAX_SIZE) ok = InputFile__TooBig(self);
+        else if(st.st_size > 0)
+        {
+            void* m = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if(m != MAP_FAILED)
+            {
+                madvise(m, (size_t)st.st_size, MADV_SEQUENTIAL);
+                self->data = m;
+                self->size = (size_t)st.st_size;
+                self->mapped = true;
+            }
+            else ok = InputFile__ReadAll(self, fd);
+        }
+    }
+    else ok = InputFile__ReadAll(self, fd);
+
+    close(fd);
+    return ok;
+}
+
+void InputFile_Close(InputFile* self)
+{
+    if(self->mapped) munmap((void*)self->data, self->size);
+    else free((void*)self->data);
+    self->data = NULL;
+    self->size = 0;
+}
+
+void InputFile_Location(const InputFile* self, size_t offset, size_t* line, size_t* column)
+{
+    if(offset > self->size) offset = self->size;
+    size_t l = 1, line_start = 0;
+    for(size_t i = 0; i < offset; ++i)
+        if(self->data[i] == '\n') { ++l; line_start = i + 1; }
+    *line = l;
+    *column = offset - line_start + 1;
+}
@@ -0,0 +1,29 @@
+#ifndef WLANG_HEADER_INPUT_
+#define WLANG_HEADER_INPUT_
+#include <stddef.h>
+#include <stdbool.h>
+
+//:==========----------- Source Input -----------==========://
+
+// The whole source file as one contiguous, read-only buffer. Regular files are
+// mmap'd; pipes, ttys and stdin ("-") are read in one go into a heap buffer.
+// The buffer is not null-terminated, always use `size`.
+typedef struct
+{
+    const char* data;
+    size_t size;
+    const char* path;
+    bool mapped;
+} InputFile;
+
+// Token positions are 32-bit, so inputs are limited to this many bytes.
+#define INPUT_MAX_SIZE 0xFFFFFFFFu
+
+// Fails with an error for inputs larger than INPUT_MAX_SIZE.
+bool InputFile_Open(InputFile* self, const char* path);
+void InputFile_Close(InputFile* self);
+
+// Converts a byte offset into a 1-based line and column, for diagnostics.
+void InputFile_Location(const InputFile* self, size_t offset, size_t* line, size_t* column);
+
+#endif//WLANG_HEADER_INPUT_
@@ -1,5 +1,9 @@
 #include <wlang/ir.h>
 
+DEFINE_LIST_TYPE(IR_Instr)
+DEFINE_LIST_TYPE(IR_Block)
+DEFINE_LIST_TYPE(IR_PhiArg)
+
 const char* IR_OpType_ToString(enum IR_OpType t)
 {
     static const char* strs[] =
@@ -24,9 +28,15 @@ const char* IR_OpType_ToString(enum IR_OpType t)
         "Not",
         "Bno",
         "Cpy",
-        "SetMem",
-        "SetOff",
+        "Load",
+        "Store",
+        "Param",
+        "Arg",
+        "Call",
+        "Jmp",
+        "Br",
         "Ret",
+        "Phi",
     };
     return t < IR_OpType__Last ? strs[t] : "<UNKNOWN>";
 }
@@ -54,9 +64,147 @@ const char* IR_OpType_ToString2(enum IR_OpType t)
         "Not",
         "Binary Not",
         "Copy",
-        "Set Memory",
-        "Set Offset",
+        "Load",
+        "Store",
+        "Parameter",
+        "Argument",
+        "Call",
+        "Jump",
+        "Branch",
         "Return",
+        "Phi",
     };
     return t < IR_OpType__Last ? strs[t] : "<UNKNOWN>";
 }
+
+size_t IR_Block_Successors(const IR_Block* self, size_t succ[2])
+{
+    const IR_Instr* t = IR_Block_Terminator(self);
+    if(!t) return 0;
+    switch(t->type)
+    {
+    case IR_OpType_Jmp: succ[0] = t->label; return 1;
+    case IR_OpType_Br:
+        succ[0] = t->label;
+        succ[1] = t->label_else;
+        return t->label == t->label_else ? 1 : 2;
+    default: return 0;
+    }
+}
+
+void IR_Proc_Initialize(IR_Proc* self, Symbol name)
+{
+    self->name = name;
+    self->param_count = 0;
+    IR_BlockList_Initialize(&self->blocks);
+    self->reg_count = 1;
+    self->slot_count = 0;
+    IR_PhiArgList_Initialize(&self->phi_args);
+}
+
+static void IR_Block_Free(IR_Block* self)
+{
+    IR_InstrList_Free(&self->instrs);
+}
+
+void IR_Proc_Free(IR_Proc* self)
+{
+    IR_BlockList_ForEachRef(&self->blocks, &IR_Block_Free);
+    IR_BlockList_Free(&self->blocks);
+    IR_PhiArgList_Free(&self->phi_args);
+}
+
+void IR_Proc_Copy(IR_Proc* self, const IR_Proc* other)
+{
+    IR_Proc_Initialize(self, other->name);
+    self->param_count = other->param_count;
+    self->reg_count = other->reg_count;
+    self->slot_count = other->slot_count;
+    IR_BlockList_Reserve(&self->blocks, other->blocks.count);
+    for(size_t b = 0; b < other->blocks.count; ++b)
+    {
+        IR_Block block;
+        IR_InstrList_Initialize(&block.instrs);
+        IR_InstrList_Append(&block.instrs, other->blocks.data[b].instrs.data, other->blocks.data[b].instrs.count);
+        IR_BlockList_PushValue(&self->blocks, block);
+    }
+    IR_PhiArgList_Append(&self->phi_args, other->phi_args.data, other->phi_args.count);
+}
+
+void IR_Proc_RemovePhiArgs(IR_Proc* self, size_t block, size_t pred)
+{
+    IR_InstrList* instrs = &self->blocks.data[block].instrs;
+    for(size_t i = 0; i < instrs->count && instrs->data[i].type == IR_OpType_Phi; ++i)
+    {
+        IR_Instr* phi = &instrs->data[i];
+        IR_PhiArg* args = IR_Proc_PhiArgs(self, phi);
+        size_t kept = 0;
+        for(size_t a = 0; a < phi->label_else; ++a)
+            if(args[a].block != pred) args[kept++] = args[a];
+        phi->label_else = kept;
+    }
+}
+
+static const char* IR_OpType__mnemonics[] =
+{
+    "add", "sub", "mul", "div", "eql", "neq", "grt", "lst", "geq", "leq",
+    "and", "cor", "bnd", "bor", "mod", "xor", "neg", "not", "bno", "cpy",
+    "load", "store", "param", "arg", "call", "jmp", "br", "ret", "phi",
+};
+
+static void IR_Value_Dump(IR_Value v, FILE* f)
+{
+    switch(v.type)
+    {
+    case IR_ValueType_None: fprintf(f, "_"); break;
+    case IR_ValueType_Imm: fprintf(f, "%ld", IR_Value_Imm(v)); break;
+    case IR_ValueType_Reg: fprintf(f, "%%%lu", v.value); break;
+    case IR_ValueType_Slot: fprintf(f, "[%lu]", v.value); break;
+    }
+}
+
+// One instruction per line, e.g. `%3 = add %1, 5`, `store [0], %3` or `br %4, .b1, .b2`.
+void IR_Proc_Dump(const IR_Proc* self, FILE* f)
+{
+    fprintf(f, "proc %s(%zu params, %zu slots) {\n", Symbol_Name(self->name), self->param_count, self->slot_count);
+    for(size_t b = 0; b < self->blocks.count; ++b)
+    {
+        fprintf(f, ".b%zu:\n", b);
+        const IR_InstrList* instrs = &self->blocks.data[b].instrs;
+        for(size_t i = 0; i < instrs->count; ++i)
+        {
+            const IR_Instr* in = &instrs->data[i];
+            fprintf(f, "    ");
+            if(in->dst != IR_NO_REG) fprintf(f, "%%%lu = ", in->dst);
+            fprintf(f, "%s", IR_OpType__mnemonics[in->type]);
+
+            switch(in->type)
+            {
+            case IR_OpType_Param: fprintf(f, " %zu", in->label); break;
+            case IR_OpType_Arg: fprintf(f, " %zu, ", in->label); IR_Value_Dump(in->lhs, f); break;
+            case IR_OpType_Call: fprintf(f, " %s, %ld", Symbol_Name(in->label), IR_Value_Imm(in->lhs)); break;
+            case IR_OpType_Jmp: fprintf(f, " .b%zu", in->label); break;
+            case IR_OpType_Phi:
+                for(size_t a = 0; a < in->label_else; ++a)
+                {
+                    const IR_PhiArg* arg = &IR_Proc_PhiArgs(self, in)[a];
+                    fprintf(f, "%s [.b%zu: ", a ? "," : "", arg->block);
+                    IR_Value_Dump(arg->value, f);
+                    fprintf(f, "]");
+                }
+                break;
+            case IR_OpType_Br:
+                fprintf(f, " ");
+                IR_Value_Dump(in->lhs, f);
+                fprintf(f, ", .b%zu, .b%zu", in->label, in->label_else);
+                break;
+            default:
+                if(in->lhs.type != IR_ValueType_None) { fprintf(f, " "); IR_Value_Dump(in->lhs, f); }
+                if(in->rhs.type != IR_ValueType_None) { fprintf(f, ", "); IR_Value_Dump(in->rhs, f); }
+                break;
+            }
+            fputc('\n', f);
+        }
+    }
+    fprintf(f, "}\n");
+}
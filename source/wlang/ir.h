@@ -1,6 +1,8 @@
 #ifndef WLANG_HEADER_IR_
 #define WLANG_HEADER_IR_
+#include <stdio.h>
 #include "type.h"
+#include "symbol.h"
 
 enum IR_OpType
 {
@@ -24,10 +26,15 @@ enum IR_OpType
     IR_OpType_Not, // !
     IR_OpType_Bno, // ~
     IR_OpType_Mov, // cpy X <- Y
-    IR_OpType_SetMem, // setmem ADDR <- X
-    IR_OpType_SetOff, // setoff OFFSET <- X
-    IR_OpType_Call, // ret X
+    IR_OpType_Load, // load X <- SLOT
+    IR_OpType_Store, // store SLOT <- X
+    IR_OpType_Param, // param X <- INDEX
+    IR_OpType_Arg, // arg INDEX <- X
+    IR_OpType_Call, // call X <- FUNC
+    IR_OpType_Jmp, // jmp BLOCK
+    IR_OpType_Br, // br X ? BLOCK : BLOCK
     IR_OpType_Ret, // ret X
+    IR_OpType_Phi, // phi X <- [BLOCK: Y]...
     IR_OpType__Last,
 };
 
@@ -37,18 +44,84 @@ const char* IR_OpType_ToString2(enum IR_OpType t);
 typedef unsigned long IR_V;
 enum IR_ValueType
 {
+    IR_ValueType_None,
     IR_ValueType_Imm,
-    IR_ValueType_Reg,
-    IR_ValueType_Mem,
+    IR_ValueType_Reg, // Virtual register, numbered from 1.
+    IR_ValueType_Slot, // Stack slot of a local variable, numbered from 0.
 };
 
+#define IR_NO_REG ((IR_V)0)
+
 typedef struct { enum IR_ValueType type; IR_V value; } IR_Value;
-typedef struct { enum IR_OpType type; IR_Value lhs, rhs; size_t label; } IR_Instr;
-DECLARE_LIST_TYPE(IR_Instr);
 
-#define IR_VALUE_MACRO_(V, TYP) ((IR_Value){ .type = IR_ValueType_##TYP, (V) })
+// Three-address instruction, `dst = lhs op rhs`. Which fields are used depends on the op:
+//   Param/Arg:  `label` is the argument index.
+//   Call:       `label` is the callee's Symbol, `lhs` the argument count. Preceded by its Args.
+//   Jmp:        `label` is the target block.
+//   Br:         goes to `label` if `lhs` is non-zero and to `label_else` otherwise.
+//   Load/Store: `lhs` is the slot, Store writes `rhs` to it.
+//   Phi:        takes its arguments from IR_Proc.phi_args, `label_else` of them from `label` on.
+//               Phis only exist in SSA form and always come first in their block.
+typedef struct
+{
+    enum IR_OpType type;
+    IR_V dst;
+    IR_Value lhs, rhs;
+    size_t label, label_else;
+} IR_Instr;
+DECLARE_LIST_TYPE(IR_Instr)
+
+#define IR_VALUE_MACRO_(TYP, V) ((IR_Value){ IR_ValueType_##TYP, (IR_V)(V) })
 #define IR_VALUE_REG(REG) IR_VALUE_MACRO_(Reg, REG)
 #define IR_VALUE_IMM(IMM) IR_VALUE_MACRO_(Imm, IMM)
-#define IR_VALUE_MEM(MEM) IR_VALUE_MACRO_(Mem, MEM)
+#define IR_VALUE_SLOT(SLOT) IR_VALUE_MACRO_(Slot, SLOT)
+#define IR_VALUE_NONE IR_VALUE_MACRO_(None, 0)
+
+static inline long IR_Value_Imm(IR_Value v) { return (long)v.value; }
+static inline bool IR_Value_Equal(IR_Value a, IR_Value b) { return a.type == b.type && a.value == b.value; }
+
+// The value a phi takes when control comes from `block`.
+typedef struct { size_t block; IR_Value value; } IR_PhiArg;
+DECLARE_LIST_TYPE(IR_PhiArg)
+
+static inline bool IR_Instr_IsTerminator(const IR_Instr* instr)
+{ return instr->type == IR_OpType_Jmp || instr->type == IR_OpType_Br || instr->type == IR_OpType_Ret; }
+
+// A straight-line run of instructions that ends with its only terminator. Falling
+// through to the next block is left to the code generator, which drops such jumps.
+typedef struct
+{
+    IR_InstrList instrs;
+} IR_Block;
+DECLARE_LIST_TYPE(IR_Block)
+
+typedef struct
+{
+    Symbol name;
+    size_t param_count;
+    IR_BlockList blocks; // The first block is the entry.
+    IR_V reg_count; // Registers are in [1, reg_count).
+    size_t slot_count;
+    IR_PhiArgList phi_args;
+} IR_Proc;
+
+static inline IR_PhiArg* IR_Proc_PhiArgs(const IR_Proc* self, const IR_Instr* phi)
+{ return self->phi_args.data + phi->label; }
+
+// Drops the arguments of the phis in `block` that come from `pred`, for when the edge
+// between them goes away.
+void IR_Proc_RemovePhiArgs(IR_Proc* self, size_t block, size_t pred);
+
+static inline const IR_Instr* IR_Block_Terminator(const IR_Block* self)
+{ return self->instrs.count ? &self->instrs.data[self->instrs.count - 1] : NULL; }
+
+// Writes the blocks control can go to after `self` and returns how many there are.
+size_t IR_Block_Successors(const IR_Block* self, size_t succ[2]);
+
+void IR_Proc_Initialize(IR_Proc* self, Symbol name);
+void IR_Proc_Free(IR_Proc* self);
+// Makes `self` an independent copy of `other`.
+void IR_Proc_Copy(IR_Proc* self, const IR_Proc* other);
+void IR_Proc_Dump(const IR_Proc* self, FILE* f);
 
 #endif
@@ -0,0 +1,177 @@
+#include <wlang/iropt.h>
+#include <string.h>
+
+// Numbers the blocks reachable from the entry in reverse postorder, which puts every
+// block before its successors except along back edges.
+static void IR_Cfg__Order(IR_Cfg* self, Arena* scratch)
+{
+    size_t n = self->block_count;
+    size_t* stack = ARENA_ARRAY(scratch, size_t, n + 1);
+    size_t* next = ARENA_ARRAY(scratch, size_t, n + 1); // Next successor to visit, per block on the stack.
+    size_t* post = ARENA_ARRAY(scratch, size_t, n + 1);
+    size_t depth = 0, post_count = 0;
+
+    for(size_t b = 0; b < n; ++b) self->order_index[b] = IR_CFG_UNREACHABLE;
+    if(!n) { self->order_count = 0; return; }
+
+    self->order_index[0] = 0; // Marks the entry as visited.
+    stack[depth] = 0;
+    next[depth++] = 0;
+    while(depth)
+    {
+        size_t b = stack[depth - 1];
+        if(next[depth - 1] < self->succ_count[b])
+        {
+            size_t s = self->succ[2 * b + next[depth - 1]++];
+            if(self->order_index[s] != IR_CFG_UNREACHABLE) continue;
+            self->order_index[s] = 0;
+            stack[depth] = s;
+            next[depth++] = 0;
+            continue;
+        }
+        post[post_count++] = b;
+        --depth;
+    }
+
+    self->order_count = post_count;
+    for(size_t i = 0; i < post_count; ++i)
+    {
+        self->order[i] = post[post_count - 1 - i];
+        self->order_index[self->order[i]] = i;
+    }
+}
+
+static size_t IR_Cfg__Intersect(const IR_Cfg* self, size_t a, size_t b)
+{
+    while(a != b)
+    {
+        while(self->order_index[a] > self->order_index[b]) a = self->idom[a];
+        while(self->order_index[b] > self->order_index[a]) b = self->idom[b];
+    }
+    return a;
+}
+
+// Cooper, Harvey and Kennedy's "A Simple, Fast Dominance Algorithm": iterate over the
+// blocks in reverse postorder until the immediate dominators settle, which takes two or
+// three rounds for anything that isn't pathological.
+static void IR_Cfg__Dominators(IR_Cfg* self)
+{
+    for(size_t b = 0; b < self->block_count; ++b) self->idom[b] = IR_CFG_UNREACHABLE;
+    if(!self->order_count) return;
+    self->idom[0] = 0;
+
+    bool changed = true;
+    while(changed)
+    {
+        changed = false;
+        for(size_t i = 1; i < self->order_count; ++i)
+        {
+            size_t b = self->order[i], idom = IR_CFG_UNREACHABLE;
+            for(size_t p = self->pred_start[b]; p < self->pred_start[b + 1]; ++p)
+            {
+                size_t pred = self->preds[p];
+                if(self->idom[pred] == IR_CFG_UNREACHABLE) continue;
+                idom = idom == IR_CFG_UNREACHABLE ? pred : IR_Cfg__Intersect(self, pred, idom);
+            }
+            if(self->idom[b] == idom) continue;
+            self->idom[b] = idom;
+            changed = true;
+        }
+    }
+}
+
+void IR_Cfg_Build(IR_Cfg* self, const IR_Proc* proc, Arena* scratch)
+{
+    size_t n = proc->blocks.count;
+    self->block_count = n;
+    self->succ = ARENA_ARRAY(scratch, size_t, 2 * n + 1);
+    self->succ_count = ARENA_ARRAY(scratch, uint8_t, n + 1);
+    self->pred_start = ARENA_ARRAY(scratch, size_t, n + 1);
+    self->order = ARENA_ARRAY(scratch, size_t, n + 1);
+    self->order_index = ARENA_ARRAY(scratch, size_t, n + 1);
+    self->idom = ARENA_ARRAY(scratch, size_t, n + 1);
+    memset(self->pred_start, 0, sizeof(size_t) * (n + 1));
+
+    // Count the predecessors first so they can be laid out in one array.
+    size_t edges = 0;
+    for(size_t b = 0; b < n; ++b)
+    {
+        self->succ_count[b] = (uint8_t)IR_Block_Successors(&proc->blocks.data[b], &self->succ[2 * b]);
+        for(size_t s = 0; s < self->succ_count[b]; ++s) ++self->pred_start[self->succ[2 * b + s]];
+        edges += self->succ_count[b];
+    }
+    for(size_t b = 0, start = 0; b <= n; ++b)
+    {
+        size_t count = b < n ? self->pred_start[b] : 0;
+        self->pred_start[b] = start;
+        start += count;
+    }
+    self->preds = ARENA_ARRAY(scratch, size_t, edges + 1);
+    size_t* fill = ARENA_ARRAY(scratch, size_t, n + 1);
+    memcpy(fill, self->pred_start, sizeof(size_t) * (n + 1));
+    for(size_t b = 0; b < n; ++b)
+        for(size_t s = 0; s < self->succ_count[b]; ++s)
+            self->preds[fill[self->succ[2 * b + s]]++] = b;
+
+    IR_Cfg__Order(self, scratch);
+    IR_Cfg__Dominators(self);
+}
+
+bool IR_Cfg_Dominates(const IR_Cfg* self, size_t a, size_t b)
+{
+    if(!IR_Cfg_IsReachable(self, a) || !IR_Cfg_IsReachable(self, b)) return false;
+    // Dominators come earlier in reverse postorder, so the walk up can stop there.
+    while(self->order_index[b] > self->order_index[a]) b = self->idom[b];
+    return a == b;
+}
+
+bool IR_RemoveUnreachableBlocks(IR_Proc* proc, Arena* scratch)
+{
+    IR_Cfg cfg;
+    IR_Cfg_Build(&cfg, proc, scratch);
+    if(cfg.order_count == cfg.block_count) return false;
+
+    // Kept blocks stay in their order, the layout is the code generator's fallthrough.
+    size_t* map = ARENA_ARRAY(scratch, size_t, cfg.block_count);
+    size_t kept = 0;
+    for(size_t b = 0; b < cfg.block_count; ++b)
+    {
+        IR_Block* block = &proc->blocks.data[b];
+        if(!IR_Cfg_IsReachable(&cfg, b))
+        {
+            IR_InstrList_Free(&block->instrs);
+            continue;
+        }
+        map[b] = kept;
+        proc->blocks.data[kept++] = *block;
+    }
+    proc->blocks.count = kept;
+
+    for(size_t b = 0; b < kept; ++b)
+    {
+        IR_InstrList* instrs = &proc->blocks.data[b].instrs;
+        for(size_t i = 0; i < instrs->count; ++i)
+        {
+            IR_Instr* in = &instrs->data[i];
+            if(in->type == IR_OpType_Jmp) in->label = map[in->label];
+            else if(in->type == IR_OpType_Br)
+            {
+                in->label = map[in->label];
+                in->label_else = map[in->label_else];
+            }
+            else if(in->type == IR_OpType_Phi)
+            {
+                IR_PhiArg* args = IR_Proc_PhiArgs(proc, in);
+                size_t count = 0;
+                for(size_t a = 0; a < in->label_else; ++a)
+                {
+                    if(!IR_Cfg_IsReachable(&cfg, args[a].block)) continue;
+                    args[count] = args[a];
+                    args[count++].block = map[args[a].block];
+                }
+                in->label_else = count;
+            }
+        }
+    }
+    return true;
+}
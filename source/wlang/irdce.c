@@ -0,0 +1,122 @@
+#include <wlang/iropt.h>
+#include <string.h>
+
+// Whether an instruction has to stay even if nothing uses its result. Division is only
+// pure when the divisor is known not to trap.
+static bool IR__HasEffect(const IR_Instr* in, const bool* read_slots)
+{
+    switch(in->type)
+    {
+    case IR_OpType_Store: return read_slots[in->lhs.value];
+    case IR_OpType_Arg:
+    case IR_OpType_Call:
+    case IR_OpType_Jmp:
+    case IR_OpType_Br:
+    case IR_OpType_Ret: return true;
+    case IR_OpType_Div:
+    case IR_OpType_Mod:
+        return in->rhs.type != IR_ValueType_Imm || IR_Value_Imm(in->rhs) == 0 || IR_Value_Imm(in->rhs) == -1;
+    default: return false;
+    }
+}
+
+typedef struct
+{
+    IR_Proc* proc;
+    IR_Instr** instrs;  // Every instruction of the procedure, numbered in block order.
+    size_t* next_def;   // Per instruction, the next one that writes the same register.
+    size_t* first_def;  // Per register.
+    bool* live;         // Per instruction.
+    bool* used;         // Per register.
+    size_t* work;
+    size_t work_count;
+} IR_DeadCode;
+
+#define IR_DCE_NONE ((size_t)-1)
+
+static void IR_DeadCode__Keep(IR_DeadCode* self, size_t instr)
+{
+    if(self->live[instr]) return;
+    self->live[instr] = true;
+    self->work[self->work_count++] = instr;
+}
+
+static void IR_DeadCode__Use(IR_DeadCode* self, IR_Value v)
+{
+    if(v.type != IR_ValueType_Reg || self->used[v.value]) return;
+    self->used[v.value] = true;
+    // Outside of SSA form a register can have several definitions, all of them matter.
+    for(size_t d = self->first_def[v.value]; d != IR_DCE_NONE; d = self->next_def[d])
+        IR_DeadCode__Keep(self, d);
+}
+
+bool IR_EliminateDeadCode(IR_Proc* proc, Arena* scratch)
+{
+    bool modified = IR_RemoveUnreachableBlocks(proc, scratch);
+
+    size_t count = 0;
+    bool* read_slots = ARENA_ARRAY(scratch, bool, proc->slot_count + 1);
+    memset(read_slots, 0, sizeof(bool) * (proc->slot_count + 1));
+    for(size_t b = 0; b < proc->blocks.count; ++b)
+    {
+        const IR_InstrList* instrs = &proc->blocks.data[b].instrs;
+        for(size_t i = 0; i < instrs->count; ++i)
+            if(instrs->data[i].type == IR_OpType_Load) read_slots[instrs->data[i].lhs.value] = true;
+        count += instrs->count;
+    }
+
+    IR_DeadCode self = { .proc = proc };
+    self.instrs = ARENA_ARRAY(scratch, IR_Instr*, count + 1);
+    self.next_def = ARENA_ARRAY(scratch, size_t, count + 1);
+    self.first_def = ARENA_ARRAY(scratch, size_t, proc->reg_count);
+    self.live = ARENA_ARRAY(scratch, bool, count + 1);
+    self.used = ARENA_ARRAY(scratch, bool, proc->reg_count);
+    self.work = ARENA_ARRAY(scratch, size_t, count + 1);
+    memset(self.live, 0, sizeof(bool) * count);
+    memset(self.used, 0, sizeof(bool) * proc->reg_count);
+    for(size_t r = 0; r < proc->reg_count; ++r) self.first_def[r] = IR_DCE_NONE;
+
+    size_t n = 0;
+    for(size_t b = 0; b < proc->blocks.count; ++b)
+    {
+        IR_InstrList* instrs = &proc->blocks.data[b].instrs;
+        for(size_t i = 0; i < instrs->count; ++i, ++n)
+        {
+            IR_Instr* in = &instrs->data[i];
+            self.instrs[n] = in;
+            self.next_def[n] = IR_DCE_NONE;
+            if(in->dst != IR_NO_REG)
+            {
+                self.next_def[n] = self.first_def[in->dst];
+                self.first_def[in->dst] = n;
+            }
+            if(IR__HasEffect(in, read_slots)) IR_DeadCode__Keep(&self, n);
+        }
+    }
+
+    // Everything a kept instruction reads is kept too.
+    while(self.work_count)
+    {
+        const IR_Instr* in = self.instrs[self.work[--self.work_count]];
+        if(in->type == IR_OpType_Phi)
+        {
+            const IR_PhiArg* args = IR_Proc_PhiArgs(proc, in);
+            for(size_t a = 0; a < in->label_else; ++a) IR_DeadCode__Use(&self, args[a].value);
+            continue;
+        }
+        IR_DeadCode__Use(&self, in->lhs);
+        IR_DeadCode__Use(&self, in->rhs);
+    }
+
+    n = 0;
+    for(size_t b = 0; b < proc->blocks.count; ++b)
+    {
+        IR_InstrList* instrs = &proc->blocks.data[b].instrs;
+        size_t kept = 0;
+        for(size_t i = 0; i < instrs->count; ++i, ++n)
+            if(self.live[n]) instrs->data[kept++] = instrs->data[i];
+        if(kept != instrs->count) modified = true;
+        instrs->count = kept;
+    }
+    return modified;
+}
@@ -0,0 +1,247 @@
+#include <wlang/iropt.h>
+#include <limits.h>
+#include <string.h>
+
+// What is known about a value: nothing yet, a single constant, or that it varies.
+// Facts only ever move down that list, which is what makes the propagation finish.
+enum IR_ConstState { IR_ConstState_Unknown, IR_ConstState_Value, IR_ConstState_Varying };
+typedef struct { enum IR_ConstState state; long value; } IR_Const;
+
+#define IR_CONST_VARYING ((IR_Const){ IR_ConstState_Varying, 0 })
+#define IR_CONST_VALUE(V) ((IR_Const){ IR_ConstState_Value, (V) })
+
+static inline IR_Const IR_Const_Meet(IR_Const a, IR_Const b)
+{
+    if(a.state == IR_ConstState_Unknown) return b;
+    if(b.state == IR_ConstState_Unknown) return a;
+    if(a.state == IR_ConstState_Value && b.state == IR_ConstState_Value && a.value == b.value) return a;
+    return IR_CONST_VARYING;
+}
+
+static inline bool IR_Const_Equal(IR_Const a, IR_Const b)
+{ return a.state == b.state && (a.state != IR_ConstState_Value || a.value == b.value); }
+
+bool IR_EvalOp(enum IR_OpType op, long lhs, long rhs, long* result)
+{
+    // Wrapping arithmetic, like the machine does it.
+    unsigned long a = (unsigned long)lhs, b = (unsigned long)rhs;
+    switch(op)
+    {
+    case IR_OpType_Add: *result = (long)(a + b); return true;
+    case IR_OpType_Sub: *result = (long)(a - b); return true;
+    case IR_OpType_Mul: *result = (long)(a * b); return true;
+    case IR_OpType_Div:
+    case IR_OpType_Mod:
+        if(rhs == 0 || (lhs == LONG_MIN && rhs == -1)) return false;
+        *result = op == IR_OpType_Div ? lhs / rhs : lhs % rhs;
+        return true;
+    case IR_OpType_Eql: *result = lhs == rhs; return true;
+    case IR_OpType_Neq: *result = lhs != rhs; return true;
+    case IR_OpType_Grt: *result = lhs > rhs; return true;
+    case IR_OpType_Lst: *result = lhs < rhs; return true;
+    case IR_OpType_Geq: *result = lhs >= rhs; return true;
+    case IR_OpType_Leq: *result = lhs <= rhs; return true;
+    case IR_OpType_And: *result = lhs && rhs; return true;
+    case IR_OpType_Cor: *result = lhs || rhs; return true;
+    case IR_OpType_Bnd: *result = (long)(a & b); return true;
+    case IR_OpType_Bor: *result = (long)(a | b); return true;
+    case IR_OpType_Xor: *result = (long)(a ^ b); return true;
+    case IR_OpType_Neg: *result = (long)(0 - a); return true;
+    case IR_OpType_Not: *result = !lhs; return true;
+    case IR_OpType_Bno: *result = (long)~a; return true;
+    case IR_OpType_Mov: *result = lhs; return true;
+    default: return false;
+    }
+}
+
+typedef struct
+{
+    IR_Proc* proc;
+    IR_Const* regs;   // Per virtual register.
+    IR_Const* in;     // Per block, the value of every slot when the block is entered.
+    IR_Const* slots;  // Slot values while walking a block.
+    bool* executable; // Per block, whether control can reach it.
+    bool changed;
+} IR_Folder;
+
+static IR_Const IR_Folder__Value(IR_Folder* self, IR_Value v)
+{
+    switch(v.type)
+    {
+    case IR_ValueType_Imm: return IR_CONST_VALUE(IR_Value_Imm(v));
+    case IR_ValueType_Reg: return self->regs[v.value];
+    default: return IR_CONST_VARYING;
+    }
+}
+
+static void IR_Folder__SetReg(IR_Folder* self, IR_V reg, IR_Const c)
+{
+    IR_Const m = IR_Const_Meet(self->regs[reg], c);
+    if(IR_Const_Equal(m, self->regs[reg])) return;
+    self->regs[reg] = m;
+    self->changed = true;
+}
+
+// Control can go from the block being walked to `to`, merge what is known there.
+static void IR_Folder__Flow(IR_Folder* self, size_t to)
+{
+    size_t slot_count = self->proc->slot_count;
+    IR_Const* in = self->in + to * slot_count;
+    if(!self->executable[to])
+    {
+        self->executable[to] = true;
+        if(slot_count) memcpy(in, self->slots, sizeof(IR_Const) * slot_count);
+        self->changed = true;
+        return;
+    }
+    for(size_t s = 0; s < slot_count; ++s)
+    {
+        IR_Const m = IR_Const_Meet(in[s], self->slots[s]);
+        if(IR_Const_Equal(m, in[s])) continue;
+        in[s] = m;
+        self->changed = true;
+    }
+}
+
+// Whether control can currently be seen going from `from` to its successor `to`.
+static bool IR_Folder__EdgeTaken(IR_Folder* self, size_t from, size_t to)
+{
+    if(!self->executable[from]) return false;
+    const IR_Instr* t = IR_Block_Terminator(&self->proc->blocks.data[from]);
+    if(!t || t->type != IR_OpType_Br) return true;
+    IR_Const cond = IR_Folder__Value(self, t->lhs);
+    if(cond.state == IR_ConstState_Value) return (cond.value ? t->label : t->label_else) == to;
+    return cond.state == IR_ConstState_Varying;
+}
+
+static void IR_Folder__VisitBlock(IR_Folder* self, size_t block)
+{
+    size_t slot_count = self->proc->slot_count;
+    if(slot_count) memcpy(self->slots, self->in + block * slot_count, sizeof(IR_Const) * slot_count);
+
+    const IR_InstrList* instrs = &self->proc->blocks.data[block].instrs;
+    for(size_t i = 0; i < instrs->count; ++i)
+    {
+        const IR_Instr* in = &instrs->data[i];
+        switch(in->type)
+        {
+        case IR_OpType_Load: IR_Folder__SetReg(self, in->dst, self->slots[in->lhs.value]); break;
+        case IR_OpType_Store: self->slots[in->lhs.value] = IR_Folder__Value(self, in->rhs); break;
+        case IR_OpType_Phi:
+        {
+            // Arguments from edges that aren't taken (yet) don't count.
+            IR_Const c = { IR_ConstState_Unknown, 0 };
+            const IR_PhiArg* args = IR_Proc_PhiArgs(self->proc, in);
+            for(size_t a = 0; a < in->label_else; ++a)
+                if(IR_Folder__EdgeTaken(self, args[a].block, block))
+                    c = IR_Const_Meet(c, IR_Folder__Value(self, args[a].value));
+            IR_Folder__SetReg(self, in->dst, c);
+        } break;
+        case IR_OpType_Jmp: IR_Folder__Flow(self, in->label); break;
+        case IR_OpType_Br:
+        {
+            IR_Const cond = IR_Folder__Value(self, in->lhs);
+            if(cond.state == IR_ConstState_Value)
+                IR_Folder__Flow(self, cond.value ? in->label : in->label_else);
+            else if(cond.state == IR_ConstState_Varying)
+            {
+                IR_Folder__Flow(self, in->label);
+                IR_Folder__Flow(self, in->label_else);
+            }
+        } break;
+        case IR_OpType_Ret:
+        case IR_OpType_Arg: break;
+        case IR_OpType_Param:
+        case IR_OpType_Call: IR_Folder__SetReg(self, in->dst, IR_CONST_VARYING); break;
+        default:
+        {
+            IR_Const a = IR_Folder__Value(self, in->lhs);
+            IR_Const b = in->rhs.type == IR_ValueType_None ? IR_CONST_VALUE(0) : IR_Folder__Value(self, in->rhs);
+            long result;
+            if(a.state == IR_ConstState_Varying || b.state == IR_ConstState_Varying)
+                IR_Folder__SetReg(self, in->dst, IR_CONST_VARYING);
+            else if(a.state == IR_ConstState_Value && b.state == IR_ConstState_Value)
+                IR_Folder__SetReg(self, in->dst, IR_EvalOp(in->type, a.value, b.value, &result)
+                                                 ? IR_CONST_VALUE(result) : IR_CONST_VARYING);
+        } break;
+        }
+    }
+}
+
+static IR_Value IR_Folder__Substitute(IR_Folder* self, IR_Value v)
+{
+    if(v.type == IR_ValueType_Reg && self->regs[v.value].state == IR_ConstState_Value)
+        return IR_VALUE_IMM(self->regs[v.value].value);
+    return v;
+}
+
+bool IR_FoldConstants(IR_Proc* proc, Arena* scratch)
+{
+    size_t block_count = proc->blocks.count, slot_count = proc->slot_count;
+    IR_Folder self = { .proc = proc };
+    self.regs = ARENA_ARRAY(scratch, IR_Const, proc->reg_count);
+    self.in = ARENA_ARRAY(scratch, IR_Const, block_count * slot_count + 1);
+    self.slots = ARENA_ARRAY(scratch, IR_Const, slot_count + 1);
+    self.executable = ARENA_ARRAY(scratch, bool, block_count);
+    size_t* dropped = ARENA_ARRAY(scratch, size_t, block_count); // Per block, the edge its branch no longer takes.
+    memset(self.regs, 0, sizeof(IR_Const) * proc->reg_count);
+    memset(self.executable, 0, sizeof(bool) * block_count);
+
+    // Locals are uninitialized on entry.
+    self.executable[0] = true;
+    for(size_t s = 0; s < slot_count; ++s) self.in[s] = IR_CONST_VARYING;
+
+    do
+    {
+        self.changed = false;
+        for(size_t b = 0; b < block_count; ++b)
+            if(self.executable[b]) IR_Folder__VisitBlock(&self, b);
+    }
+    while(self.changed);
+
+    // Unreachable blocks are left alone apart from using the constants, removing them
+    // is up to dead code elimination.
+    bool modified = false;
+    for(size_t i = 0; i < proc->phi_args.count; ++i)
+    {
+        IR_PhiArg* arg = &proc->phi_args.data[i];
+        IR_Value v = IR_Folder__Substitute(&self, arg->value);
+        if(v.type != arg->value.type) modified = true;
+        arg->value = v;
+    }
+    for(size_t b = 0; b < block_count; ++b)
+    {
+        dropped[b] = IR_CFG_UNREACHABLE;
+        IR_InstrList* instrs = &proc->blocks.data[b].instrs;
+        size_t kept = 0;
+        for(size_t i = 0; i < instrs->count; ++i)
+        {
+            IR_Instr in = instrs->data[i];
+            IR_Value lhs = IR_Folder__Substitute(&self, in.lhs), rhs = IR_Folder__Substitute(&self, in.rhs);
+            if(lhs.type != in.lhs.type || rhs.type != in.rhs.type) modified = true;
+            in.lhs = lhs;
+            in.rhs = rhs;
+
+            if(self.executable[b])
+            {
+                // Only pure ops can have a constant result, so the instruction can go.
+                if(in.dst != IR_NO_REG && self.regs[in.dst].state == IR_ConstState_Value)
+                {
+                    modified = true;
+                    continue;
+                }
+                if(in.type == IR_OpType_Br && in.lhs.type == IR_ValueType_Imm)
+                {
+                    if(in.label != in.label_else) dropped[b] = IR_Value_Imm(in.lhs) ? in.label_else : in.label;
+                    in = (IR_Instr){ .type = IR_OpType_Jmp, .label = IR_Value_Imm(in.lhs) ? in.label : in.label_else };
+                    modified = true;
+                }
+            }
+            instrs->data[kept++] = in;
+        }
+        instrs->count = kept;
+    }
+    for(size_t b = 0; b < block_count; ++b)
+        if(dropped[b] != IR_CFG_UNREACHABLE) IR_Proc_RemovePhiArgs(proc, dropped[b], b);
+    return modified;
+}
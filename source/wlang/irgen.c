@@ -0,0 +1,98 @@
+#include <wlang/irgen.h>
+
+DEFINE_LIST_TYPE(IR_Hole)
+
+void IR_Builder_Begin(IR_Builder* self, IR_Proc* proc)
+{
+    self->proc = proc;
+    self->block = IR_Builder_NewBlock(self);
+}
+
+size_t IR_Builder_NewBlock(IR_Builder* self)
+{
+    IR_Block block;
+    IR_InstrList_Initialize(&block.instrs);
+    IR_BlockList_PushValue(&self->proc->blocks, block);
+    return self->proc->blocks.count - 1;
+}
+
+bool IR_Builder_IsTerminated(const IR_Builder* self)
+{
+    const IR_InstrList* instrs = &self->proc->blocks.data[self->block].instrs;
+    return instrs->count && IR_Instr_IsTerminator(&instrs->data[instrs->count - 1]);
+}
+
+IR_Instr* IR_Builder_Emit(IR_Builder* self, IR_Instr instr)
+{
+    if(IR_Builder_IsTerminated(self)) self->block = IR_Builder_NewBlock(self);
+    return IR_InstrList_PushValue(&self->proc->blocks.data[self->block].instrs, instr);
+}
+
+IR_Value IR_Builder_Binary(IR_Builder* self, enum IR_OpType op, IR_Value lhs, IR_Value rhs)
+{
+    IR_V dst = IR_Builder_NewReg(self);
+    IR_Builder_Emit(self, (IR_Instr){ .type = op, .dst = dst, .lhs = lhs, .rhs = rhs });
+    return IR_VALUE_REG(dst);
+}
+
+IR_Value IR_Builder_Unary(IR_Builder* self, enum IR_OpType op, IR_Value value)
+{
+    return IR_Builder_Binary(self, op, value, IR_VALUE_NONE);
+}
+
+IR_Value IR_Builder_Load(IR_Builder* self, size_t slot)
+{
+    return IR_Builder_Binary(self, IR_OpType_Load, IR_VALUE_SLOT(slot), IR_VALUE_NONE);
+}
+
+void IR_Builder_Store(IR_Builder* self, size_t slot, IR_Value value)
+{
+    IR_Builder_Emit(self, (IR_Instr){ .type = IR_OpType_Store, .lhs = IR_VALUE_SLOT(slot), .rhs = value });
+}
+
+IR_Value IR_Builder_Param(IR_Builder* self, size_t index)
+{
+    IR_V dst = IR_Builder_NewReg(self);
+    IR_Builder_Emit(self, (IR_Instr){ .type = IR_OpType_Param, .dst = dst, .label = index });
+    return IR_VALUE_REG(dst);
+}
+
+void IR_Builder_Arg(IR_Builder* self, size_t index, IR_Value value)
+{
+    IR_Builder_Emit(self, (IR_Instr){ .type = IR_OpType_Arg, .lhs = value, .label = index });
+}
+
+IR_Value IR_Builder_Call(IR_Builder* self, Symbol func, size_t arg_count)
+{
+    IR_V dst = IR_Builder_NewReg(self);
+    IR_Builder_Emit(self, (IR_Instr){ .type = IR_OpType_Call, .dst = dst, .lhs = IR_VALUE_IMM(arg_count), .label = func });
+    return IR_VALUE_REG(dst);
+}
+
+void IR_Builder_Jmp(IR_Builder* self, size_t target)
+{
+    IR_Builder_Emit(self, (IR_Instr){ .type = IR_OpType_Jmp, .label = target });
+}
+
+void IR_Builder_Br(IR_Builder* self, IR_Value cond, size_t then, size_t othr)
+{
+    IR_Builder_Emit(self, (IR_Instr){ .type = IR_OpType_Br, .lhs = cond, .label = then, .label_else = othr });
+}
+
+void IR_Builder_Ret(IR_Builder* self, IR_Value value)
+{
+    IR_Builder_Emit(self, (IR_Instr){ .type = IR_OpType_Ret, .lhs = value });
+}
+
+void IR_Builder_Patch(IR_Builder* self, IR_HoleList* holes, size_t mark, size_t target)
+{
+    for(size_t i = mark; i < holes->count; ++i)
+    {
+        const IR_Hole* hole = &holes->data[i];
+        IR_InstrList* instrs = &self->proc->blocks.data[hole->block].instrs;
+        IR_Instr* jump = &instrs->data[instrs->count - 1];
+        if(hole->othr) jump->label_else = target;
+        else jump->label = target;
+    }
+    holes->count = mark;
+}
@@ -1,6 +1,46 @@
 #ifndef WLANG_HEADER_IRGEN_
 #define WLANG_HEADER_IRGEN_
+#include <wlang/ir.h>
 
+//:==========----------- IR Builder -----------==========://
 
+// Appends instructions to one block of a procedure at a time. Anything emitted after a
+// terminator goes to a fresh block that nothing jumps to, so the caller doesn't have
+// to track dead code itself.
+typedef struct
+{
+    IR_Proc* proc;
+    size_t block;
+} IR_Builder;
+
+// A jump whose target isn't known yet: the `label`, or the `label_else` if `othr`, of the
+// terminator of `block`.
+typedef struct { size_t block; bool othr; } IR_Hole;
+DECLARE_LIST_TYPE(IR_Hole)
+
+void IR_Builder_Begin(IR_Builder* self, IR_Proc* proc);
+
+size_t IR_Builder_NewBlock(IR_Builder* self);
+static inline void IR_Builder_SetBlock(IR_Builder* self, size_t block) { self->block = block; }
+bool IR_Builder_IsTerminated(const IR_Builder* self);
+
+static inline IR_V IR_Builder_NewReg(IR_Builder* self) { return self->proc->reg_count++; }
+static inline size_t IR_Builder_NewSlot(IR_Builder* self) { return self->proc->slot_count++; }
+
+IR_Instr* IR_Builder_Emit(IR_Builder* self, IR_Instr instr);
+
+IR_Value IR_Builder_Binary(IR_Builder* self, enum IR_OpType op, IR_Value lhs, IR_Value rhs);
+IR_Value IR_Builder_Unary(IR_Builder* self, enum IR_OpType op, IR_Value value);
+IR_Value IR_Builder_Load(IR_Builder* self, size_t slot);
+void IR_Builder_Store(IR_Builder* self, size_t slot, IR_Value value);
+IR_Value IR_Builder_Param(IR_Builder* self, size_t index);
+void IR_Builder_Arg(IR_Builder* self, size_t index, IR_Value value);
+IR_Value IR_Builder_Call(IR_Builder* self, Symbol func, size_t arg_count);
+void IR_Builder_Jmp(IR_Builder* self, size_t target);
+void IR_Builder_Br(IR_Builder* self, IR_Value cond, size_t then, size_t othr);
+void IR_Builder_Ret(IR_Builder* self, IR_Value value);
+
+// Points the holes from `mark` on at `target` and drops them from the list.
+void IR_Builder_Patch(IR_Builder* self, IR_HoleList* holes, size_t mark, size_t target);
 
 #endif
@@ -0,0 +1,222 @@
+#include <wlang/iropt.h>
+
+// A call costs about this much besides its arguments: the call itself, the frame the
+// callee sets up and takes down and moving the result out of rax.
+#define IR_INLINE_CALL_COST 5
+#define IR_INLINE_CONST_ARG_BONUS 3
+// How much bigger than the call it replaces a body may be.
+#define IR_INLINE_THRESHOLD 6
+// Bodies bigger than this aren't kept at all, unless their procedure is marked `inline`.
+#define IR_INLINE_MAX_SIZE 64
+// How much one procedure may grow through inlining before the cost model says no.
+#define IR_INLINE_MAX_GROWTH 256
+
+DEFINE_HASHMAP_TYPE(IR_Inlinee, Symbol)
+
+static bool IR_Inlinee_HasName(IR_Inlinee* self, Symbol name) { return self->name == name; }
+
+static void IR_Inlinee_Free(IR_Inlinee* self) { IR_Proc_Free(&self->body); }
+
+void IR_Inliner_Initialize(IR_Inliner* self)
+{
+    IR_InlineeHashMap_Initialize(&self->procs, &Symbol_Hash, &IR_Inlinee_HasName);
+    self->report = NULL;
+}
+
+void IR_Inliner_Free(IR_Inliner* self)
+{
+    IR_InlineeHashMap_ForEachRef(&self->procs, &IR_Inlinee_Free);
+    IR_InlineeHashMap_Free(&self->procs);
+}
+
+// What an instruction is likely to cost once its procedure is optimized. Locals become
+// registers, most copies coalesce and a return becomes a jump to the code after the call.
+static size_t IR__InlineWeight(const IR_Instr* in)
+{
+    switch(in->type)
+    {
+    case IR_OpType_Param:
+    case IR_OpType_Load:
+    case IR_OpType_Store:
+    case IR_OpType_Mov:
+    case IR_OpType_Jmp:
+    case IR_OpType_Ret: return 0;
+    case IR_OpType_Call: return IR_INLINE_CALL_COST;
+    default: return 1;
+    }
+}
+
+void IR_Inliner_Add(IR_Inliner* self, const IR_Proc* proc, enum IR_InlineMode mode)
+{
+    IR_Inlinee inlinee = { .name = proc->name, .mode = mode };
+    for(size_t b = 0; b < proc->blocks.count; ++b)
+    {
+        const IR_InstrList* instrs = &proc->blocks.data[b].instrs;
+        for(size_t i = 0; i < instrs->count; ++i)
+        {
+            inlinee.size += IR__InlineWeight(&instrs->data[i]);
+            if(instrs->data[i].type == IR_OpType_Call && instrs->data[i].label == proc->name) inlinee.recursive = true;
+        }
+    }
+
+    bool keep = mode == IR_InlineMode_Always || (mode == IR_InlineMode_Auto && inlinee.size <= IR_INLINE_MAX_SIZE);
+    if(keep) IR_Proc_Copy(&inlinee.body, proc);
+    else
+    {
+        // Without its instructions, but calls are still checked against its parameters.
+        IR_Proc_Initialize(&inlinee.body, proc->name);
+        inlinee.body.param_count = proc->param_count;
+    }
+
+    // A procedure defined twice keeps its last body, as the assembler would complain anyway.
+    IR_Inlinee* old = IR_InlineeHashMap_Find(&self->procs, proc->name);
+    if(old) IR_Inlinee_Free(old);
+    IR_InlineeHashMap_Insert(&self->procs, proc->name, inlinee);
+}
+
+static inline IR_Value IR__Relocate(IR_Value v, IR_V reg_base, size_t slot_base)
+{
+    if(v.type == IR_ValueType_Reg) v.value += reg_base;
+    else if(v.type == IR_ValueType_Slot) v.value += slot_base;
+    return v;
+}
+
+// Makes room for `count` empty blocks right after `block`, moving the jumps to the later
+// ones along.
+static void IR__InsertBlocks(IR_Proc* proc, size_t block, size_t count)
+{
+    for(size_t b = 0; b < proc->blocks.count; ++b)
+    {
+        IR_InstrList* instrs = &proc->blocks.data[b].instrs;
+        if(!instrs->count) continue;
+        IR_Instr* t = &instrs->data[instrs->count - 1];
+        if(t->type != IR_OpType_Jmp && t->type != IR_OpType_Br) continue;
+        if(t->label > block) t->label += count;
+        if(t->type == IR_OpType_Br && t->label_else > block) t->label_else += count;
+    }
+
+    size_t moved = proc->blocks.count - block - 1;
+    IR_BlockList_Reserve(&proc->blocks, proc->blocks.count + count);
+    memmove(&proc->blocks.data[block + 1 + count], &proc->blocks.data[block + 1], moved * sizeof(IR_Block));
+    for(size_t b = block + 1; b <= block + count; ++b) IR_InstrList_Initialize(&proc->blocks.data[b].instrs);
+    proc->blocks.count += count;
+}
+
+// Replaces the call at `at` in `block` and the arguments before it with a copy of
+// `callee`. The parameters become copies of the arguments, and every return stores its
+// value to a new slot and jumps to a new block with the rest of `block`, which loads it
+// into the call's register. Returns that block.
+static size_t IR__InlineCall(IR_Proc* proc, size_t block, size_t at, const IR_Proc* callee)
+{
+    size_t count = callee->blocks.count;
+    size_t entry = block + 1, rest = block + 1 + count;
+    IR__InsertBlocks(proc, block, count + 1);
+
+    IR_InstrList* head = &proc->blocks.data[block].instrs;
+    IR_Instr call = head->data[at];
+    size_t first_arg = at;
+    while(first_arg > 0 && head->data[first_arg - 1].type == IR_OpType_Arg) --first_arg;
+
+    IR_V reg_base = proc->reg_count - 1;
+    size_t slot_base = proc->slot_count, result = slot_base + callee->slot_count;
+    for(size_t b = 0; b < count; ++b)
+    {
+        const IR_InstrList* from = &callee->blocks.data[b].instrs;
+        IR_InstrList* to = &proc->blocks.data[entry + b].instrs;
+        IR_InstrList_Reserve(to, from->count + 1);
+        for(size_t i = 0; i < from->count; ++i)
+        {
+            IR_Instr in = from->data[i];
+            in.lhs = IR__Relocate(in.lhs, reg_base, slot_base);
+            in.rhs = IR__Relocate(in.rhs, reg_base, slot_base);
+            if(in.dst != IR_NO_REG) in.dst += reg_base;
+            switch(in.type)
+            {
+            case IR_OpType_Param:
+            {
+                IR_Value arg = IR_VALUE_IMM(0);
+                for(size_t a = first_arg; a < at; ++a)
+                    if(head->data[a].label == in.label) arg = head->data[a].lhs;
+                in = (IR_Instr){ .type = IR_OpType_Mov, .dst = in.dst, .lhs = arg };
+            } break;
+            case IR_OpType_Ret:
+            {
+                IR_Value value = in.lhs.type == IR_ValueType_None ? IR_VALUE_IMM(0) : in.lhs;
+                IR_InstrList_PushValue(to, (IR_Instr){ .type = IR_OpType_Store, .lhs = IR_VALUE_SLOT(result), .rhs = value });
+                in = (IR_Instr){ .type = IR_OpType_Jmp, .label = rest };
+            } break;
+            case IR_OpType_Jmp: in.label += entry; break;
+            case IR_OpType_Br: in.label += entry; in.label_else += entry; break;
+            default: break;
+            }
+            IR_InstrList_PushValue(to, in);
+        }
+    }
+
+    IR_InstrList* after = &proc->blocks.data[rest].instrs;
+    IR_InstrList_PushValue(after, (IR_Instr){ .type = IR_OpType_Load, .dst = call.dst, .lhs = IR_VALUE_SLOT(result) });
+    IR_InstrList_Append(after, head->data + at + 1, head->count - at - 1);
+    head->count = first_arg;
+    IR_InstrList_PushValue(head, (IR_Instr){ .type = IR_OpType_Jmp, .label = entry });
+
+    proc->reg_count += callee->reg_count - 1;
+    proc->slot_count += callee->slot_count + 1;
+    return rest;
+}
+
+// Whether the cost model wants `call` at `at` in `block` inlined. Reports its decision.
+static bool IR_Inliner__Decide(IR_Inliner* self, const IR_Proc* proc, size_t block, size_t at, size_t growth,
+                               const IR_Inlinee** out)
+{
+    const IR_InstrList* instrs = &proc->blocks.data[block].instrs;
+    const IR_Instr* call = &instrs->data[at];
+    const IR_Inlinee* callee = IR_InlineeHashMap_Find(&self->procs, (Symbol)call->label);
+    size_t arg_count = (size_t)IR_Value_Imm(call->lhs), const_args = 0;
+    for(size_t i = at; i > 0 && instrs->data[i - 1].type == IR_OpType_Arg; --i)
+        if(instrs->data[i - 1].lhs.type == IR_ValueType_Imm) ++const_args;
+    size_t budget = IR_INLINE_CALL_COST + arg_count + IR_INLINE_CONST_ARG_BONUS * const_args + IR_INLINE_THRESHOLD;
+
+    const char* reason = NULL;
+    if(!callee) reason = "not defined before the call";
+    else if(callee->mode == IR_InlineMode_Never) reason = "marked noinline";
+    else if(callee->body.param_count != arg_count) reason = "argument count differs";
+    else if(callee->mode != IR_InlineMode_Always)
+    {
+        if(callee->recursive) reason = "recursive";
+        else if(callee->size > budget) reason = "too big";
+        else if(growth + callee->size > IR_INLINE_MAX_GROWTH) reason = "caller grew too much";
+    }
+
+    if(self->report)
+    {
+        fprintf(self->report, "%s: %s %s", Symbol_Name(proc->name), reason ? "did not inline" : "inlined",
+                Symbol_Name((Symbol)call->label));
+        if(callee) fprintf(self->report, " (size %zu, budget %zu)", callee->size, budget);
+        if(reason) fprintf(self->report, ": %s", reason);
+        fputc('\n', self->report);
+    }
+    *out = callee;
+    return reason == NULL;
+}
+
+size_t IR_Inliner_Run(IR_Inliner* self, IR_Proc* proc)
+{
+    size_t inlined = 0, growth = 0;
+    for(size_t b = 0; b < proc->blocks.count; ++b)
+    {
+        for(size_t i = 0; i < proc->blocks.data[b].instrs.count; ++i)
+        {
+            const IR_Inlinee* callee;
+            if(proc->blocks.data[b].instrs.data[i].type != IR_OpType_Call) continue;
+            if(!IR_Inliner__Decide(self, proc, b, i, growth, &callee)) continue;
+
+            // The rest of the block is looked at where it was moved to, but not the body
+            // that came in, so a recursive callee only gets unrolled once.
+            growth += callee->size;
+            b = IR__InlineCall(proc, b, i, &callee->body);
+            i = (size_t)-1;
+            ++inlined;
+        }
+    }
+    return inlined;
+}
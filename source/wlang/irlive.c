@@ -0,0 +1,170 @@
+#include <wlang/iropt.h>
+#include <string.h>
+
+#define IR_BITS_WORD(I) ((I) / 64)
+#define IR_BITS_MASK(I) ((uint64_t)1 << ((I) % 64))
+
+#define IR_LIVE_CLOSED ((size_t)-1)
+
+// A range of one register, as they are found going backwards.
+typedef struct { IR_V reg; IR_Interval range; } IR_LiveRange;
+
+void IR_Liveness_Compute(IR_Liveness* self, const IR_Proc* proc, Arena* scratch)
+{
+    size_t block_count = proc->blocks.count, reg_count = proc->reg_count, words = (reg_count + 63) / 64;
+    size_t instr_count = 0;
+    for(size_t b = 0; b < block_count; ++b) instr_count += proc->blocks.data[b].instrs.count;
+
+    self->range_start = ARENA_ARRAY(scratch, size_t, reg_count + 1);
+    self->calls = ARENA_ARRAY(scratch, size_t, instr_count + 1);
+    self->call_count = 0;
+
+    // Per block: registers read before being written in it, registers written in it,
+    // and registers live on entry and exit.
+    uint64_t* use = ARENA_ARRAY(scratch, uint64_t, block_count * words + 1);
+    uint64_t* def = ARENA_ARRAY(scratch, uint64_t, block_count * words + 1);
+    uint64_t* in = ARENA_ARRAY(scratch, uint64_t, block_count * words + 1);
+    uint64_t* out = ARENA_ARRAY(scratch, uint64_t, block_count * words + 1);
+    memset(use, 0, sizeof(uint64_t) * block_count * words);
+    memset(def, 0, sizeof(uint64_t) * block_count * words);
+    memset(in, 0, sizeof(uint64_t) * block_count * words);
+    memset(out, 0, sizeof(uint64_t) * block_count * words);
+
+    size_t position = 0, def_count = 0;
+    for(size_t b = 0; b < block_count; ++b)
+    {
+        uint64_t* u = use + b * words, *d = def + b * words;
+        const IR_InstrList* instrs = &proc->blocks.data[b].instrs;
+        for(size_t i = 0; i < instrs->count; ++i, position += 2)
+        {
+            const IR_Instr* instr = &instrs->data[i];
+            const IR_Value operands[2] = { instr->lhs, instr->rhs };
+            for(int o = 0; o < 2; ++o)
+            {
+                if(operands[o].type != IR_ValueType_Reg) continue;
+                IR_V r = operands[o].value;
+                if(!(d[IR_BITS_WORD(r)] & IR_BITS_MASK(r))) u[IR_BITS_WORD(r)] |= IR_BITS_MASK(r);
+            }
+            if(instr->dst != IR_NO_REG)
+            {
+                d[IR_BITS_WORD(instr->dst)] |= IR_BITS_MASK(instr->dst);
+                def_count++;
+            }
+            if(instr->type == IR_OpType_Call) self->calls[self->call_count++] = position;
+        }
+    }
+
+    // Backwards dataflow, going over the blocks in reverse settles forward code in one round.
+    bool changed = true;
+    while(changed)
+    {
+        changed = false;
+        for(size_t b = block_count; b --> 0;)
+        {
+            uint64_t* o = out + b * words, *n = in + b * words;
+            size_t succ[2], succ_count = IR_Block_Successors(&proc->blocks.data[b], succ);
+            for(size_t s = 0; s < succ_count; ++s)
+                for(size_t w = 0; w < words; ++w) o[w] |= in[succ[s] * words + w];
+            for(size_t w = 0; w < words; ++w)
+            {
+                uint64_t live = use[b * words + w] | (o[w] & ~def[b * words + w]);
+                if(live == n[w]) continue;
+                n[w] = live;
+                changed = true;
+            }
+        }
+    }
+
+    // Every range starts at a write or where its register is live into a block, which
+    // bounds how many there are.
+    size_t found_max = def_count;
+    for(size_t b = 0; b < block_count; ++b)
+        for(size_t w = 0; w < words; ++w) found_max += (size_t)__builtin_popcountll(in[b * words + w]);
+    IR_LiveRange* found = ARENA_ARRAY(scratch, IR_LiveRange, found_max + 1);
+    size_t found_count = 0;
+
+    // Going backwards, a range is open from where its register is last read or live out
+    // of the block to where it is written or live into it.
+    size_t* open = ARENA_ARRAY(scratch, size_t, reg_count + 1);
+    for(IR_V r = 0; r < reg_count; ++r) open[r] = IR_LIVE_CLOSED;
+    for(size_t b = block_count; b --> 0;)
+    {
+        size_t count = proc->blocks.data[b].instrs.count;
+        if(!count) continue;
+        position -= 2 * count;
+        size_t first = position, last = position + 2 * count - 1;
+        for(size_t w = 0; w < words; ++w)
+            for(uint64_t bits = out[b * words + w]; bits; bits &= bits - 1)
+                open[w * 64 + __builtin_ctzll(bits)] = last;
+
+        const IR_Instr* instrs = proc->blocks.data[b].instrs.data;
+        for(size_t i = count; i --> 0;)
+        {
+            const IR_Instr* instr = &instrs[i];
+            size_t at = first + 2 * i;
+            if(instr->dst != IR_NO_REG)
+            {
+                // A result nothing reads still needs somewhere to be written to.
+                IR_V d = instr->dst;
+                found[found_count++] = (IR_LiveRange){ d, { at + 1, open[d] != IR_LIVE_CLOSED ? open[d] : at + 1 } };
+                open[d] = IR_LIVE_CLOSED;
+            }
+            const IR_Value operands[2] = { instr->lhs, instr->rhs };
+            for(int o = 0; o < 2; ++o)
+                if(operands[o].type == IR_ValueType_Reg && open[operands[o].value] == IR_LIVE_CLOSED)
+                    open[operands[o].value] = at;
+        }
+
+        for(size_t w = 0; w < words; ++w)
+        {
+            for(uint64_t bits = in[b * words + w]; bits; bits &= bits - 1)
+            {
+                IR_V r = w * 64 + __builtin_ctzll(bits);
+                found[found_count++] = (IR_LiveRange){ r, { first, open[r] } };
+                open[r] = IR_LIVE_CLOSED;
+            }
+        }
+    }
+
+    // Sorted by register, the ranges of each were found last to first.
+    memset(self->range_start, 0, sizeof(size_t) * (reg_count + 1));
+    for(size_t f = 0; f < found_count; ++f) self->range_start[found[f].reg + 1]++;
+    for(IR_V r = 0; r < reg_count; ++r) self->range_start[r + 1] += self->range_start[r];
+    size_t* fill = open;
+    for(IR_V r = 0; r < reg_count; ++r) fill[r] = self->range_start[r + 1];
+    self->ranges = ARENA_ARRAY(scratch, IR_Interval, found_count + 1);
+    for(size_t f = 0; f < found_count; ++f) self->ranges[--fill[found[f].reg]] = found[f].range;
+
+    // Ranges that continue from one block into the next are one.
+    size_t kept = 0;
+    for(IR_V r = 0; r < reg_count; ++r)
+    {
+        size_t from = self->range_start[r], to = self->range_start[r + 1];
+        self->range_start[r] = kept;
+        for(size_t i = from; i < to; ++i)
+        {
+            if(kept > self->range_start[r] && self->ranges[i].start <= self->ranges[kept - 1].end + 1)
+                self->ranges[kept - 1].end = self->ranges[i].end;
+            else self->ranges[kept++] = self->ranges[i];
+        }
+    }
+    self->range_start[reg_count] = kept;
+}
+
+bool IR_Liveness_CrossesCall(const IR_Liveness* self, const IR_Interval* ranges, size_t count)
+{
+    for(size_t i = 0; i < count; ++i)
+    {
+        // Binary search for the first call at or after the start.
+        size_t lo = 0, hi = self->call_count;
+        while(lo < hi)
+        {
+            size_t mid = (lo + hi) / 2;
+            if(self->calls[mid] < ranges[i].start) lo = mid + 1;
+            else hi = mid;
+        }
+        // The call clobbers between reading its operands and writing its result.
+        if(lo < self->call_count && self->calls[lo] < ranges[i].end) return true;
+    }
+    return false;
+}
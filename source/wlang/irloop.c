@@ -0,0 +1,128 @@
+#include <wlang/iropt.h>
+#include <string.h>
+
+size_t IR_Loop_Find(IR_Loop** loops, const IR_Cfg* cfg, Arena* scratch)
+{
+    size_t n = cfg->block_count, count = 0;
+    size_t* work = ARENA_ARRAY(scratch, size_t, n + 1);
+    *loops = ARENA_ARRAY(scratch, IR_Loop, n + 1);
+
+    // An inner header is dominated by the outer one, so it comes later in reverse postorder.
+    for(size_t k = cfg->order_count; k --> 0;)
+    {
+        size_t header = cfg->order[k], work_count = 0;
+        for(size_t p = cfg->pred_start[header]; p < cfg->pred_start[header + 1]; ++p)
+        {
+            size_t pred = cfg->preds[p];
+            if(IR_Cfg_IsReachable(cfg, pred) && IR_Cfg_Dominates(cfg, header, pred)) work[work_count++] = pred;
+        }
+        if(!work_count) continue;
+
+        IR_Loop* loop = &(*loops)[count++];
+        loop->header = header;
+        loop->blocks = ARENA_ARRAY(scratch, bool, n);
+        memset(loop->blocks, 0, sizeof(bool) * n);
+        loop->blocks[header] = true;
+        while(work_count)
+        {
+            size_t b = work[--work_count];
+            if(loop->blocks[b]) continue;
+            loop->blocks[b] = true;
+            for(size_t p = cfg->pred_start[b]; p < cfg->pred_start[b + 1]; ++p)
+                if(!loop->blocks[cfg->preds[p]] && IR_Cfg_IsReachable(cfg, cfg->preds[p])) work[work_count++] = cfg->preds[p];
+        }
+
+        loop->preheader = IR_CFG_UNREACHABLE;
+        size_t outside = 0;
+        for(size_t p = cfg->pred_start[header]; p < cfg->pred_start[header + 1]; ++p)
+            if(!loop->blocks[cfg->preds[p]] && IR_Cfg_IsReachable(cfg, cfg->preds[p])) { loop->preheader = cfg->preds[p]; ++outside; }
+        if(outside != 1 || cfg->succ_count[loop->preheader] != 1) loop->preheader = IR_CFG_UNREACHABLE;
+    }
+    return count;
+}
+
+// Whether `in` computes the same value on every iteration of `loop`, given where every
+// register is defined, and can be computed once before it even if it would never run.
+static bool IR__IsInvariant(const IR_Instr* in, const IR_Loop* loop, const size_t* def_block)
+{
+    switch(in->type)
+    {
+    case IR_OpType_Div:
+    case IR_OpType_Mod:
+        if(in->rhs.type != IR_ValueType_Imm || IR_Value_Imm(in->rhs) == 0 || IR_Value_Imm(in->rhs) == -1) return false;
+        break;
+    case IR_OpType_Load:
+    case IR_OpType_Store:
+    case IR_OpType_Param:
+    case IR_OpType_Arg:
+    case IR_OpType_Call:
+    case IR_OpType_Jmp:
+    case IR_OpType_Br:
+    case IR_OpType_Ret:
+    case IR_OpType_Phi: return false;
+    default: break;
+    }
+
+    const IR_Value operands[2] = { in->lhs, in->rhs };
+    for(int o = 0; o < 2; ++o)
+    {
+        if(operands[o].type == IR_ValueType_Slot) return false;
+        if(operands[o].type != IR_ValueType_Reg) continue;
+        size_t b = def_block[operands[o].value];
+        if(b != IR_CFG_UNREACHABLE && loop->blocks[b]) return false;
+    }
+    return true;
+}
+
+bool IR_HoistLoopInvariants(IR_Proc* proc, Arena* scratch)
+{
+    IR_Cfg cfg;
+    IR_Cfg_Build(&cfg, proc, scratch);
+    IR_Loop* loops;
+    size_t loop_count = IR_Loop_Find(&loops, &cfg, scratch);
+    if(!loop_count) return false;
+
+    size_t* def_block = ARENA_ARRAY(scratch, size_t, proc->reg_count);
+    for(IR_V r = 0; r < proc->reg_count; ++r) def_block[r] = IR_CFG_UNREACHABLE;
+    for(size_t b = 0; b < proc->blocks.count; ++b)
+    {
+        const IR_InstrList* instrs = &proc->blocks.data[b].instrs;
+        for(size_t i = 0; i < instrs->count; ++i)
+            if(instrs->data[i].dst != IR_NO_REG) def_block[instrs->data[i].dst] = b;
+    }
+
+    bool changed = false;
+    for(size_t l = 0; l < loop_count; ++l)
+    {
+        const IR_Loop* loop = &loops[l];
+        if(loop->preheader == IR_CFG_UNREACHABLE) continue;
+        IR_InstrList* preheader = &proc->blocks.data[loop->preheader].instrs;
+
+        // In reverse postorder the definitions come before their uses, except for phis,
+        // which stay anyway, so one pass finds everything that can move.
+        for(size_t k = 0; k < cfg.order_count; ++k)
+        {
+            size_t b = cfg.order[k];
+            if(!loop->blocks[b]) continue;
+            IR_InstrList* instrs = &proc->blocks.data[b].instrs;
+            size_t kept = 0;
+            for(size_t i = 0; i < instrs->count; ++i)
+            {
+                IR_Instr in = instrs->data[i];
+                if(in.dst == IR_NO_REG || !IR__IsInvariant(&in, loop, def_block))
+                {
+                    instrs->data[kept++] = in;
+                    continue;
+                }
+                // Goes right before the preheader's jump into the loop.
+                IR_Instr jump = preheader->data[preheader->count - 1];
+                preheader->data[preheader->count - 1] = in;
+                IR_InstrList_PushValue(preheader, jump);
+                def_block[in.dst] = loop->preheader;
+                changed = true;
+            }
+            instrs->count = kept;
+        }
+    }
+    return changed;
+}
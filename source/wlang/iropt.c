@@ -0,0 +1,10 @@
+#include <wlang/iropt.h>
+
+void IR_Optimize(IR_Proc* proc, Arena* scratch)
+{
+    IR_BuildSSA(proc, scratch);
+    IR_FoldConstants(proc, scratch);
+    IR_HoistLoopInvariants(proc, scratch);
+    IR_EliminateDeadCode(proc, scratch);
+    IR_LeaveSSA(proc, scratch);
+}
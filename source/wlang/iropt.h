@@ -0,0 +1,162 @@
+#ifndef WLANG_HEADER_IROPT_
+#define WLANG_HEADER_IROPT_
+#include <wlang/ir.h>
+#include <wlang/arena.h>
+#include <stdint.h>
+
+//:==========----------- Control Flow Graph -----------==========://
+
+#define IR_CFG_UNREACHABLE ((size_t)-1)
+
+// Edges and dominators of a procedure as it was when the graph was built. Blocks that
+// control can't reach from the entry have no place in `order` and no dominator.
+typedef struct
+{
+    size_t block_count;
+    size_t* succ;        // Two per block, `succ_count` of them used.
+    uint8_t* succ_count;
+    size_t* preds;       // Those of block `b` are at [pred_start[b], pred_start[b + 1]).
+    size_t* pred_start;
+    size_t* order;       // Reachable blocks in reverse postorder, the entry first.
+    size_t order_count;
+    size_t* order_index; // Position of each block in `order`, or IR_CFG_UNREACHABLE.
+    size_t* idom;        // Immediate dominator, the entry is its own.
+} IR_Cfg;
+
+void IR_Cfg_Build(IR_Cfg* self, const IR_Proc* proc, Arena* scratch);
+bool IR_Cfg_Dominates(const IR_Cfg* self, size_t a, size_t b);
+
+static inline bool IR_Cfg_IsReachable(const IR_Cfg* self, size_t block)
+{ return self->order_index[block] != IR_CFG_UNREACHABLE; }
+
+static inline size_t IR_Cfg_PredCount(const IR_Cfg* self, size_t block)
+{ return self->pred_start[block + 1] - self->pred_start[block]; }
+
+//:==========----------- Loops -----------==========://
+
+// A natural loop: a header that dominates the blocks its back edges come from, and every
+// block that reaches one of those without passing the header. Back edges to the same
+// header make up one loop.
+typedef struct
+{
+    size_t header;
+    size_t preheader; // The only block outside that enters the loop, if it goes nowhere
+                      // else, or IR_CFG_UNREACHABLE.
+    bool* blocks;     // Per block, whether it belongs to the loop.
+} IR_Loop;
+
+// Finds the loops of the procedure `cfg` was built for and returns how many there are.
+// Inner loops come before the loops they are nested in.
+size_t IR_Loop_Find(IR_Loop** loops, const IR_Cfg* cfg, Arena* scratch);
+
+//:==========----------- Liveness -----------==========://
+
+// Instructions are numbered in block order, and instruction `i` reads its operands at
+// position 2i and writes its result at 2i + 1. A register is live in ranges, each from
+// where it is written or live into a block to where it is last read or live out of a
+// block. Between them are holes, where its value isn't needed and its register is free for
+// others. An unused register has no ranges.
+typedef struct { size_t start, end; } IR_Interval;
+
+typedef struct
+{
+    IR_Interval* ranges;    // Those of register `r` are from range_start[r] to range_start[r + 1], in order.
+    size_t* range_start;
+    size_t* calls;          // Positions of the calls, in order.
+    size_t call_count;
+} IR_Liveness;
+
+// Only for procedures out of SSA form.
+void IR_Liveness_Compute(IR_Liveness* self, const IR_Proc* proc, Arena* scratch);
+
+// Whether a register live in these ranges has to survive a call.
+bool IR_Liveness_CrossesCall(const IR_Liveness* self, const IR_Interval* ranges, size_t count);
+
+//:==========----------- IR Optimization Passes -----------==========://
+
+// Every pass rewrites one procedure in place and allocates its temporary data from
+// `scratch`, which the caller resets between procedures. Passes return whether they
+// changed anything.
+
+// Drops the blocks control can't reach and renumbers the rest.
+bool IR_RemoveUnreachableBlocks(IR_Proc* proc, Arena* scratch);
+
+// Puts the procedure into SSA form: the loads and stores of every local slot become
+// registers, with phis where control flow merges different values (mem2reg). Phis go
+// to the iterated dominance frontiers of the stores, but only for slots that are read
+// in some other block than the one they were written in. The entry block must not have
+// predecessors, which the lowering guarantees.
+bool IR_BuildSSA(IR_Proc* proc, Arena* scratch);
+
+// Replaces the phis with copies at the end of the predecessors. A predecessor with another
+// successor gets them before its branch if that way doesn't read what they overwrite, and
+// a block of their own on the edge otherwise. The copies of one edge happen at once, so a
+// value that is still needed is saved to a new register first.
+bool IR_LeaveSSA(IR_Proc* proc, Arena* scratch);
+
+// Computes `op` on constants. Fails for ops with side effects and for what would trap
+// at run time, like division by zero.
+bool IR_EvalOp(enum IR_OpType op, long lhs, long rhs, long* result);
+
+// Folds operations on constants and propagates constants through registers, phis and
+// local slots. Only edges that can actually be taken are followed, so a branch on a constant
+// becomes a jump and the code behind the other edge doesn't spoil what is known.
+bool IR_FoldConstants(IR_Proc* proc, Arena* scratch);
+
+// Moves pure computations whose operands don't change inside a loop to its preheader,
+// inner loops first so the code can keep moving outwards. Only for SSA form, and only
+// loops with a preheader, which the lowering of `while` always makes.
+bool IR_HoistLoopInvariants(IR_Proc* proc, Arena* scratch);
+
+// Removes unreachable blocks, stores to slots that are never read and pure computations
+// whose results go unused, including those only used by other dead ones.
+bool IR_EliminateDeadCode(IR_Proc* proc, Arena* scratch);
+
+// Builds SSA form, folds constants, hoists loop invariants, removes dead code and leaves
+// SSA form again.
+void IR_Optimize(IR_Proc* proc, Arena* scratch);
+
+//:==========----------- Inlining -----------==========://
+
+// How a procedure wants to be treated at its call sites, from `inline` and `noinline`.
+enum IR_InlineMode
+{
+    IR_InlineMode_Auto,   // Up to the cost model.
+    IR_InlineMode_Always, // Unless the arguments don't match.
+    IR_InlineMode_Never,
+};
+
+// A procedure that was compiled before, as seen by the inliner.
+typedef struct
+{
+    Symbol name;
+    uint8_t mode;   // enum IR_InlineMode
+    bool recursive; // Calls itself.
+    size_t size;    // Roughly how many instructions it takes once optimized.
+    IR_Proc body;   // As lowered, before optimization. Only the parameters if it is too big to ever inline.
+} IR_Inlinee;
+DECLARE_HASHMAP_TYPE(IR_Inlinee, Symbol)
+
+// Replaces calls with the bodies of procedures compiled earlier in the same file. Since a
+// procedure is added after its own calls were inlined, inlining works bottom-up along the
+// order of definition. Procedures defined later are never inlined, which also keeps
+// recursion from unrolling: a call that was inlined is not looked at again.
+typedef struct
+{
+    IR_InlineeHashMap procs;
+    FILE* report; // Gets a line for every call that was or wasn't inlined, unless NULL.
+} IR_Inliner;
+
+void IR_Inliner_Initialize(IR_Inliner* self);
+void IR_Inliner_Free(IR_Inliner* self);
+
+// Makes `proc`, which is not optimized yet, available to the procedures after it.
+void IR_Inliner_Add(IR_Inliner* self, const IR_Proc* proc, enum IR_InlineMode mode);
+
+// Inlines the calls of `proc` the cost model agrees with, and returns how many there were.
+// A call is worth it if the callee isn't much bigger than the call itself, the arguments
+// passed in registers and the frame it saves, with a bonus for every constant argument
+// since those fold away in the callee's body.
+size_t IR_Inliner_Run(IR_Inliner* self, IR_Proc* proc);
+
+#endif//WLANG_HEADER_IROPT_
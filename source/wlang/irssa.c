@@ -0,0 +1,538 @@
+#include <wlang/iropt.h>
+#include <string.h>
+
+// Singly linked list of block or slot numbers, allocated from the scratch arena.
+typedef struct IR_Link { size_t value; struct IR_Link* next; } IR_Link;
+
+static IR_Link* IR_Link_Push(Arena* arena, IR_Link* next, size_t value)
+{
+    IR_Link* link = ARENA_NEW(arena, IR_Link);
+    link->value = value;
+    link->next = next;
+    return link;
+}
+
+typedef struct
+{
+    IR_Proc* proc;
+    IR_Cfg cfg;
+    Arena* scratch;
+    IR_Link** frontier; // Per block, its dominance frontier.
+    IR_Link** children; // Per block, the blocks it immediately dominates.
+    IR_Value* current;  // Per slot, its value at the point being renamed.
+    IR_Value* replace;  // Per register, what a removed load is replaced with.
+    struct { size_t slot; IR_Value value; }* undo; // Values of `current` to restore when leaving a block.
+    size_t undo_count;
+} IR_SSABuilder;
+
+// A block is in the dominance frontier of every block that dominates one of its
+// predecessors without strictly dominating the block itself. Only merge points can be
+// in a frontier, and walking up from each predecessor to the block's immediate dominator
+// finds exactly those.
+static void IR_SSABuilder__Frontiers(IR_SSABuilder* self)
+{
+    const IR_Cfg* cfg = &self->cfg;
+    for(size_t i = 0; i < cfg->order_count; ++i)
+    {
+        size_t b = cfg->order[i];
+        if(b) self->children[cfg->idom[b]] = IR_Link_Push(self->scratch, self->children[cfg->idom[b]], b);
+        if(IR_Cfg_PredCount(cfg, b) < 2) continue;
+        for(size_t p = cfg->pred_start[b]; p < cfg->pred_start[b + 1]; ++p)
+        {
+            // All of `b` is added before moving on, so a repeat would be at the head.
+            for(size_t runner = cfg->preds[p]; runner != cfg->idom[b]; runner = cfg->idom[runner])
+            {
+                if(self->frontier[runner] && self->frontier[runner]->value == b) break;
+                self->frontier[runner] = IR_Link_Push(self->scratch, self->frontier[runner], b);
+            }
+        }
+    }
+}
+
+// Finds the slots that need phis and the blocks they need them in, then adds the phis
+// with room for an argument per predecessor. Their `lhs` is the slot until renaming is
+// done.
+static void IR_SSABuilder__PlacePhis(IR_SSABuilder* self)
+{
+    IR_Proc* proc = self->proc;
+    size_t block_count = proc->blocks.count, slot_count = proc->slot_count;
+    IR_Link** stores = ARENA_ARRAY(self->scratch, IR_Link*, slot_count);
+    IR_Link** phis = ARENA_ARRAY(self->scratch, IR_Link*, block_count);
+    size_t* stored_in = ARENA_ARRAY(self->scratch, size_t, slot_count); // Last block + 1, to tell reads of a local store.
+    bool* crosses = ARENA_ARRAY(self->scratch, bool, slot_count);
+    memset(stores, 0, sizeof(IR_Link*) * slot_count);
+    memset(phis, 0, sizeof(IR_Link*) * block_count);
+    memset(stored_in, 0, sizeof(size_t) * slot_count);
+    memset(crosses, 0, sizeof(bool) * slot_count);
+
+    for(size_t b = 0; b < block_count; ++b)
+    {
+        const IR_InstrList* instrs = &proc->blocks.data[b].instrs;
+        for(size_t i = 0; i < instrs->count; ++i)
+        {
+            const IR_Instr* in = &instrs->data[i];
+            size_t slot = in->lhs.value;
+            if(in->type == IR_OpType_Load && stored_in[slot] != b + 1) crosses[slot] = true;
+            if(in->type != IR_OpType_Store || stored_in[slot] == b + 1) continue;
+            stored_in[slot] = b + 1;
+            stores[slot] = IR_Link_Push(self->scratch, stores[slot], b);
+        }
+    }
+
+    // Iterated dominance frontier, a phi is itself a store to the slot.
+    size_t* has_phi = ARENA_ARRAY(self->scratch, size_t, block_count); // Slot + 1.
+    size_t* queued = ARENA_ARRAY(self->scratch, size_t, block_count);  // Same.
+    size_t* work = ARENA_ARRAY(self->scratch, size_t, block_count);
+    memset(has_phi, 0, sizeof(size_t) * block_count);
+    memset(queued, 0, sizeof(size_t) * block_count);
+    for(size_t s = 0; s < slot_count; ++s)
+    {
+        if(!crosses[s]) continue;
+        size_t work_count = 0;
+        for(IR_Link* l = stores[s]; l; l = l->next)
+        {
+            queued[l->value] = s + 1;
+            work[work_count++] = l->value;
+        }
+        while(work_count)
+        {
+            size_t x = work[--work_count];
+            for(IR_Link* f = self->frontier[x]; f; f = f->next)
+            {
+                size_t y = f->value;
+                if(has_phi[y] == s + 1) continue;
+                has_phi[y] = s + 1;
+                phis[y] = IR_Link_Push(self->scratch, phis[y], s);
+                if(queued[y] == s + 1) continue;
+                queued[y] = s + 1;
+                work[work_count++] = y;
+            }
+        }
+    }
+
+    for(size_t b = 0; b < block_count; ++b)
+    {
+        if(!phis[b]) continue;
+        size_t count = 0, preds = IR_Cfg_PredCount(&self->cfg, b);
+        for(IR_Link* l = phis[b]; l; l = l->next) ++count;
+
+        IR_InstrList* instrs = &proc->blocks.data[b].instrs;
+        IR_InstrList_Reserve(instrs, instrs->count + count);
+        memmove(instrs->data + count, instrs->data, sizeof(IR_Instr) * instrs->count);
+        instrs->count += count;
+        size_t i = 0;
+        for(IR_Link* l = phis[b]; l; l = l->next)
+        {
+            instrs->data[i++] = (IR_Instr){
+                .type = IR_OpType_Phi, .dst = proc->reg_count++, .lhs = IR_VALUE_SLOT(l->value),
+                .label = proc->phi_args.count, .label_else = 0
+            };
+            for(size_t p = 0; p < preds; ++p)
+                IR_PhiArgList_PushValue(&proc->phi_args, (IR_PhiArg){ 0, IR_VALUE_NONE });
+        }
+    }
+}
+
+static void IR_SSABuilder__Define(IR_SSABuilder* self, size_t slot, IR_Value value)
+{
+    self->undo[self->undo_count].slot = slot;
+    self->undo[self->undo_count++].value = self->current[slot];
+    self->current[slot] = value;
+}
+
+static IR_Value IR_SSABuilder__Resolve(IR_SSABuilder* self, IR_Value v)
+{
+    if(v.type == IR_ValueType_Reg && self->replace[v.value].type != IR_ValueType_None)
+        return self->replace[v.value];
+    return v;
+}
+
+// Walks the dominator tree, so every load is seen after the stores that reach it, except
+// for those that reach it through a phi.
+static void IR_SSABuilder__Rename(IR_SSABuilder* self, size_t block)
+{
+    IR_Proc* proc = self->proc;
+    size_t mark = self->undo_count;
+    IR_InstrList* instrs = &proc->blocks.data[block].instrs;
+    size_t kept = 0;
+    for(size_t i = 0; i < instrs->count; ++i)
+    {
+        IR_Instr in = instrs->data[i];
+        in.lhs = IR_SSABuilder__Resolve(self, in.lhs);
+        in.rhs = IR_SSABuilder__Resolve(self, in.rhs);
+        switch(in.type)
+        {
+        case IR_OpType_Phi:
+            IR_SSABuilder__Define(self, in.lhs.value, IR_VALUE_REG(in.dst));
+            break;
+        case IR_OpType_Load:
+            self->replace[in.dst] = self->current[in.lhs.value];
+            continue;
+        case IR_OpType_Store:
+            IR_SSABuilder__Define(self, in.lhs.value, in.rhs);
+            continue;
+        default: break;
+        }
+        instrs->data[kept++] = in;
+    }
+    instrs->count = kept;
+
+    for(size_t s = 0; s < self->cfg.succ_count[block]; ++s)
+    {
+        IR_InstrList* succ = &proc->blocks.data[self->cfg.succ[2 * block + s]].instrs;
+        for(size_t i = 0; i < succ->count && succ->data[i].type == IR_OpType_Phi; ++i)
+        {
+            IR_Instr* phi = &succ->data[i];
+            IR_Proc_PhiArgs(proc, phi)[phi->label_else++] = (IR_PhiArg){ block, self->current[phi->lhs.value] };
+        }
+    }
+
+    for(IR_Link* c = self->children[block]; c; c = c->next)
+        IR_SSABuilder__Rename(self, c->value);
+
+    while(self->undo_count > mark)
+    {
+        --self->undo_count;
+        self->current[self->undo[self->undo_count].slot] = self->undo[self->undo_count].value;
+    }
+}
+
+bool IR_BuildSSA(IR_Proc* proc, Arena* scratch)
+{
+    if(!proc->slot_count) return false;
+    IR_RemoveUnreachableBlocks(proc, scratch);
+
+    IR_SSABuilder self = { .proc = proc, .scratch = scratch };
+    IR_Cfg_Build(&self.cfg, proc, scratch);
+    size_t block_count = proc->blocks.count;
+    self.frontier = ARENA_ARRAY(scratch, IR_Link*, block_count);
+    self.children = ARENA_ARRAY(scratch, IR_Link*, block_count);
+    memset(self.frontier, 0, sizeof(IR_Link*) * block_count);
+    memset(self.children, 0, sizeof(IR_Link*) * block_count);
+    IR_SSABuilder__Frontiers(&self);
+    IR_SSABuilder__PlacePhis(&self);
+
+    // Every store and phi defines a slot at most once.
+    size_t defs = 0;
+    for(size_t b = 0; b < block_count; ++b)
+    {
+        const IR_InstrList* instrs = &proc->blocks.data[b].instrs;
+        for(size_t i = 0; i < instrs->count; ++i)
+            defs += instrs->data[i].type == IR_OpType_Store || instrs->data[i].type == IR_OpType_Phi;
+    }
+    self.undo = Arena_Alloc(scratch, sizeof(*self.undo) * (defs + 1));
+    self.current = ARENA_ARRAY(scratch, IR_Value, proc->slot_count);
+    self.replace = ARENA_ARRAY(scratch, IR_Value, proc->reg_count);
+    // Reading a local before it is written gives whatever was there, zero will do.
+    for(size_t s = 0; s < proc->slot_count; ++s) self.current[s] = IR_VALUE_IMM(0);
+    for(size_t r = 0; r < proc->reg_count; ++r) self.replace[r] = IR_VALUE_NONE;
+
+    IR_SSABuilder__Rename(&self, 0);
+
+    for(size_t b = 0; b < block_count; ++b)
+    {
+        IR_InstrList* instrs = &proc->blocks.data[b].instrs;
+        for(size_t i = 0; i < instrs->count && instrs->data[i].type == IR_OpType_Phi; ++i)
+            instrs->data[i].lhs = IR_VALUE_NONE;
+    }
+    proc->slot_count = 0;
+    return true;
+}
+
+//:==========----------- Out of SSA -----------==========://
+
+typedef struct { IR_V dst; IR_Value src; } IR_Copy;
+
+// Emits the copies of one edge as if they happened at once. A copy can go as soon as no
+// other pending copy reads its destination; when only cycles are left, the destination
+// of one is saved to a new register first, which breaks its cycle.
+static void IR__EmitParallelCopies(IR_Proc* proc, IR_InstrList* out, IR_Copy* copies, size_t count)
+{
+    while(count)
+    {
+        bool progress = false;
+        for(size_t i = 0; i < count; ++i)
+        {
+            bool read = false;
+            for(size_t j = 0; j < count && !read; ++j)
+                read = j != i && IR_Value_Equal(copies[j].src, IR_VALUE_REG(copies[i].dst));
+            if(read) continue;
+            IR_InstrList_PushValue(out, (IR_Instr){ .type = IR_OpType_Mov, .dst = copies[i].dst, .lhs = copies[i].src });
+            copies[i--] = copies[--count];
+            progress = true;
+        }
+        if(progress) continue;
+
+        IR_V saved = proc->reg_count++;
+        IR_Value old = IR_VALUE_REG(copies[0].dst);
+        IR_InstrList_PushValue(out, (IR_Instr){ .type = IR_OpType_Mov, .dst = saved, .lhs = old });
+        for(size_t j = 0; j < count; ++j)
+            if(IR_Value_Equal(copies[j].src, old)) copies[j].src = IR_VALUE_REG(saved);
+    }
+}
+
+// The copies the phis of `b` need on the edge from `pred`, written to `copies`. Returns
+// how many there are.
+static size_t IR__EdgeCopies(const IR_Proc* proc, size_t pred, size_t b, IR_Copy* copies)
+{
+    size_t count = 0;
+    const IR_InstrList* phis = &proc->blocks.data[b].instrs;
+    for(size_t i = 0; i < phis->count && phis->data[i].type == IR_OpType_Phi; ++i)
+    {
+        const IR_Instr* phi = &phis->data[i];
+        const IR_PhiArg* args = IR_Proc_PhiArgs(proc, phi);
+        for(size_t a = 0; a < phi->label_else; ++a)
+        {
+            if(args[a].block != pred) continue;
+            if(!IR_Value_Equal(args[a].value, IR_VALUE_REG(phi->dst)))
+                copies[count++] = (IR_Copy){ phi->dst, args[a].value };
+            break;
+        }
+    }
+    return count;
+}
+
+// The registers some copies write, and a walk over the blocks looking for where they are
+// read. Both are stamped, so that starting over clears them in one step.
+typedef struct
+{
+    size_t* written;  // Per register, `stamp` if the copies write it.
+    size_t reg_count; // Of `written`, the registers copies save values to are never in it.
+    size_t* seen;     // Per block, `stamp` once visited.
+    size_t* stack;
+    size_t stamp;
+} IR_CopyPlacement;
+
+static void IR_CopyPlacement__Mark(IR_CopyPlacement* self, const IR_Copy* copies, size_t count)
+{
+    self->stamp++;
+    for(size_t c = 0; c < count; ++c) self->written[copies[c].dst] = self->stamp;
+}
+
+static bool IR_CopyPlacement__Reads(const IR_CopyPlacement* self, IR_Value value)
+{
+    return value.type == IR_ValueType_Reg && value.value < self->reg_count && self->written[value.value] == self->stamp;
+}
+
+// Whether the phis of `to` read one of the registers when coming from `from`.
+static bool IR_CopyPlacement__EdgeReads(const IR_CopyPlacement* self, const IR_Proc* proc, size_t from, size_t to)
+{
+    const IR_InstrList* phis = &proc->blocks.data[to].instrs;
+    for(size_t i = 0; i < phis->count && phis->data[i].type == IR_OpType_Phi; ++i)
+    {
+        const IR_PhiArg* args = IR_Proc_PhiArgs(proc, &phis->data[i]);
+        for(size_t a = 0; a < phis->data[i].label_else; ++a)
+            if(args[a].block == from && IR_CopyPlacement__Reads(self, args[a].value)) return true;
+    }
+    return false;
+}
+
+// Whether nothing reads one of the registers on the way from `from` until `to`, whose
+// phis write them. The phis of `from` coming from `pred` are left to the caller.
+static bool IR_CopyPlacement__Unread(IR_CopyPlacement* self, const IR_Proc* proc, size_t pred, size_t from, size_t to)
+{
+    size_t top = 0;
+    self->seen[from] = self->stamp;
+    self->stack[top++] = from;
+    while(top)
+    {
+        size_t x = self->stack[--top];
+        const IR_InstrList* instrs = &proc->blocks.data[x].instrs;
+        for(size_t i = 0; i < instrs->count; ++i)
+            if(IR_CopyPlacement__Reads(self, instrs->data[i].lhs) || IR_CopyPlacement__Reads(self, instrs->data[i].rhs))
+                return false;
+
+        size_t succ[2], succ_count = IR_Block_Successors(&proc->blocks.data[x], succ);
+        for(size_t k = 0; k < succ_count; ++k)
+        {
+            // Phi arguments are read on the edge, which counts even going into `to`.
+            if(!(x == pred && succ[k] == from) && IR_CopyPlacement__EdgeReads(self, proc, x, succ[k])) return false;
+            if(succ[k] == to || self->seen[succ[k]] == self->stamp) continue;
+            self->seen[succ[k]] = self->stamp;
+            self->stack[top++] = succ[k];
+        }
+    }
+    return true;
+}
+
+// Whether the phis of `other` read one of the registers coming from `pred`, when those
+// that one of `copies` carries to another register could take it from there. With
+// `rename` they are made to, which also saves keeping both alive to the end of `pred`.
+static bool IR_CopyPlacement__ExitReads(const IR_CopyPlacement* self, IR_Proc* proc, size_t pred, size_t other,
+                                        const IR_Copy* copies, size_t count, bool rename)
+{
+    IR_InstrList* phis = &proc->blocks.data[other].instrs;
+    for(size_t i = 0; i < phis->count && phis->data[i].type == IR_OpType_Phi; ++i)
+    {
+        IR_PhiArg* args = IR_Proc_PhiArgs(proc, &phis->data[i]);
+        for(size_t a = 0; a < phis->data[i].label_else; ++a)
+        {
+            if(args[a].block != pred || args[a].value.type != IR_ValueType_Reg) continue;
+            size_t c = 0;
+            while(c < count && !IR_Value_Equal(copies[c].src, args[a].value)) ++c;
+            if(c < count && rename) args[a].value = IR_VALUE_REG(copies[c].dst);
+            else if(c == count && IR_CopyPlacement__Reads(self, args[a].value)) return true;
+        }
+    }
+    return false;
+}
+
+// Whether the copies of the back edge from `pred` to the loop header `b` can go before
+// the branch at the end of `pred`, where they also happen on the way out to `other`. They
+// can if nothing on that way reads what they overwrite, except for phis of `other` that
+// can read it where it was copied to. If other phis of `other` do, its copies from `pred`
+// are added to them, which then must not overwrite anything that is read on the way back
+// to `b` either, and taken off its phis.
+static bool IR_CopyPlacement__BeforeBranch(IR_CopyPlacement* self, IR_Proc* proc, size_t pred, size_t b, size_t other,
+                                           IR_Copy* copies, size_t* count)
+{
+    const IR_InstrList* instrs = &proc->blocks.data[pred].instrs;
+    IR_Value cond = instrs->data[instrs->count - 1].lhs;
+    IR_CopyPlacement__Mark(self, copies, *count);
+    if(other == b || IR_CopyPlacement__Reads(self, cond) || !IR_CopyPlacement__Unread(self, proc, pred, other, b))
+        return false;
+    if(!IR_CopyPlacement__ExitReads(self, proc, pred, other, copies, *count, false))
+    {
+        IR_CopyPlacement__ExitReads(self, proc, pred, other, copies, *count, true);
+        return true;
+    }
+
+    size_t joined = IR__EdgeCopies(proc, pred, other, copies + *count);
+    IR_CopyPlacement__Mark(self, copies + *count, joined);
+    if(IR_CopyPlacement__Reads(self, cond) || !IR_CopyPlacement__Unread(self, proc, pred, b, other)) return false;
+    *count += joined;
+
+    IR_InstrList* phis = &proc->blocks.data[other].instrs;
+    for(size_t i = 0; i < phis->count && phis->data[i].type == IR_OpType_Phi; ++i)
+    {
+        IR_PhiArg* args = IR_Proc_PhiArgs(proc, &phis->data[i]);
+        for(size_t a = 0; a < phis->data[i].label_else; ++a)
+            if(args[a].block == pred) args[a].value = IR_VALUE_REG(phis->data[i].dst);
+    }
+    return true;
+}
+
+// Moves the blocks LeaveSSA appended for split edges to right after the predecessor they
+// were split from, so a loop's back edge falls through into its copies instead of jumping
+// to the end of the procedure and back.
+static void IR__PlaceSplitBlocks(IR_Proc* proc, size_t block_count, const size_t* split_from, Arena* scratch)
+{
+    size_t total = proc->blocks.count;
+    if(total == block_count) return;
+
+    size_t* map = ARENA_ARRAY(scratch, size_t, total);
+    IR_Block* blocks = ARENA_ARRAY(scratch, IR_Block, total);
+    size_t placed = 0;
+    for(size_t b = 0; b < block_count; ++b)
+    {
+        map[b] = placed;
+        blocks[placed++] = proc->blocks.data[b];
+        for(size_t s = block_count; s < total; ++s)
+        {
+            if(split_from[s - block_count] != b) continue;
+            map[s] = placed;
+            blocks[placed++] = proc->blocks.data[s];
+        }
+    }
+    memcpy(proc->blocks.data, blocks, sizeof(IR_Block) * total);
+
+    for(size_t b = 0; b < total; ++b)
+    {
+        IR_InstrList* instrs = &proc->blocks.data[b].instrs;
+        if(!instrs->count) continue;
+        IR_Instr* t = &instrs->data[instrs->count - 1];
+        if(t->type == IR_OpType_Jmp) t->label = map[t->label];
+        else if(t->type == IR_OpType_Br)
+        {
+            t->label = map[t->label];
+            t->label_else = map[t->label_else];
+        }
+    }
+}
+
+bool IR_LeaveSSA(IR_Proc* proc, Arena* scratch)
+{
+    bool any = false;
+    size_t block_count = proc->blocks.count, max_phis = 0;
+    for(size_t b = 0; b < block_count; ++b)
+    {
+        const IR_InstrList* instrs = &proc->blocks.data[b].instrs;
+        size_t count = 0;
+        while(count < instrs->count && instrs->data[count].type == IR_OpType_Phi) ++count;
+        if(count > max_phis) max_phis = count;
+        any |= count > 0;
+    }
+    if(!any) return false;
+
+    IR_Cfg cfg;
+    IR_Cfg_Build(&cfg, proc, scratch);
+    // Those of a back edge can have the ones of the loop's exit added.
+    IR_Copy* copies = ARENA_ARRAY(scratch, IR_Copy, 2 * max_phis);
+    // For each block made on an edge, the predecessor it was split from.
+    size_t* split_from = ARENA_ARRAY(scratch, size_t, cfg.pred_start[block_count]);
+    IR_InstrList moves;
+    IR_InstrList_Initialize(&moves);
+
+    size_t max_blocks = block_count + cfg.pred_start[block_count];
+    IR_CopyPlacement placement = {
+        .written = ARENA_ARRAY(scratch, size_t, proc->reg_count + 1), .reg_count = proc->reg_count,
+        .seen = ARENA_ARRAY(scratch, size_t, max_blocks), .stack = ARENA_ARRAY(scratch, size_t, max_blocks),
+        .stamp = 0,
+    };
+    memset(placement.written, 0, sizeof(size_t) * placement.reg_count);
+    memset(placement.seen, 0, sizeof(size_t) * max_blocks);
+
+    for(size_t b = 0; b < block_count; ++b)
+    {
+        size_t phi_count = 0;
+        while(phi_count < proc->blocks.data[b].instrs.count
+           && proc->blocks.data[b].instrs.data[phi_count].type == IR_OpType_Phi) ++phi_count;
+        if(!phi_count) continue;
+
+        for(size_t p = cfg.pred_start[b]; p < cfg.pred_start[b + 1]; ++p)
+        {
+            size_t pred = cfg.preds[p], copy_count = IR__EdgeCopies(proc, pred, b, copies);
+            if(!copy_count) continue;
+
+            // The copies can't simply go in a predecessor that also goes elsewhere, they
+            // get a block of their own on the edge. On a loop's back edge that would be a
+            // second jump every iteration, so there they go before the bottom test when
+            // leaving the loop doesn't mind.
+            size_t at = pred;
+            if(cfg.succ_count[pred] > 1)
+            {
+                IR_Instr* t = &proc->blocks.data[pred].instrs.data[proc->blocks.data[pred].instrs.count - 1];
+                size_t other = t->label == b ? t->label_else : t->label;
+                if(!IR_Cfg_Dominates(&cfg, b, pred)
+                   || !IR_CopyPlacement__BeforeBranch(&placement, proc, pred, b, other, copies, &copy_count))
+                {
+                    IR_Block edge;
+                    IR_InstrList_Initialize(&edge.instrs);
+                    IR_InstrList_PushValue(&edge.instrs, (IR_Instr){ .type = IR_OpType_Jmp, .label = b });
+                    IR_BlockList_PushValue(&proc->blocks, edge);
+                    at = proc->blocks.count - 1;
+                    split_from[at - block_count] = pred;
+                    t = &proc->blocks.data[pred].instrs.data[proc->blocks.data[pred].instrs.count - 1];
+                    if(t->label == b) t->label = at;
+                    if(t->label_else == b) t->label_else = at;
+                }
+            }
+
+            IR_InstrList_Clear(&moves);
+            IR__EmitParallelCopies(proc, &moves, copies, copy_count);
+            IR_InstrList* instrs = &proc->blocks.data[at].instrs;
+            IR_Instr terminator = instrs->data[--instrs->count];
+            IR_InstrList_Append(instrs, moves.data, moves.count);
+            IR_InstrList_PushValue(instrs, terminator);
+        }
+
+        IR_InstrList* instrs = &proc->blocks.data[b].instrs;
+        memmove(instrs->data, instrs->data + phi_count, sizeof(IR_Instr) * (instrs->count - phi_count));
+        instrs->count -= phi_count;
+    }
+
+    IR_InstrList_Free(&moves);
+    IR_PhiArgList_Clear(&proc->phi_args);
+    IR__PlaceSplitBlocks(proc, block_count, split_from, scratch);
+    return true;
+}
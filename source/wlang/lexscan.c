@@ -0,0 +1,121 @@
+#include <wlang/lexscan.h>
+#include <stdbool.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#  define LEXSCAN_X86 1
+#  include <immintrin.h>
+#else
+#  define LEXSCAN_X86 0
+#endif
+
+//:==========----------- Scalar -----------==========://
+
+static inline bool LexScan__IsSpace(unsigned char c) { return c == ' ' || (unsigned char)(c - '\t') <= '\r' - '\t'; }
+static inline bool LexScan__IsDigit(unsigned char c) { return (unsigned char)(c - '0') <= 9; }
+static inline bool LexScan__IsAlpha(unsigned char c) { return (unsigned char)((c | 0x20) - 'a') <= 'z' - 'a'; }
+
+static const char* LexScan__Scalar_Space(const char* p, const char* end)
+{ while(p < end && LexScan__IsSpace(*p)) ++p; return p; }
+
+static const char* LexScan__Scalar_Iden(const char* p, const char* end)
+{ while(p < end && (LexScan__IsAlpha(*p) || LexScan__IsDigit(*p) || *p == '_')) ++p; return p; }
+
+static const char* LexScan__Scalar_Digits(const char* p, const char* end)
+{ while(p < end && (LexScan__IsDigit(*p) || *p == '_')) ++p; return p; }
+
+#if LEXSCAN_X86
+
+//:==========----------- SSE2 -----------==========://
+
+// x in [lo, lo + span] as unsigned bytes: (x - lo) == min(x - lo, span).
+#define LEXSCAN_SSE2_RANGE(X, LO, SPAN) \
+    _mm_cmpeq_epi8(_mm_min_epu8(_mm_sub_epi8((X), _mm_set1_epi8(LO)), _mm_set1_epi8(SPAN)), \
+                   _mm_sub_epi8((X), _mm_set1_epi8(LO)))
+
+static inline __m128i LexScan__SSE2_Space(__m128i x)
+{ return _mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8(' ')), LEXSCAN_SSE2_RANGE(x, '\t', '\r' - '\t')); }
+
+static inline __m128i LexScan__SSE2_Digits(__m128i x)
+{ return _mm_or_si128(LEXSCAN_SSE2_RANGE(x, '0', 9), _mm_cmpeq_epi8(x, _mm_set1_epi8('_'))); }
+
+static inline __m128i LexScan__SSE2_Iden(__m128i x)
+{ return _mm_or_si128(LexScan__SSE2_Digits(x), LEXSCAN_SSE2_RANGE(_mm_or_si128(x, _mm_set1_epi8(0x20)), 'a', 'z' - 'a')); }
+
+#define DEFINE_LEXSCAN_SSE2_FN(NAME) \
+    static const char* LexScan__SSE2_Skip##NAME(const char* p, const char* end) \
+    { while(end - p >= 16) \
+      { unsigned m = ~(unsigned)_mm_movemask_epi8(LexScan__SSE2_##NAME(_mm_loadu_si128((const __m128i*)p))) & 0xFFFF; \
+        if(m) return p + __builtin_ctz(m); \
+        p += 16; } \
+      return LexScan__Scalar_##NAME(p, end); }
+
+DEFINE_LEXSCAN_SSE2_FN(Space)
+DEFINE_LEXSCAN_SSE2_FN(Iden)
+DEFINE_LEXSCAN_SSE2_FN(Digits)
+
+//:==========----------- AVX2 -----------==========://
+
+#define LEXSCAN_AVX2_TARGET __attribute__((target("avx2")))
+#define LEXSCAN_AVX2_RANGE(X, LO, SPAN) \
+    _mm256_cmpeq_epi8(_mm256_min_epu8(_mm256_sub_epi8((X), _mm256_set1_epi8(LO)), _mm256_set1_epi8(SPAN)), \
+                      _mm256_sub_epi8((X), _mm256_set1_epi8(LO)))
+
+LEXSCAN_AVX2_TARGET static inline __m256i LexScan__AVX2_Space(__m256i x)
+{ return _mm256_or_si256(_mm256_cmpeq_epi8(x, _mm256_set1_epi8(' ')), LEXSCAN_AVX2_RANGE(x, '\t', '\r' - '\t')); }
+
+LEXSCAN_AVX2_TARGET static inline __m256i LexScan__AVX2_Digits(__m256i x)
+{ return _mm256_or_si256(LEXSCAN_AVX2_RANGE(x, '0', 9), _mm256_cmpeq_epi8(x, _mm256_set1_epi8('_'))); }
+
+LEXSCAN_AVX2_TARGET static inline __m256i LexScan__AVX2_Iden(__m256i x)
+{ return _mm256_or_si256(LexScan__AVX2_Digits(x), LEXSCAN_AVX2_RANGE(_mm256_or_si256(x, _mm256_set1_epi8(0x20)), 'a', 'z' - 'a')); }
+
+// Most runs are short, so the 32 byte loop falls through to the SSE2 kernel for the tail.
+#define DEFINE_LEXSCAN_AVX2_FN(NAME) \
+    LEXSCAN_AVX2_TARGET static const char* LexScan__AVX2_Skip##NAME(const char* p, const char* end) \
+    { while(end - p >= 32) \
+      { unsigned m = ~(unsigned)_mm256_movemask_epi8(LexScan__AVX2_##NAME(_mm256_loadu_si256((const __m256i*)p))); \
+        if(m) return p + __builtin_ctz(m); \
+        p += 32; } \
+      return LexScan__SSE2_Skip##NAME(p, end); }
+
+DEFINE_LEXSCAN_AVX2_FN(Space)
+DEFINE_LEXSCAN_AVX2_FN(Iden)
+DEFINE_LEXSCAN_AVX2_FN(Digits)
+
+#endif
+
+static const LexScanKernel LexScan__kernels[] =
+{
+    { "scalar", &LexScan__Scalar_Space, &LexScan__Scalar_Iden, &LexScan__Scalar_Digits },
+#if LEXSCAN_X86
+    { "sse2", &LexScan__SSE2_SkipSpace, &LexScan__SSE2_SkipIden, &LexScan__SSE2_SkipDigits },
+    { "avx2", &LexScan__AVX2_SkipSpace, &LexScan__AVX2_SkipIden, &LexScan__AVX2_SkipDigits },
+#endif
+};
+
+LexScanKernel LexScan = { "scalar", &LexScan__Scalar_Space, &LexScan__Scalar_Iden, &LexScan__Scalar_Digits };
+
+const LexScanKernel* LexScan_Available(size_t* count)
+{
+    size_t n = 1;
+#if LEXSCAN_X86
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("sse2")) n = 2;
+    if(n == 2 && __builtin_cpu_supports("avx2")) n = 3;
+#endif
+    *count = n;
+    return LexScan__kernels;
+}
+
+void LexScan_Select(void)
+{
+    size_t n;
+    const LexScanKernel* kernels = LexScan_Available(&n);
+#ifdef __OPTIMIZE__
+    LexScan = kernels[n - 1];
+#else
+    // Without optimization every intrinsic goes through the stack, and the vector kernels
+    // are about three times slower than the scalar one.
+    LexScan = kernels[0];
+#endif
+}
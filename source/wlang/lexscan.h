@@ -0,0 +1,30 @@
+#ifndef WLANG_HEADER_LEXSCAN_
+#define WLANG_HEADER_LEXSCAN_
+#include <stddef.h>
+
+//:==========----------- Lexer Scanning Kernels -----------==========://
+
+// Each function returns the first position in [p, end) that does not belong to the
+// run (or `end`). Character classes match the C locale:
+//   space: isspace()             iden: isalnum() or '_'          digits: isdigit() or '_'
+typedef const char* (*LexScanFn)(const char* p, const char* end);
+
+typedef struct
+{
+    const char* name;
+    LexScanFn skip_space, skip_iden, skip_digits;
+} LexScanKernel;
+
+// The kernel the lexer uses, picked by LexScan_Select().
+extern LexScanKernel LexScan;
+
+// Picks the widest kernel the CPU supports (AVX2, then SSE2, then scalar), in an
+// optimized build. Unoptimized builds keep the scalar kernel.
+void LexScan_Select(void);
+
+// All kernels usable on this machine, widest last, at most LEXSCAN_MAX_KERNELS of them.
+// Used by the lexer benchmark.
+#define LEXSCAN_MAX_KERNELS 3
+const LexScanKernel* LexScan_Available(size_t* count);
+
+#endif//WLANG_HEADER_LEXSCAN_
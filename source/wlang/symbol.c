@@ -0,0 +1,66 @@
+#include <wlang/symbol.h>
+
+DEFINE_LIST_TYPE(CStr)
+DEFINE_LIST_TYPE(Symbol)
+
+typedef struct { const char* data; size_t length; } SymbolKey;
+typedef struct { const char* name; size_t length; Symbol sym; } SymbolEntry;
+
+static bool SymbolEntry_Equal(SymbolEntry* entry, SymbolKey key)
+{ return entry->length == key.length && memcmp(entry->name, key.data, key.length) == 0; }
+
+static size_t SymbolKey_Hash(SymbolKey key) { return Hash_Bytes(key.data, key.length); }
+
+DECLARE_HASHMAP_TYPE(SymbolEntry, SymbolKey)
+DEFINE_HASHMAP_TYPE(SymbolEntry, SymbolKey)
+
+static struct
+{
+    SymbolEntryHashMap entries;
+    CStrList names; // Indexed by symbol.
+    bool initialized;
+} Symbol__table;
+
+static const char* Symbol__keywords[] = { "return", "if", "else", "proc", "inline", "noinline", "while" };
+
+void Symbol_InitializeTable(void)
+{
+    if(Symbol__table.initialized) return;
+    Symbol__table.initialized = true;
+    SymbolEntryHashMap_Initialize(&Symbol__table.entries, &SymbolKey_Hash, &SymbolEntry_Equal);
+    CStrList_Initialize(&Symbol__table.names);
+    CStrList_PushValue(&Symbol__table.names, NULL); // Symbol_None
+
+    for(size_t i = 0; i < sizeof(Symbol__keywords) / sizeof(Symbol__keywords[0]); ++i)
+        Symbol_Intern(Symbol__keywords[i], strlen(Symbol__keywords[i]));
+}
+
+void Symbol_FreeTable(void)
+{
+    if(!Symbol__table.initialized) return;
+    CStrList_ForEach(&Symbol__table.names, &CStr_Free);
+    CStrList_Free(&Symbol__table.names);
+    SymbolEntryHashMap_Free(&Symbol__table.entries);
+    Symbol__table.initialized = false;
+}
+
+Symbol Symbol_Intern(const char* name, size_t length)
+{
+    SymbolKey key = { name, length };
+    SymbolEntry* e = SymbolEntryHashMap_Find(&Symbol__table.entries, key);
+    if(e) return e->sym;
+
+    char* copy = malloc(length + 1);
+    memcpy(copy, name, length);
+    copy[length] = '\0';
+
+    Symbol sym = (Symbol)Symbol__table.names.count;
+    CStrList_PushValue(&Symbol__table.names, copy);
+    SymbolEntryHashMap_Insert(&Symbol__table.entries, (SymbolKey){ copy, length }, (SymbolEntry){ copy, length, sym });
+    return sym;
+}
+
+const char* Symbol_Name(Symbol sym)
+{
+    return sym != Symbol_None && sym < Symbol__table.names.count ? Symbol__table.names.data[sym] : "<UNKNOWN>";
+}
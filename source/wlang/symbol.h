@@ -0,0 +1,37 @@
+#ifndef WLANG_HEADER_SYMBOL_
+#define WLANG_HEADER_SYMBOL_
+#include <wlang/type.h>
+
+//:==========----------- Interned Symbols -----------==========://
+
+// Every distinct identifier is stored once in a global table and referred to by
+// its index, so names can be compared and hashed as integers.
+typedef uint32_t Symbol;
+DECLARE_LIST_TYPE(Symbol)
+
+// Keywords are interned first, in this order, so they always get these ids.
+enum
+{
+    Symbol_None,
+    Symbol_Return,
+    Symbol_If,
+    Symbol_Else,
+    Symbol_Proc,
+    Symbol_Inline,
+    Symbol_Noinline,
+    Symbol_While,
+    Symbol__FirstUser,
+    Symbol__FirstKeyword = Symbol_Return,
+};
+
+void Symbol_InitializeTable(void);
+void Symbol_FreeTable(void);
+Symbol Symbol_Intern(const char* name, size_t length);
+const char* Symbol_Name(Symbol sym);
+
+static inline bool Symbol_IsKeyword(Symbol sym)
+{ return sym >= Symbol__FirstKeyword && sym < Symbol__FirstUser; }
+
+static inline size_t Symbol_Hash(Symbol sym) { return Hash_Integer(sym); }
+
+#endif//WLANG_HEADER_SYMBOL_
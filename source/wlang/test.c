@@ -4,12 +4,21 @@
 #include <stdlib.h>
 #include <stdarg.h>
 #include <stdbool.h>
+#include <limits.h>
 #include <wlang/util.h>
 #include <wlang/pim.h>
 #include <wlang/type.h>
+#include <wlang/symbol.h>
+#include <wlang/input.h>
+#include <wlang/lexscan.h>
+#include <wlang/timing.h>
 #include <wlang/ir.h>
-#include <wlang/arch/gen.h> // Unused?
-#include <wlang/arch/x86_64/arch.h> // Unused?
+#include <wlang/irgen.h>
+#include <wlang/iropt.h>
+#include <wlang/arena.h>
+#include <wlang/arch/gen.h>
+#include <wlang/arch/x86_64/arch.h>
+#include <wlang/arch/x86_64/gen_x86_64.h>
 
 //:==========----------- Target-Specific Macros -----------==========://
 
@@ -44,140 +53,347 @@ enum TokenType
     TokenType_NotEqual,
     TokenType_LessEqual,
     TokenType_GreaterEqual,
-    TokenType__Last
+    TokenType_DoubleAmp,
+    TokenType_DoublePipe,
+    TokenType_KwReturn,
+    TokenType_KwIf,
+    TokenType_KwElse,
+    TokenType_KwProc,
+    TokenType_KwInline,
+    TokenType_KwNoinline,
+    TokenType_KwWhile,
+    TokenType__Last,
+    TokenType__FirstKeyword = TokenType_KwReturn,
 };
 
 const char* TokenType_ToString(enum TokenType t)
 {
     switch(t)
     {
+    case TokenType_Eof: return "End of File";
     case TokenType_Other: return "Other";
     case TokenType_Iden: return "Identifier";
     case TokenType_Int: return "Integer Literal";
     case TokenType_Float: return "Float Literal";
     case TokenType_String: return "String Literal";
+    case TokenType_DoubleAmp: return "&&";
+    case TokenType_DoublePipe: return "||";
+    case TokenType_KwReturn: return "return";
+    case TokenType_KwIf: return "if";
+    case TokenType_KwElse: return "else";
+    case TokenType_KwProc: return "proc";
+    case TokenType_KwInline: return "inline";
+    case TokenType_KwNoinline: return "noinline";
+    case TokenType_KwWhile: return "while";
     default: return "<UNKNOWN>";
     }
 }
 
-typedef struct { int type; PIM_OWN char* value; } Token;
-DECLARE_LIST_TYPE(Token)
-DEFINE_LIST_TYPE(Token)
+// The token stream is kept as parallel arrays indexed by token number. The parser
+// mostly looks at kinds, so those are packed on their own; spans point back into
+// the source buffer and values hold what the lexer already decoded.
+typedef int16_t TokenKind;
+typedef uint32_t TokenPos; // InputFile_Open rejects inputs these can't address.
+typedef union { Symbol sym; long ival; double fval; } TokenValue;
+DECLARE_LIST_TYPE(TokenKind)
+DEFINE_LIST_TYPE(TokenKind)
+DECLARE_LIST_TYPE(TokenPos)
+DEFINE_LIST_TYPE(TokenPos)
+DECLARE_LIST_TYPE(TokenValue)
+DEFINE_LIST_TYPE(TokenValue)
 
-typedef struct { TokenList tokens; FILE* source; size_t current; } Lexer;
+typedef struct
+{
+    TokenKindList kinds;
+    TokenPosList offsets, lengths;
+    TokenValueList values; // Symbol for identifiers and keywords, decoded literal for numbers.
+} TokenStream;
 
-void Lexer_Initialize(Lexer* self, const char* filepath)
+void TokenStream_Initialize(TokenStream* self)
 {
-    self->source = fopen(filepath, "r");
-    if(!self->source) perror("Failed to open file");
-    TokenList_Initialize(&self->tokens);
-    self->current = 0;
+    TokenKindList_Initialize(&self->kinds);
+    TokenPosList_Initialize(&self->offsets);
+    TokenPosList_Initialize(&self->lengths);
+    TokenValueList_Initialize(&self->values);
 }
-void Lexer_Free(Lexer* self)
+
+void TokenStream_Free(TokenStream* self)
+{
+    TokenKindList_Free(&self->kinds);
+    TokenPosList_Free(&self->offsets);
+    TokenPosList_Free(&self->lengths);
+    TokenValueList_Free(&self->values);
+}
+
+// In streaming mode the token arrays are a ring of LEXER_WINDOW entries that is filled
+// on demand, so memory stays constant no matter how big the input is. The parser only
+// looks two tokens ahead and reads a consumed token's value right away, so a small
+// window is enough. It is refilled a batch at a time rather than a token at a time, which
+// is also what -time-report measures. Otherwise Lexer_LexFile keeps the whole stream.
+#define LEXER_WINDOW 64
+
+typedef struct
 {
-    for(size_t i = 0; i < self->tokens.count; ++i)
+    TokenStream tokens;
+    InputFile source;
+    const char* pos;   // Where lexing continues.
+    size_t lexed;      // Number of tokens lexed so far.
+    size_t current;    // Index of the next token the parser gets.
+    bool streaming;
+} Lexer;
+
+bool Lexer_Initialize(Lexer* self, const char* filepath, bool streaming)
+{
+    TokenStream_Initialize(&self->tokens);
+    self->current = 0;
+    self->lexed = 0;
+    self->streaming = streaming;
+    if(streaming)
     {
-        Token* t = &self->tokens.data[i];
-        if(t->type == TokenType_Iden) free(t->value);
+        TokenKindList_Reserve(&self->tokens.kinds, LEXER_WINDOW);
+        TokenPosList_Reserve(&self->tokens.offsets, LEXER_WINDOW);
+        TokenPosList_Reserve(&self->tokens.lengths, LEXER_WINDOW);
+        TokenValueList_Reserve(&self->tokens.values, LEXER_WINDOW);
     }
-    TokenList_Free(&self->tokens);
-    fclose(self->source);
+    bool ok = InputFile_Open(&self->source, filepath);
+    self->pos = self->source.data;
+    return ok;
 }
-void Lexer_LexFile(Lexer* l)
+void Lexer_Free(Lexer* self)
+{
+    TokenStream_Free(&self->tokens);
+    InputFile_Close(&self->source);
+}
+
+static inline size_t Lexer__Slot(Lexer* self, size_t index)
+{ return self->streaming ? index & (LEXER_WINDOW - 1) : index; }
+
+static inline void Lexer__Push(Lexer* l, int kind, TokenValue value, const char* start, const char* end)
 {
-    while(fpeekc(l->source) != EOF)
+    if(l->streaming)
     {
-        while(isspace(fpeekc(l->source))) fgetc(l->source);
-        if(fpeekc(l->source) == EOF) break;
+        size_t slot = Lexer__Slot(l, l->lexed);
+        l->tokens.kinds.data[slot] = (TokenKind)kind;
+        l->tokens.offsets.data[slot] = (TokenPos)(start - l->source.data);
+        l->tokens.lengths.data[slot] = (TokenPos)(end - start);
+        l->tokens.values.data[slot] = value;
+    }
+    else
+    {
+        TokenKindList_PushValue(&l->tokens.kinds, (TokenKind)kind);
+        TokenPosList_PushValue(&l->tokens.offsets, (TokenPos)(start - l->source.data));
+        TokenPosList_PushValue(&l->tokens.lengths, (TokenPos)(end - start));
+        TokenValueList_PushValue(&l->tokens.values, value);
+    }
+    l->lexed++;
+}
 
-        /**/ if(isalpha(fpeekc(l->source)) || fpeekc(l->source) == '_')
-        {
-            DynamicString s;
-            DynamicString_Initialize(&s);
+static inline bool Lexer__IsIdenStart(char c) { return isalpha((unsigned char)c) || c == '_'; }
 
-            while(isalnum(fpeekc(l->source)) || fpeekc(l->source) == '_')
-                DynamicString_Add(&s, fgetc(l->source));
+// Every printable ASCII character starts a token, other punctuation than the parser
+// knows is reported by the parser. Anything else is reported here and skipped.
+static inline bool Lexer__StartsToken(char c) { return isgraph((unsigned char)c); }
 
-            TokenList_PushValue(&l->tokens, (Token){ TokenType_Iden, s.data });
-        }
-        else if(isdigit(fpeekc(l->source)))
-        {
-            DynamicString s;
-            DynamicString_Initialize(&s);
-            enum TokenType tt = TokenType_Int;
+void Lexer__Error(Lexer* l, const char* at, const char* msg)
+{
+    size_t line, column;
+    InputFile_Location(&l->source, (size_t)(at - l->source.data), &line, &column);
+    fprintf(stderr, "%s:%zu:%zu: \033[0;31mError:\033[0;0m %s\n", l->source.path, line, column, msg);
+}
 
-            while(isdigit(fpeekc(l->source)) || fpeekc(l->source) == '_')
-                DynamicString_Add(&s, fgetc(l->source));
+void Lexer__ErrorByte(Lexer* l, const char* at)
+{
+    char msg[32];
+    snprintf(msg, sizeof(msg), "Unexpected byte 0x%02X.", (unsigned char)*at);
+    Lexer__Error(l, at, msg);
+}
 
-            if(fpeekc(l->source) == '.')
-            {
-                tt = TokenType_Float;
-                fgetc(l->source);
-                while(isdigit(fpeekc(l->source)) || fpeekc(l->source) == '_')
-                    DynamicString_Add(&s, fgetc(l->source));
-            }
+// Lexes one token, returns false at the end of the input.
+bool Lexer__LexOne(Lexer* l)
+{
+    const char* end = l->source.data + l->source.size;
+    const char* p = LexScan.skip_space(l->pos, end);
+    while(p != end && !Lexer__StartsToken(*p))
+    {
+        Lexer__ErrorByte(l, p);
+        p = LexScan.skip_space(p + 1, end);
+    }
+    if(p == end) { l->pos = p; return false; }
 
-            TokenList_PushValue(&l->tokens, (Token){ tt, s.data });
+    const char* start = p;
+    /**/ if(Lexer__IsIdenStart(*p))
+    {
+        p = LexScan.skip_iden(p + 1, end);
+
+        Symbol sym = Symbol_Intern(start, (size_t)(p - start));
+        int tt = Symbol_IsKeyword(sym) ? TokenType__FirstKeyword + (int)(sym - Symbol__FirstKeyword) : TokenType_Iden;
+        Lexer__Push(l, tt, (TokenValue){ .sym = sym }, start, p);
+    }
+    else if(isdigit((unsigned char)*p))
+    {
+        // Unsigned, so that a literal too big for a long wraps harmlessly until it is reported.
+        unsigned long ival = 0;
+        bool too_big = false;
+        p = LexScan.skip_digits(p + 1, end);
+        for(const char* q = start; q < p; ++q)
+        {
+            if(*q == '_') continue;
+            unsigned long digit = (unsigned long)(*q - '0');
+            if(ival > (LONG_MAX - digit) / 10) too_big = true;
+            ival = ival * 10 + digit;
         }
-        else if(fpeekc(l->source) == '=')
+
+        if(p < end && *p == '.')
         {
-            fgetc(l->source);
-            if(fpeekc(l->source) == '=')
-            {
-                fgetc(l->source);
-                TokenList_PushValue(&l->tokens, (Token){ TokenType_DoubleEqual, NULL });
-            }
-            else TokenList_PushValue(&l->tokens, (Token){ '=', NULL });
+            double fval = 0, scale = 0.1;
+            for(const char* q = start; q < p; ++q)
+                if(*q != '_') fval = fval * 10 + (*q - '0');
+            const char* fraction = ++p;
+            p = LexScan.skip_digits(p, end);
+            for(const char* q = fraction; q < p; ++q)
+                if(*q != '_') { fval += (*q - '0') * scale; scale *= 0.1; }
+            Lexer__Push(l, TokenType_Float, (TokenValue){ .fval = fval }, start, p);
         }
-        else if(fpeekc(l->source) == '>')
+        else
         {
-            fgetc(l->source);
-            if(fpeekc(l->source) == '=')
-            {
-                fgetc(l->source);
-                TokenList_PushValue(&l->tokens, (Token){ TokenType_GreaterEqual, NULL });
-            }
-            else TokenList_PushValue(&l->tokens, (Token){ '>', NULL });
+            if(too_big) Lexer__Error(l, start, "Integer literal is out of range.");
+            Lexer__Push(l, TokenType_Int, (TokenValue){ .ival = (long)ival }, start, p);
         }
-        else if(fpeekc(l->source) == '<')
+    }
+    else
+    {
+        int tt = (unsigned char)*p++;
+        if(p < end && *p == '=')
         {
-            fgetc(l->source);
-            if(fpeekc(l->source) == '=')
+            switch(tt)
             {
-                fgetc(l->source);
-                TokenList_PushValue(&l->tokens, (Token){ TokenType_LessEqual, NULL });
+            case '=': tt = TokenType_DoubleEqual; ++p; break;
+            case '>': tt = TokenType_GreaterEqual; ++p; break;
+            case '<': tt = TokenType_LessEqual; ++p; break;
+            case '!': tt = TokenType_NotEqual; ++p; break;
+            default: break;
             }
-            else TokenList_PushValue(&l->tokens, (Token){ '<', NULL });
         }
-        else if(fpeekc(l->source) == '!')
+        else if(p < end && *p == tt && (tt == '&' || tt == '|'))
         {
-            fgetc(l->source);
-            if(fpeekc(l->source) == '=')
-            {
-                fgetc(l->source);
-                TokenList_PushValue(&l->tokens, (Token){ TokenType_NotEqual, NULL });
-            }
-            else TokenList_PushValue(&l->tokens, (Token){ '!', NULL });
+            tt = tt == '&' ? TokenType_DoubleAmp : TokenType_DoublePipe;
+            ++p;
         }
-        else TokenList_PushValue(&l->tokens, (Token){ fgetc(l->source), NULL });
+        Lexer__Push(l, tt, (TokenValue){ .ival = 0 }, start, p);
     }
+
+    l->pos = p;
+    return true;
+}
+
+// Lexes the whole input up front. Only for non-streaming lexers.
+void Lexer_LexFile(Lexer* l)
+{
+    // Roughly one token per 4 bytes of source, avoids most regrowth on big inputs.
+    size_t guess = l->source.size / 4;
+    TokenKindList_Reserve(&l->tokens.kinds, guess);
+    TokenPosList_Reserve(&l->tokens.offsets, guess);
+    TokenPosList_Reserve(&l->tokens.lengths, guess);
+    TokenValueList_Reserve(&l->tokens.values, guess);
+
+    while(Lexer__LexOne(l));
+}
+
+// Lexes up to token `index` and, when streaming, on as far as the window has room for
+// without overwriting the token before the current one.
+void Lexer__Refill(Lexer* self, size_t index)
+{
+    TimingPoint start = Timing_Start(TimingPhase_Lex);
+    size_t limit = self->streaming ? self->current + LEXER_WINDOW - 2 : 0;
+    if(limit <= index) limit = index + 1;
+    while(self->lexed < limit && Lexer__LexOne(self));
+    Timing_Stop(TimingPhase_Lex, start);
+}
+
+// Makes sure token `index` has been lexed, unless the input ends before it.
+static inline void Lexer__Fill(Lexer* self, size_t index)
+{
+    if(self->lexed <= index) Lexer__Refill(self, index);
 }
 
-Token* Lexer_Next(Lexer* self)
+// Token indices past the end of the stream are the end of file token.
+static inline int Lexer_Kind(Lexer* self, size_t index)
 {
-    static Token eof_token = { TokenType_Eof, "<EOF>" };
-    if(self->current >= self->tokens.count) return &eof_token;
-    return &self->tokens.data[self->current++];
+    Lexer__Fill(self, index);
+    return index < self->lexed ? self->tokens.kinds.data[Lexer__Slot(self, index)] : TokenType_Eof;
 }
 
-Token* Lexer_PeekN(Lexer* self, int n)
+// The accessors below are for tokens that were already peeked or consumed.
+static inline Symbol Lexer_Symbol(Lexer* self, size_t index)
+{ return index < self->lexed ? self->tokens.values.data[Lexer__Slot(self, index)].sym : Symbol_None; }
+
+static inline long Lexer_Integer(Lexer* self, size_t index)
+{ return index < self->lexed ? self->tokens.values.data[Lexer__Slot(self, index)].ival : 0; }
+
+static inline size_t Lexer_Offset(Lexer* self, size_t index)
+{ return index < self->lexed ? self->tokens.offsets.data[Lexer__Slot(self, index)] : self->source.size; }
+
+// Returns the index of the consumed token.
+static inline size_t Lexer_Next(Lexer* self)
 {
-    static Token eof_token = { TokenType_Eof, "<EOF>" };
-    if(self->current + n - 1 >= self->tokens.count) return &eof_token;
-    return &self->tokens.data[self->current + n - 1];
+    size_t index = self->current;
+    Lexer__Fill(self, index);
+    if(self->current < self->lexed) self->current++;
+    return index;
 }
 
-Token* Lexer_Peek(Lexer* self) { return Lexer_PeekN(self, 1); }
+static inline int Lexer_PeekN(Lexer* self, int n) { return Lexer_Kind(self, self->current + n - 1); }
+static inline int Lexer_Peek(Lexer* self) { return Lexer_PeekN(self, 1); }
+
+// Lexes `path` a few times with every scanning kernel the CPU supports and prints
+// the best throughput of each. Also checks that all kernels produce the same tokens.
+// The kernels take turns run by run, so that none of them gets the warm page cache or
+// the allocator state another one left behind to itself.
+int Lexer_Benchmark(const char* path)
+{
+    size_t kernel_count;
+    const LexScanKernel* kernels = LexScan_Available(&kernel_count);
+    double best[LEXSCAN_MAX_KERNELS] = { 0 };
+    size_t hashes[LEXSCAN_MAX_KERNELS] = { 0 }, counts[LEXSCAN_MAX_KERNELS] = { 0 }, bytes = 0;
+    int ret = 0;
+
+    // The first round only warms up.
+    for(int run = 0; run < 6; ++run)
+    {
+        for(size_t k = 0; k < kernel_count; ++k)
+        {
+            LexScan = kernels[k];
+            Lexer lexer;
+            if(!Lexer_Initialize(&lexer, path, false)) return 1;
+            double start = Clock_Seconds();
+            Lexer_LexFile(&lexer);
+            double elapsed = Clock_Seconds() - start;
+            if(run == 1 || (run > 1 && elapsed < best[k])) best[k] = elapsed;
+
+            bytes = lexer.source.size;
+            counts[k] = lexer.lexed;
+            hashes[k] = Hash_Bytes((const char*)lexer.tokens.kinds.data, lexer.lexed * sizeof(TokenKind))
+                      ^ Hash_Bytes((const char*)lexer.tokens.offsets.data, lexer.lexed * sizeof(TokenPos));
+            Lexer_Free(&lexer);
+        }
+    }
+
+    for(size_t k = 0; k < kernel_count; ++k)
+    {
+        if(best[k] <= 0) best[k] = 1e-9;
+        printf("%-8s %10.1f MB/s %12.0f tokens/s  (%zu bytes, %zu tokens)\n",
+               kernels[k].name, bytes / best[k] / 1e6, counts[k] / best[k], bytes, counts[k]);
+        if(hashes[k] != hashes[0] || counts[k] != counts[0])
+        {
+            fprintf(stderr, "\033[0;31mError:\033[0;0m Kernel '%s' produced different tokens than '%s'!\n",
+                    kernels[k].name, kernels[0].name);
+            ret = 1;
+        }
+    }
+
+    LexScan_Select();
+    return ret;
+}
 
 //:==========----------- AST -----------==========://
 
@@ -192,6 +408,7 @@ enum NodeType
     NodeType_Block,
     NodeType_Return,
     NodeType_BinOp,
+    NodeType_UnOp,
     NodeType_Decl,
     NodeType_If,
     NodeType_While,
@@ -211,6 +428,7 @@ const char* NodeType_ToString(enum NodeType t)
     case NodeType_Block: return "Block";
     case NodeType_Return: return "Return";
     case NodeType_BinOp: return "Binary Operation";
+    case NodeType_UnOp: return "Unary Operation";
     case NodeType_Decl: return "Variable Declaration";
     case NodeType_If: return "If";
     case NodeType_While: return "While";
@@ -232,6 +450,7 @@ const char* NodeType_ToString2(enum NodeType t)
     case NodeType_Block: return "Block";
     case NodeType_Return: return "Return";
     case NodeType_BinOp: return "BinOp";
+    case NodeType_UnOp: return "UnOp";
     case NodeType_Decl: return "Decl";
     case NodeType_If: return "If";
     case NodeType_While: return "While";
@@ -240,65 +459,6 @@ const char* NodeType_ToString2(enum NodeType t)
     }
 }
 
-typedef struct { enum NodeType type; } AstNode;
-typedef AstNode* AstNodePtr;
-DECLARE_LIST_TYPE(AstNode)
-DEFINE_LIST_TYPE(AstNode)
-DECLARE_LIST_TYPE(AstNodePtr)
-DEFINE_LIST_TYPE(AstNodePtr)
-
-#define ASTNODE_ALLOC(VAR, T, TYPE) T* VAR = malloc(sizeof(T)); VAR->node.type = TYPE
-#define ASTNODE_FREE(E) if(E) free(E)
-
-void AstNode_FreeAny(AstNode* base);
-
-typedef struct { AstNode node; char* name; CStrList args; AstNode* body; } AstNode_Proc;
-void AstNode_Proc_Free(AstNode_Proc* n)
-{
-    free(n->name);
-    CStrList_ForEach(&n->args, &CStr_Free);
-    CStrList_Free(&n->args);
-    AstNode_FreeAny(n->body);
-    ASTNODE_FREE(n);
-}
-AstNode_Proc* AstNode_Proc_Create(char* name, CStrList* args, AstNode* body)
-{
-    ASTNODE_ALLOC(n, AstNode_Proc, NodeType_Proc);
-    n->name = AllocStringCopy(name);
-    n->args.data = args->data;
-    n->args.count = args->count;
-    n->body = body;
-    return n;
-}
-
-typedef struct { AstNode node; char* iden; } AstNode_Iden;
-void AstNode_Iden_Free(AstNode_Iden* n) { free(n->iden); ASTNODE_FREE(n); }
-AstNode_Iden* AstNode_Iden_Create(char* iden)
-{
-    ASTNODE_ALLOC(n, AstNode_Iden, NodeType_Iden);
-    n->iden = AllocStringCopy(iden);
-    return n;
-}
-
-typedef struct { AstNode node; char* name; AstNode* value; } AstNode_Decl;
-void AstNode_Decl_Free(AstNode_Decl* n) { free(n->name); ASTNODE_FREE(n); }
-AstNode_Decl* AstNode_Decl_Create(char* name, AstNode* default_value)
-{
-    ASTNODE_ALLOC(n, AstNode_Decl, NodeType_Decl);
-    n->name = AllocStringCopy(name);
-    n->value = default_value;
-    return n;
-}
-
-typedef struct { AstNode node; long value; } AstNode_Int;
-void AstNode_Int_Free(AstNode_Int* n) { ASTNODE_FREE(n); }
-AstNode_Int* AstNode_Int_Create(long value)
-{
-    ASTNODE_ALLOC(n, AstNode_Int, NodeType_Int);
-    n->value = value;
-    return n;
-}
-
 enum BinOpType
 {
     BinOpType_Add, // +
@@ -369,120 +529,197 @@ const char* BinOpType_ToString2(enum BinOpType t)
     }
 }
 
-typedef struct { AstNode node; enum BinOpType type; AstNode* left; AstNode* right; } AstNode_BinOp;
-void AstNode_BinOp_Free(AstNode_BinOp* n) { AstNode_FreeAny(n->left); AstNode_FreeAny(n->right); ASTNODE_FREE(n); }
-AstNode_BinOp* AstNode_BinOp_Create(enum BinOpType type, AstNode* left, AstNode* right)
+enum UnOpType
 {
-    ASTNODE_ALLOC(n, AstNode_BinOp, NodeType_BinOp);
-    n->type = type;
-    n->left = left;
-    n->right = right;
-    return n;
-}
+    UnOpType_Neg, // -
+    UnOpType_Not, // !
+};
 
-typedef struct { AstNode node; float value; } AstNode_Float;
-typedef struct { AstNode node; char* value; } AstNode_StringLit;
-typedef struct { AstNode node; AstNodePtrList nodes; } AstNode_Block;
-void AstNode_Block_Free(AstNode_Block* n)
+const char* UnOpType_ToString2(enum UnOpType t)
 {
-    AstNodePtrList_ForEach(&n->nodes, &AstNode_FreeAny);
-    AstNodePtrList_Free(&n->nodes);
-    ASTNODE_FREE(n);
+    switch(t)
+    {
+    case UnOpType_Neg: return "Negate";
+    case UnOpType_Not: return "Not";
+    default: return "<UNKNOWN>";
+    }
 }
-AstNode_Block* AstNode_Block_Create(AstNodePtrList* nodes) // NOTE: This list is moved to the node.
+
+// The tree of a procedure is stored flat: every node is a fixed-size record in one
+// contiguous array and refers to its children by their 32-bit index in that array.
+// Child lists (statements, call arguments, parameters) go to a side table of indices,
+// integer literals to a table of their own. Since none of the three arrays holds a
+// pointer, a tree can be cleared in O(1), copied or written out as is.
+typedef uint32_t AstIndex;
+typedef uint32_t AstList; // Offset into Ast.extra: the element count, followed by the elements.
+typedef long AstInt;
+DECLARE_LIST_TYPE(AstIndex)
+DEFINE_LIST_TYPE(AstIndex)
+DECLARE_LIST_TYPE(AstInt)
+DEFINE_LIST_TYPE(AstInt)
+
+#define AST_NONE ((AstIndex)0)      // Node 0 is reserved, so a missing child is just 0.
+#define AST_EMPTY_LIST ((AstList)0) // As is the first list, which is always empty.
+
+typedef struct
 {
-    ASTNODE_ALLOC(n, AstNode_Block, NodeType_Block);
-    n->nodes.data = nodes->data;
-    n->nodes.count = nodes->count;
-    return n;
-}
+    uint8_t type; // enum NodeType
+    uint8_t op;   // enum BinOpType for NodeType_BinOp, enum UnOpType for NodeType_UnOp.
+    union
+    {
+        struct { Symbol name; AstList params; AstIndex body; uint8_t inlining; } proc; // enum IR_InlineMode
+        struct { Symbol name; } iden;
+        struct { uint32_t literal; } integer; // Index into Ast.ints.
+        struct { Symbol name; AstIndex value; } decl;
+        struct { AstIndex left, right; } binop;
+        struct { AstIndex value; } unop;
+        struct { AstList stmts; } block;
+        struct { AstIndex value; } ret;
+        struct { AstIndex cond, body, othr; } branch;
+        struct { AstIndex cond, body; } loop;
+        struct { AstIndex func; AstList args; } fcall;
+    };
+} AstNode;
+DECLARE_LIST_TYPE(AstNode)
+DEFINE_LIST_TYPE(AstNode)
+
+typedef struct
+{
+    AstNodeList nodes;
+    AstIndexList extra;
+    AstIntList ints;
+} Ast;
 
-typedef struct { AstNode node; AstNode* value; } AstNode_Return;
-void AstNode_Return_Free(AstNode_Return* n) { AstNode_FreeAny(n->value); ASTNODE_FREE(n); }
-AstNode_Return* AstNode_Return_Create(AstNode* value)
+// Drops every node, but keeps the memory around for the next procedure.
+void Ast_Clear(Ast* self)
 {
-    ASTNODE_ALLOC(n, AstNode_Return, NodeType_Return);
-    n->value = value;
-    return n;
+    AstNodeList_Clear(&self->nodes);
+    AstIndexList_Clear(&self->extra);
+    AstIntList_Clear(&self->ints);
+    AstNodeList_PushValue(&self->nodes, (AstNode){ NodeType_Error });
+    AstIndexList_PushValue(&self->extra, 0);
 }
 
-typedef struct { AstNode node; PIM_OWN AstNode* cond, * body, * othr; } AstNode_If;
-void AstNode_If_Free(AstNode_If* n)
+void Ast_Initialize(Ast* self)
 {
-    AstNode_FreeAny(n->cond);
-    AstNode_FreeAny(n->body);
-    if(n->othr) AstNode_FreeAny(n->othr);
-    ASTNODE_FREE(n);
+    AstNodeList_Initialize(&self->nodes);
+    AstIndexList_Initialize(&self->extra);
+    AstIntList_Initialize(&self->ints);
+    Ast_Clear(self);
 }
 
-AstNode_If* AstNode_If_Create(AstNode* cond, AstNode* body, AstNode* othr)
+void Ast_Free(Ast* self)
 {
-    ASTNODE_ALLOC(n, AstNode_If, NodeType_If);
-    n->cond = cond;
-    n->body = body;
-    n->othr = othr;
-    return n;
+    AstNodeList_Free(&self->nodes);
+    AstIndexList_Free(&self->extra);
+    AstIntList_Free(&self->ints);
 }
 
-typedef struct { AstNode node; AstNode* func; PIM_OWN AstNodePtrList args; } AstNode_FCall;
-void AstNode_FCall_Free(AstNode_FCall* n)
+// The pointer is only good until the next node is added.
+static inline const AstNode* Ast_Node(const Ast* self, AstIndex node)
+{ return &self->nodes.data[node]; }
+
+static inline uint32_t Ast_ListCount(const Ast* self, AstList list)
+{ return self->extra.data[list]; }
+
+static inline const uint32_t* Ast_ListItems(const Ast* self, AstList list)
+{ return self->extra.data + list + 1; }
+
+static inline AstInt Ast_Int(const Ast* self, AstIndex node)
+{ return self->ints.data[self->nodes.data[node].integer.literal]; }
+
+AstList Ast_PushList(Ast* self, const uint32_t* items, size_t count)
 {
-    AstNode_FreeAny(n->func);
-    AstNodePtrList_ForEach(&n->args, &AstNode_FreeAny);
-    AstNodePtrList_Free(&n->args);
-    ASTNODE_FREE(n);
+    if(count == 0) return AST_EMPTY_LIST;
+    AstList list = self->extra.count;
+    AstIndexList_PushValue(&self->extra, count);
+    AstIndexList_Append(&self->extra, items, count);
+    return list;
 }
 
-AstNode_FCall* AstNode_FCall_Create(AstNode* func, AstNodePtrList* args)
+AstIndex Ast__Push(Ast* self, AstNode node)
 {
-    ASTNODE_ALLOC(n, AstNode_FCall, NodeType_FCall);
-    n->func = func;
-    n->args.count = args->count;
-    n->args.data = args->data;
-    return n;
+    AstNodeList_PushValue(&self->nodes, node);
+    return self->nodes.count - 1;
 }
 
-void AstNode_FreeAny(AstNode* node)
+AstIndex AstNode_Proc_Create(Ast* ast, Symbol name, AstList params, AstIndex body, enum IR_InlineMode inlining)
+{ return Ast__Push(ast, (AstNode){ NodeType_Proc, .proc = { name, params, body, inlining } }); }
+
+AstIndex AstNode_Iden_Create(Ast* ast, Symbol name)
+{ return Ast__Push(ast, (AstNode){ NodeType_Iden, .iden = { name } }); }
+
+AstIndex AstNode_Decl_Create(Ast* ast, Symbol name, AstIndex default_value)
+{ return Ast__Push(ast, (AstNode){ NodeType_Decl, .decl = { name, default_value } }); }
+
+AstIndex AstNode_Int_Create(Ast* ast, AstInt value)
 {
-    if(!node) return;
-    switch(node->type)
-    {
-    // case NodeType_Error: AstNode_Error_Free(node); break;
-    case NodeType_Proc: AstNode_Proc_Free((AstNode_Proc*)node); break;
-    case NodeType_Iden: AstNode_Iden_Free((AstNode_Iden*)node); break;
-    case NodeType_Int: AstNode_Int_Free((AstNode_Int*)node); break;
-    // case NodeType_Float: AstNode_Float_Free(node); break;
-    // case NodeType_StringLit: AstNode_StringLit_Free(node); break;
-    case NodeType_Return: AstNode_Return_Free((AstNode_Return*)node); break;
-    case NodeType_Block: AstNode_Block_Free((AstNode_Block*)node); break;
-    case NodeType_Decl: AstNode_Decl_Free((AstNode_Decl*)node); break;
-    case NodeType_BinOp: AstNode_BinOp_Free((AstNode_BinOp*)node); break;
-    case NodeType_If: AstNode_If_Free((AstNode_If*)node); break;
-    case NodeType_FCall: AstNode_FCall_Free((AstNode_FCall*)node); break;
-    // TODO: case NodeType_While: AstNode_While_Free((AstNode_While*)node); break;
-    // TODO: case NodeType_FCall: AstNode_FCall_Free((AstNode_FCall*)node); break;
-    default: break;
-    }
+    AstIntList_PushValue(&ast->ints, value);
+    return Ast__Push(ast, (AstNode){ NodeType_Int, .integer = { ast->ints.count - 1 } });
 }
 
+AstIndex AstNode_BinOp_Create(Ast* ast, enum BinOpType type, AstIndex left, AstIndex right)
+{ return Ast__Push(ast, (AstNode){ NodeType_BinOp, type, .binop = { left, right } }); }
+
+AstIndex AstNode_UnOp_Create(Ast* ast, enum UnOpType type, AstIndex value)
+{ return Ast__Push(ast, (AstNode){ NodeType_UnOp, type, .unop = { value } }); }
+
+AstIndex AstNode_Block_Create(Ast* ast, AstList stmts)
+{ return Ast__Push(ast, (AstNode){ NodeType_Block, .block = { stmts } }); }
+
+AstIndex AstNode_Return_Create(Ast* ast, AstIndex value)
+{ return Ast__Push(ast, (AstNode){ NodeType_Return, .ret = { value } }); }
+
+AstIndex AstNode_If_Create(Ast* ast, AstIndex cond, AstIndex body, AstIndex othr)
+{ return Ast__Push(ast, (AstNode){ NodeType_If, .branch = { cond, body, othr } }); }
+
+AstIndex AstNode_While_Create(Ast* ast, AstIndex cond, AstIndex body)
+{ return Ast__Push(ast, (AstNode){ NodeType_While, .loop = { cond, body } }); }
+
+AstIndex AstNode_FCall_Create(Ast* ast, AstIndex func, AstList args)
+{ return Ast__Push(ast, (AstNode){ NodeType_FCall, .fcall = { func, args } }); }
+
 //:==========----------- Recursive-Descent Parser -----------==========://
 
-typedef struct { Lexer* l; AstNode* root; } Parser;
+typedef struct
+{
+    Lexer* l;
+    Ast ast; // Tree of the procedure being parsed.
+    AstIndexList scratch; // Child lists are collected here before they are copied into the tree.
+} Parser;
 
 void Parser_Initialize(Parser* parser, Lexer* l)
 {
     parser->l = l;
-    parser->root = NULL;
+    Ast_Initialize(&parser->ast);
+    AstIndexList_Initialize(&parser->scratch);
 }
 
 void Parser_Free(Parser* self)
 {
-    AstNode_FreeAny(self->root);
+    Ast_Free(&self->ast);
+    AstIndexList_Free(&self->scratch);
+}
+
+// Releases every node returned by Parser_ParseProc so far.
+void Parser_ReleaseNodes(Parser* self)
+{
+    Ast_Clear(&self->ast);
+}
+
+// Moves the scratch entries above `mark` into the tree as a list.
+AstList Parser__PopList(Parser* self, size_t mark)
+{
+    AstList list = Ast_PushList(&self->ast, self->scratch.data + mark, self->scratch.count - mark);
+    self->scratch.count = mark;
+    return list;
 }
 
 void Parser__Error(Parser* self, const char* msg)
 {
-    fprintf(stderr, "\033[0;31mError:\033[0;0m %s\n", msg);
+    size_t line, column;
+    InputFile_Location(&self->l->source, Lexer_Offset(self->l, self->l->current), &line, &column);
+    fprintf(stderr, "%s:%zu:%zu: \033[0;31mError:\033[0;0m %s\n", self->l->source.path, line, column, msg);
 }
 
 void Parser__ErrorFormat(Parser* self, const char* format, ...)
@@ -505,141 +742,106 @@ void Parser__Error_ExpectedMulti(Parser* self, const char* expected, const char*
     Parser__ErrorFormat(self, "Expected %s, but got \"%s\"", expected, actual);
 }
 
-void Parser__FormatToken(Parser* self, char* dest, size_t max_size, Token* token)
+void Parser__FormatToken(Parser* self, char* dest, size_t max_size, int kind, Symbol sym)
 {
-    if(token->type < TokenType__Last)
-        snprintf(dest, max_size, "%s", TokenType_ToString(token->type)); // TODO: for iden, num, str printf value too
+    if(kind == TokenType_Iden && sym != Symbol_None)
+        snprintf(dest, max_size, "%s '%s'", TokenType_ToString(kind), Symbol_Name(sym));
+    else if(kind < TokenType__Last)
+        snprintf(dest, max_size, "%s", TokenType_ToString(kind)); // TODO: for num, str printf value too
     else
-        snprintf(dest, max_size, "'%c'", token->type);
+        snprintf(dest, max_size, "'%c'", kind);
 }
 
-Token* Parser__ExpectKeyword(Parser* self, const char* kw, bool* correct)
+size_t Parser__Expect(Parser* self, int tt, bool* correct)
 {
-    Token* t = Lexer_Peek(self->l);
-    if(t->type != TokenType_Iden || strcmp(t->value, kw) != 0)
-    {
-        *correct = false;
-        char *s = malloc(128);
-        Parser__FormatToken(self, s, 128, t);
-        Parser__Error_Expected(self, kw, s);
-        free(s);
-    }
-
-    *correct = true;
-    return t;
-}
-
-Token* Parser__ExpectKeywordAndMove(Parser* self, const char* kw)
-{
-    bool correct;
-    Token* t = Parser__ExpectKeyword(self, kw, &correct);
-    if(correct) Lexer_Next(self->l);
-    return t;
-}
-
-Token* Parser__Expect(Parser* self, int tt, bool* correct)
-{
-    Token* t = Lexer_Peek(self->l);
-    if(t->type != tt)
+    size_t t = self->l->current;
+    int kind = Lexer_Kind(self->l, t);
+    if(kind != tt)
     {
         if(correct) *correct = false;
-        char* s1 = malloc(128); char* s2 = malloc(2);
-        Token fake_token = { tt, NULL };
-        Parser__FormatToken(self, s1, 128, t);
-        Parser__FormatToken(self, s2, 128, &fake_token);
-        Parser__Error_Expected(self, s1, s2);
+        char* s1 = malloc(128); char* s2 = malloc(128);
+        Parser__FormatToken(self, s1, 128, kind, Lexer_Symbol(self->l, t));
+        Parser__FormatToken(self, s2, 128, tt, Symbol_None);
+        Parser__Error_Expected(self, s2, s1);
         free(s1); free(s2);
     }
     if(correct) *correct = true;
     return t;
 }
 
-Token* Parser__ExpectAndMove(Parser* self, int tt)
+size_t Parser__ExpectAndMove(Parser* self, int tt)
 {
     bool correct;
-    Token* t = Parser__Expect(self, tt, &correct);
+    size_t t = Parser__Expect(self, tt, &correct);
     if(correct) Lexer_Next(self->l);
     return t;
 }
 
 bool Parser__Is(Parser* self, int tt)
-{ return Lexer_Peek(self->l)->type == tt; }
+{ return Lexer_Peek(self->l) == tt; }
 
-bool Parser__IsKeyword(Parser* self, const char* kw)
-{
-    return Lexer_Peek(self->l)->type == TokenType_Iden
-        && strcmp(Lexer_Peek(self->l)->value, kw) == 0;
-}
 
-AstNode* Parser_ParseExpression(Parser* self);
-AstNode* Parser_ParseEx_Atom(Parser* self)
+AstIndex Parser_ParseExpression(Parser* self);
+AstIndex Parser_ParseEx_Atom(Parser* self)
 {
-    Token* t = Lexer_Peek(self->l);
-    /**/ if(t->type == TokenType_Int)
-        return (AstNode*)AstNode_Int_Create(atol(Lexer_Next(self->l)->value));
-    else if(t->type == TokenType_Iden)
-        return (AstNode*)AstNode_Iden_Create(Lexer_Next(self->l)->value);
-    else if(t->type == '(')
+    int kind = Lexer_Peek(self->l);
+    /**/ if(kind == TokenType_Int)
+        return AstNode_Int_Create(&self->ast, Lexer_Integer(self->l, Lexer_Next(self->l)));
+    else if(kind == TokenType_Iden)
+        return AstNode_Iden_Create(&self->ast, Lexer_Symbol(self->l, Lexer_Next(self->l)));
+    else if(kind == '(')
     {
         Lexer_Next(self->l);
-        AstNode* n = Parser_ParseExpression(self);
+        AstIndex n = Parser_ParseExpression(self);
         Parser__ExpectAndMove(self, ')');
         return n;
     }
     else
     {
         const char* actual;
-        char chars[] = { t->type, '\0' };
-        if(t->type < TokenType__Last) actual = TokenType_ToString(t->type);
+        char chars[] = { kind, '\0' };
+        if(kind < TokenType__Last) actual = TokenType_ToString(kind);
         else actual = chars;
         Parser__Error_ExpectedMulti(self, "one of integer, identifier, \"(\"", actual);
-        return NULL;
+        return AST_NONE;
     }
 }
 
-AstNode* Parser_ParseEx_Unr(Parser* self)
+AstIndex Parser_ParseEx_Unr(Parser* self)
 {
-    int unop_type = 0;
-    /**/ if(Lexer_Peek(self->l)->type == '-')
-    {
-        unop_type = '-';
-        fprintf(stderr, "Unary operators are not yet implemented.");
-        return NULL;
-    }
-    else if(Lexer_Peek(self->l)->type == '!')
+    int kind = Lexer_Peek(self->l);
+    if(kind == '-' || kind == '!')
     {
-        unop_type = '!';
-        fprintf(stderr, "Unary operators are not yet implemented.");
-        return NULL;
+        Lexer_Next(self->l);
+        AstIndex value = Parser_ParseEx_Unr(self);
+        return AstNode_UnOp_Create(&self->ast, kind == '-' ? UnOpType_Neg : UnOpType_Not, value);
     }
-    
-    (void)unop_type;
 
-    AstNode* node = Parser_ParseEx_Atom(self);
+    AstIndex node = Parser_ParseEx_Atom(self);
 
-    if(Lexer_Peek(self->l)->type == '(')
+    if(Lexer_Peek(self->l) == '(')
     {
-        AstNodePtrList nodes;
-        AstNodePtrList_Initialize(&nodes);
+        size_t mark = self->scratch.count;
         do
         {
             Lexer_Next(self->l);
-            if(Lexer_Peek(self->l)->type == ')') break;
-            AstNodePtrList_PushValue(&nodes, Parser_ParseExpression(self));
+            if(Lexer_Peek(self->l) == ')') break;
+            AstIndex arg = Parser_ParseExpression(self);
+            AstIndexList_PushValue(&self->scratch, arg);
         }
-        while(Lexer_Peek(self->l)->type != ')' && Lexer_Peek(self->l)->type == ',');
+        while(Lexer_Peek(self->l) != ')' && Lexer_Peek(self->l) == ',');
         Lexer_Next(self->l);
-        return (AstNode*)AstNode_FCall_Create(node, PIM_MOVE(&nodes));
+        return AstNode_FCall_Create(&self->ast, node, Parser__PopList(self, mark));
     }
 
     return node;
 }
 
 #define DEFINE_PARSER_BIN_EXPR_FN(NAME, BEFORE, TYPE, TEST) \
-    AstNode* Parser_ParseEx_##NAME(Parser* self) \
-    { AstNode* n = Parser_ParseEx_##BEFORE(self); Token* t = Lexer_Peek(self->l); \
-      for(int tt = t->type; TEST; (t = Lexer_Peek(self->l)), (tt = t->type)) \
-      { Lexer_Next(self->l); n = (AstNode*)AstNode_BinOp_Create(TYPE, n, Parser_ParseEx_##BEFORE(self)); } \
+    AstIndex Parser_ParseEx_##NAME(Parser* self) \
+    { AstIndex n = Parser_ParseEx_##BEFORE(self); \
+      for(int tt = Lexer_Peek(self->l); TEST; tt = Lexer_Peek(self->l)) \
+      { Lexer_Next(self->l); n = AstNode_BinOp_Create(&self->ast, TYPE, n, Parser_ParseEx_##BEFORE(self)); } \
       return n; }
 
 DEFINE_PARSER_BIN_EXPR_FN(Mul, Unr, tt == '*' ? BinOpType_Mul : BinOpType_Div, tt == '*' || tt == '/')
@@ -651,56 +853,70 @@ DEFINE_PARSER_BIN_EXPR_FN(Ceq, Cmp,
 DEFINE_PARSER_BIN_EXPR_FN(Eql, Ceq,
     tt == TokenType_DoubleEqual ? BinOpType_Eql : BinOpType_Neq,
     tt == TokenType_DoubleEqual || tt == TokenType_NotEqual)
-DEFINE_PARSER_BIN_EXPR_FN(Set, Eql, BinOpType_Set, tt == '=')
+DEFINE_PARSER_BIN_EXPR_FN(And, Eql, BinOpType_And, tt == TokenType_DoubleAmp)
+DEFINE_PARSER_BIN_EXPR_FN(Cor, And, BinOpType_Cor, tt == TokenType_DoublePipe)
+DEFINE_PARSER_BIN_EXPR_FN(Set, Cor, BinOpType_Set, tt == '=')
 
-AstNode* Parser_ParseExpression(Parser* self)
+AstIndex Parser_ParseExpression(Parser* self)
 {
     return Parser_ParseEx_Set(self);
     // char* s = malloc(128);
-    // Parser__FormatToken(self, s, 128, Lexer_Peek(self->l));
+    // Parser__FormatToken(self, s, 128, Lexer_Peek(self->l), Symbol_None);
     // Parser__Error_ExpectedMulti(self, "an expression", s);
     // free(s);
 }
 
-AstNode* Parser_ParseStatement(Parser* self)
+AstIndex Parser_ParseStatement(Parser* self)
 {
-    /**/ if(Parser__IsKeyword(self, "return"))
+    /**/ if(Parser__Is(self, TokenType_KwReturn))
     {
         Lexer_Next(self->l);
-        AstNode* n = (AstNode*)AstNode_Return_Create(Parser_ParseExpression(self));
+        AstIndex n = AstNode_Return_Create(&self->ast, Parser_ParseExpression(self));
         Parser__ExpectAndMove(self, ';');
         return n;
     }
     else if(Parser__Is(self, '{'))
     {
         Lexer_Next(self->l);
-        AstNodePtrList stmts; AstNodePtrList_Initialize(&stmts);
-        while(!Parser__Is(self, '}'))
-            AstNodePtrList_PushValue(&stmts, Parser_ParseStatement(self));
+        size_t mark = self->scratch.count;
+        while(!Parser__Is(self, '}') && !Parser__Is(self, TokenType_Eof))
+        {
+            AstIndex stmt = Parser_ParseStatement(self);
+            AstIndexList_PushValue(&self->scratch, stmt);
+        }
         Lexer_Next(self->l);
-        return (AstNode*)AstNode_Block_Create(PIM_MOVE(&stmts));
+        return AstNode_Block_Create(&self->ast, Parser__PopList(self, mark));
     }
-    else if(Parser__IsKeyword(self, "if"))
+    else if(Parser__Is(self, TokenType_KwIf))
     {
         Lexer_Next(self->l);
         Parser__ExpectAndMove(self, '(');
-        AstNode* cond = Parser_ParseExpression(self);
+        AstIndex cond = Parser_ParseExpression(self);
         Parser__ExpectAndMove(self, ')');
-        AstNode* body = Parser_ParseStatement(self);
-        AstNode* othr = NULL;
-        if(Parser__IsKeyword(self, "else"))
+        AstIndex body = Parser_ParseStatement(self);
+        AstIndex othr = AST_NONE;
+        if(Parser__Is(self, TokenType_KwElse))
         {
             Lexer_Next(self->l);
             othr = Parser_ParseStatement(self);
         }
-        return (AstNode*)AstNode_If_Create(cond, body, othr);
+        return AstNode_If_Create(&self->ast, cond, body, othr);
+    }
+    else if(Parser__Is(self, TokenType_KwWhile))
+    {
+        Lexer_Next(self->l);
+        Parser__ExpectAndMove(self, '(');
+        AstIndex cond = Parser_ParseExpression(self);
+        Parser__ExpectAndMove(self, ')');
+        AstIndex body = Parser_ParseStatement(self);
+        return AstNode_While_Create(&self->ast, cond, body);
     }
-    else if(Lexer_Peek(self->l)->type == TokenType_Iden && Lexer_PeekN(self->l, 2)->type == TokenType_Iden)
+    else if(Lexer_Peek(self->l) == TokenType_Iden && Lexer_PeekN(self->l, 2) == TokenType_Iden)
     {
-        /* Token* type_token = */ Lexer_Next(self->l);
-        Token* name_token = Lexer_Next(self->l);
+        /* size_t type_token = */ Lexer_Next(self->l);
+        Symbol name = Lexer_Symbol(self->l, Lexer_Next(self->l));
 
-        AstNode* default_value = NULL;
+        AstIndex default_value = AST_NONE;
         if(Parser__Is(self, '='))
         {
             Lexer_Next(self->l);
@@ -708,144 +924,178 @@ AstNode* Parser_ParseStatement(Parser* self)
         }
         Parser__ExpectAndMove(self, ';');
 
-        return (AstNode*)AstNode_Decl_Create(name_token->value, default_value);
+        return AstNode_Decl_Create(&self->ast, name, default_value);
     }
     else
     {
-        AstNode* n = Parser_ParseExpression(self);
+        AstIndex n = Parser_ParseExpression(self);
         Parser__ExpectAndMove(self, ';');
         return n;
     }
 }
 
-AstNode_Proc* Parser_ParseProc(Parser* self)
+AstIndex Parser_ParseProc(Parser* self)
 {
-    Parser__ExpectKeywordAndMove(self, "proc");
-    char* name = Lexer_Next(self->l)->value;
-    CStrList args; CStrList_Initialize(&args);
+    enum IR_InlineMode inlining = IR_InlineMode_Auto;
+    /**/ if(Parser__Is(self, TokenType_KwInline)) { Lexer_Next(self->l); inlining = IR_InlineMode_Always; }
+    else if(Parser__Is(self, TokenType_KwNoinline)) { Lexer_Next(self->l); inlining = IR_InlineMode_Never; }
+    Parser__ExpectAndMove(self, TokenType_KwProc);
+    Symbol name = Lexer_Symbol(self->l, Lexer_Next(self->l));
+    size_t mark = self->scratch.count;
 
     Parser__ExpectAndMove(self, '(');
     while(!Parser__Is(self, ')'))
     {
         bool correct;
-        Token* t = Parser__Expect(self, TokenType_Iden, &correct);
-        if(correct) CStrList_PushValue(&args, AllocStringCopy(t->value));
+        size_t t = Parser__Expect(self, TokenType_Iden, &correct);
+        if(correct) AstIndexList_PushValue(&self->scratch, Lexer_Symbol(self->l, t));
         Lexer_Next(self->l);
 
         if(!Parser__Is(self, ',')) break;
         else Lexer_Next(self->l);
     }
     Parser__ExpectAndMove(self, ')');
-    AstNode* body = Parser_ParseStatement(self);
-    return AstNode_Proc_Create(name, &args, body);
+    AstList params = Parser__PopList(self, mark);
+    AstIndex body = Parser_ParseStatement(self);
+    return AstNode_Proc_Create(&self->ast, name, params, body, inlining);
 }
 
-void AstNode_Show(const AstNode* node, int indent);
-void AstNode_Proc_Show(const AstNode_Proc* node, int indent) {
-    printf("Procedure: \"%s\", %ld args.\n", node->name, node->args.count);
-    AstNode_Show(node->body, indent + 1);
+void AstNode_Show(const Ast* ast, AstIndex node, int indent);
+void AstNode_Proc_Show(const Ast* ast, const AstNode* node, int indent) {
+    printf("Procedure: \"%s\", %u args.\n", Symbol_Name(node->proc.name), Ast_ListCount(ast, node->proc.params));
+    AstNode_Show(ast, node->proc.body, indent + 1);
 }
-void AstNode_Int_Show(const AstNode_Int* node, int indent) {
-    printf("Integer: %ld\n", node->value);
+void AstNode_Int_Show(const Ast* ast, AstIndex node, int indent) {
+    printf("Integer: %ld\n", Ast_Int(ast, node));
 }
-void AstNode_Iden_Show(const AstNode_Iden* node, int indent) {
-    printf("Identifier: '%s'\n", node->iden);
+void AstNode_Iden_Show(const Ast* ast, const AstNode* node, int indent) {
+    printf("Identifier: '%s'\n", Symbol_Name(node->iden.name));
 }
-void AstNode_Return_Show(const AstNode_Return* node, int indent) {
+void AstNode_Return_Show(const Ast* ast, const AstNode* node, int indent) {
     printf("Return:\n");
-    AstNode_Show(node->value, indent + 1);
-}
-void AstNode_BinOp_Show(const AstNode_BinOp* node, int indent) {
-    printf("BinOp: %s\n", BinOpType_ToString2(node->type));
-    AstNode_Show(node->left, indent + 1);
-    AstNode_Show(node->right, indent + 1);
-}
-void AstNode_Block_Show(const AstNode_Block* node, int indent) {
-    printf("Block: %ld statements:\n", node->nodes.count);
-    for(size_t i = 0; i < node->nodes.count; ++i)
-        AstNode_Show(node->nodes.data[i], indent + 1);
-}
-void AstNode_FCall_Show(const AstNode_FCall* node, int indent) {
-    printf("FCall: %ld arguments\n", node->args.count);
-    AstNode_Show(node->func, indent + 1);
+    AstNode_Show(ast, node->ret.value, indent + 1);
+}
+void AstNode_BinOp_Show(const Ast* ast, const AstNode* node, int indent) {
+    printf("BinOp: %s\n", BinOpType_ToString2(node->op));
+    AstNode_Show(ast, node->binop.left, indent + 1);
+    AstNode_Show(ast, node->binop.right, indent + 1);
+}
+void AstNode_UnOp_Show(const Ast* ast, const AstNode* node, int indent) {
+    printf("UnOp: %s\n", UnOpType_ToString2(node->op));
+    AstNode_Show(ast, node->unop.value, indent + 1);
+}
+void AstNode_Block_Show(const Ast* ast, const AstNode* node, int indent) {
+    uint32_t count = Ast_ListCount(ast, node->block.stmts);
+    const AstIndex* stmts = Ast_ListItems(ast, node->block.stmts);
+    printf("Block: %u statements:\n", count);
+    for(uint32_t i = 0; i < count; ++i)
+        AstNode_Show(ast, stmts[i], indent + 1);
+}
+void AstNode_FCall_Show(const Ast* ast, const AstNode* node, int indent) {
+    uint32_t count = Ast_ListCount(ast, node->fcall.args);
+    const AstIndex* args = Ast_ListItems(ast, node->fcall.args);
+    printf("FCall: %u arguments\n", count);
+    AstNode_Show(ast, node->fcall.func, indent + 1);
     for(int i = -2; i < indent * 2; ++i) fputc(' ', stdout);
     printf("Arguments:\n");
-    for(size_t i = 0; i < node->args.count; ++i)
-        AstNode_Show(node->args.data[i], indent + 1);
+    for(uint32_t i = 0; i < count; ++i)
+        AstNode_Show(ast, args[i], indent + 1);
 }
-void AstNode_Decl_Show(const AstNode_Decl* node, int indent)
+void AstNode_Decl_Show(const Ast* ast, const AstNode* node, int indent)
 {
-    printf("Variable %s", node->name);
-    if(node->value) printf(" =");
+    printf("Variable %s", Symbol_Name(node->decl.name));
+    if(node->decl.value) printf(" =");
     putc('\n', stdout);
-    if(node->value) AstNode_Show(node->value, indent + 1);
+    if(node->decl.value) AstNode_Show(ast, node->decl.value, indent + 1);
 }
-void AstNode_If_Show(const AstNode_If* node, int indent)
+void AstNode_If_Show(const Ast* ast, const AstNode* node, int indent)
 {
     printf("If:\n");
     for(int i = -2; i < indent * 2; ++i) fputc(' ', stdout);
     printf("Cond:\n");
-    AstNode_Show(node->cond, indent + 2);
+    AstNode_Show(ast, node->branch.cond, indent + 2);
     for(int i = -2; i < indent * 2; ++i) fputc(' ', stdout);
     printf("Body:\n");
-    AstNode_Show(node->body, indent + 2);
-    if(node->othr)
+    AstNode_Show(ast, node->branch.body, indent + 2);
+    if(node->branch.othr)
     {
         for(int i = -2; i < indent * 2; ++i) fputc(' ', stdout);
         printf("Else:\n");
-        AstNode_Show(node->othr, indent + 2);
+        AstNode_Show(ast, node->branch.othr, indent + 2);
     }
 }
 
-void AstNode_Show(const AstNode* node, int indent)
+void AstNode_While_Show(const Ast* ast, const AstNode* node, int indent)
+{
+    printf("While:\n");
+    for(int i = -2; i < indent * 2; ++i) fputc(' ', stdout);
+    printf("Cond:\n");
+    AstNode_Show(ast, node->loop.cond, indent + 2);
+    for(int i = -2; i < indent * 2; ++i) fputc(' ', stdout);
+    printf("Body:\n");
+    AstNode_Show(ast, node->loop.body, indent + 2);
+}
+
+void AstNode_Show(const Ast* ast, AstIndex index, int indent)
 {
     for(int i = 0; i < indent * 2; ++i) fputc(' ', stdout);
-    if(!node) { printf("NULL\n"); return; }
+    if(index == AST_NONE) { printf("NULL\n"); return; }
+    const AstNode* node = Ast_Node(ast, index);
     switch(node->type)
     {
-    // case NodeType_Error: AstNode_Error_Free(node); break;
-    case NodeType_Proc: AstNode_Proc_Show((const AstNode_Proc*)node, indent); break;
-    case NodeType_Iden: AstNode_Iden_Show((const AstNode_Iden*)node, indent); break;
-    case NodeType_Int: AstNode_Int_Show((const AstNode_Int*)node, indent); break;
-    // case NodeType_Float: AstNode_Float_Free(node); break;
-    // case NodeType_StringLit: AstNode_StringLit_Free(node); break;
-    case NodeType_Return: AstNode_Return_Show((const AstNode_Return*)node, indent); break;
-    case NodeType_Block: AstNode_Block_Show((const AstNode_Block*)node, indent); break;
-    case NodeType_BinOp: AstNode_BinOp_Show((const AstNode_BinOp*)node, indent); break;
-    case NodeType_If: AstNode_If_Show((const AstNode_If*)node, indent); break;
-    case NodeType_Decl: AstNode_Decl_Show((const AstNode_Decl*)node, indent); break;
+    case NodeType_Proc: AstNode_Proc_Show(ast, node, indent); break;
+    case NodeType_Iden: AstNode_Iden_Show(ast, node, indent); break;
+    case NodeType_Int: AstNode_Int_Show(ast, index, indent); break;
+    case NodeType_Return: AstNode_Return_Show(ast, node, indent); break;
+    case NodeType_Block: AstNode_Block_Show(ast, node, indent); break;
+    case NodeType_BinOp: AstNode_BinOp_Show(ast, node, indent); break;
+    case NodeType_UnOp: AstNode_UnOp_Show(ast, node, indent); break;
+    case NodeType_If: AstNode_If_Show(ast, node, indent); break;
+    case NodeType_While: AstNode_While_Show(ast, node, indent); break;
+    case NodeType_Decl: AstNode_Decl_Show(ast, node, indent); break;
+    case NodeType_FCall: AstNode_FCall_Show(ast, node, indent); break;
     default: printf("Node: %s\n", NodeType_ToString(node->type));break;
     }
 }
 
+//:==========----------- Compiler -----------==========://
+
+DECLARE_LIST_TYPE(IR_Value)
+DEFINE_LIST_TYPE(IR_Value)
+
 typedef struct
 {
-    const char* name;
-    size_t stack_offset;
+    Symbol name;
+    size_t slot; // Stack slot in the procedure's IR.
 } Variable;
 
-DECLARE_HASHMAP_TYPE(Variable, const char*)
-DEFINE_HASHMAP_TYPE(Variable, const char*)
+DECLARE_HASHMAP_TYPE(Variable, Symbol)
+DEFINE_HASHMAP_TYPE(Variable, Symbol)
 
 typedef struct
 {
-    const char* name;
+    Symbol name;
     size_t locals;
     VariableHashMap vars;
 } Procedure;
 
-DECLARE_HASHMAP_TYPE(Procedure, const char*)
-DEFINE_HASHMAP_TYPE(Procedure, const char*)
+DECLARE_HASHMAP_TYPE(Procedure, Symbol)
+DEFINE_HASHMAP_TYPE(Procedure, Symbol)
 
-bool CompareVariableKey(Variable* var, const char* key) { return var->name == key || strcmp(var->name, key) == 0; }
-bool CompareProcedureKey(Procedure* proc, const char* key) { return proc->name == key || strcmp(proc->name, key) == 0; }
+bool CompareVariableKey(Variable* var, Symbol key) { return var->name == key; }
+bool CompareProcedureKey(Procedure* proc, Symbol key) { return proc->name == key; }
 
-void Procedure_Initialize(Procedure* self, const char* name)
+void Procedure_Initialize(Procedure* self, Symbol name)
 {
-    VariableHashMap_Initialize(&self->vars);
+    VariableHashMap_Initialize(&self->vars, &Symbol_Hash, &CompareVariableKey);
     self->name = name;
 }
 
+void Procedure_Free(Procedure* self)
+{
+    VariableHashMap_Free(&self->vars);
+}
+
 // char* Register_ToString[] = { "<error>", "rax", "rbx", "rcx", "rdx" };
 // enum Register
 // {
@@ -883,35 +1133,49 @@ void Procedure_Initialize(Procedure* self, const char* name)
 
 typedef struct
 {
-    IRGenerator gen;
-    char* pref_out_reg;
-    bool alloc_ret_reg;
-    size_t last_stack_offset;
-    bool ret_written;
-    int label_no;
+    IR_Builder ir;
+    IR_Inliner inliner; // Procedures compiled so far, to inline into the later ones.
+    Generator_x86_64 x86;
+    IR_ValueList arg_scratch; // Call arguments and parameters, collected before they are passed on.
+    IR_HoleList holes[2]; // Jumps of the conditions being lowered, by whether they hold.
+    Arena scratch; // Temporary data of the optimization passes and the code generator.
 
     ProcedureHashMap procs;
     VariableHashMap globals;
     Procedure* current_proc; // TODO: VariableContext stack
+    const Ast* ast; // Tree of the procedure being compiled.
 } Compiler;
 bool Compiler_IsDebug = false;
+bool Compiler_EmitIR = false;
+bool Compiler_Optimize = true;
+bool Compiler_PrintStats = false;
+bool Compiler_ReportInlining = false;
 
 void Compiler_Initialize(Compiler* self, FILE* output)
 {
     // printf("Compiler_IsDebug = %s\n", Compiler_IsDebug ? "yes" : "no");
-    IR_Output_Initialize(&self->gen);
+    Generator_x86_64_Initialize(&self->x86);
+    IR_Inliner_Initialize(&self->inliner);
+    if(Compiler_ReportInlining) self->inliner.report = stdout;
+    IR_ValueList_Initialize(&self->arg_scratch);
+    IR_HoleList_Initialize(&self->holes[false]);
+    IR_HoleList_Initialize(&self->holes[true]);
+    Arena_Initialize(&self->scratch, 0);
     self->current_proc = NULL;
-    self->alloc_ret_reg = false;
-    self->last_stack_offset = 8;
-    self->ret_written = false;
-    self->label_no = 0;
-    ProcedureHashMap_Initialize(&self->procs);
+    self->ast = NULL;
+    ProcedureHashMap_Initialize(&self->procs, &Symbol_Hash, &CompareProcedureKey);
 }
 
 void Compiler_Free(Compiler* self)
 {
+    ProcedureHashMap_ForEachRef(&self->procs, &Procedure_Free);
     ProcedureHashMap_Free(&self->procs);
-    IR_Output_Free(&self->gen);
+    IR_ValueList_Free(&self->arg_scratch);
+    IR_HoleList_Free(&self->holes[false]);
+    IR_HoleList_Free(&self->holes[true]);
+    Arena_Free(&self->scratch);
+    Generator_x86_64_Free(&self->x86);
+    IR_Inliner_Free(&self->inliner);
 }
 
 
@@ -920,205 +1184,346 @@ void Compiler__Error(Compiler* self, const char* msg)
     fprintf(stderr, "\033[0;31mError:\033[0;0m %s\n", msg);
 }
 
+void Compiler__ErrorFormat(Compiler* self, const char* format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    char buffer[1024];
+    vsnprintf(buffer, 1024, format, args);
+    Compiler__Error(self, buffer);
+    va_end(args);
+}
 
+#define Compiler__Write(SELF, ...) AssemblyGenerator_Write(&(SELF)->x86.gen, __VA_ARGS__)
+#define Compiler__WriteNoIndent(SELF, ...) AssemblyGenerator_WriteNoIndent(&(SELF)->x86.gen, __VA_ARGS__)
+#define Compiler__Begin(SELF, ...) AssemblyGenerator_Begin(&(SELF)->x86.gen, __VA_ARGS__)
+#define Compiler__End(SELF) AssemblyGenerator_End(&(SELF)->x86.gen)
 
-bool Compiler__IsAssignable(Compiler* self, const AstNode* node) { return true; }
+void Compiler_WriteHeaders(Compiler* self)
+{
+    if(self->x86.text) Compiler__WriteNoIndent(self, ".intel_syntax noprefix");
+    Generator_x86_64_EmitStart(&self->x86, Symbol_Intern("main", 4), WLANG_SYSCALL_EXIT, &self->scratch);
+    Arena_Reset(&self->scratch);
+}
 
-static char* Compiler__saved_regs[] = { "rbp", "rbx", /* not used: "r12", "r13", "r14", "r15" */ };
+bool Compiler__IsAssignable(Compiler* self, AstIndex node)
+{ return Ast_Node(self->ast, node)->type == NodeType_Iden; }
 
-// In future, this will be all instructions.
-void Compiler__GenerateReturn(Compiler* self)
+Variable* Compiler__FindVariable(Compiler* self, Symbol name)
 {
-    // for(size_t i = sizeof(Compiler__saved_regs) / sizeof(char*); i --> 0;)
-    //     Compiler__Write(self, "pop %s", Compiler__saved_regs[i]);
-    Compiler__Write(self, "ret");
+    if(self->current_proc == NULL)
+    {
+        Compiler__Error(self, "Global variables are not supported.");
+        return NULL;
+    }
+    Variable* v = VariableHashMap_Find(&self->current_proc->vars, name);
+    if(!v) Compiler__ErrorFormat(self, "Undeclared variable '%s'.", Symbol_Name(name));
+    return v;
 }
 
+IR_Value Compiler_CompileNode(Compiler* self, AstIndex index);
 
-// TODO: Omit the frame pointer
-// TODO: Write something like Compiler__GetLocalSize()
-void Compiler_CompileNode(Compiler* self, const AstNode* node)
+static inline bool Compiler__IsLogical(const AstNode* node)
 {
-    // printf("# Compiling %s\n", NodeType_ToString(node->type));
-    // AstNode_Show(node, 0);
-    switch(node->type)
+    return (node->type == NodeType_BinOp && (node->op == BinOpType_And || node->op == BinOpType_Cor))
+        || (node->type == NodeType_UnOp && node->op == UnOpType_Not);
+}
+
+// Lowers `index` as the condition of a branch, straight into jumps. The jumps taken when
+// the condition is `!negate` go to `self->holes[true]`, the others to `self->holes[false]`,
+// for the caller to patch once it has the blocks they go to. && and || skip their right
+// side when the left one decides, ! swaps the two lists, and a comparison is only computed
+// for its branch, which the code generator turns into a cmp and a jcc.
+void Compiler_CompileCond(Compiler* self, AstIndex index, bool negate)
+{
+    const AstNode* node = Ast_Node(self->ast, index);
+    if(node->type == NodeType_UnOp && node->op == UnOpType_Not)
     {
-        case NodeType_Proc:
-        {
-            Procedure proc;
-            Procedure_Initialize(&proc, ((AstNode_Proc*)node)->name);
-            ProcedureHashMap_PushRef(&self->procs, &proc);
-            self->current_proc = &self->procs.data[self->procs.count - 1];
+        Compiler_CompileCond(self, node->unop.value, !negate);
+        return;
+    }
+    if(node->type == NodeType_BinOp && (node->op == BinOpType_And || node->op == BinOpType_Cor))
+    {
+        // With `negate`, a && b is !a || !b and the other way around. The right side
+        // only runs if the left one was true for an && and false for an ||.
+        bool run_right = (node->op == BinOpType_And) != negate;
+        size_t mark = self->holes[run_right].count;
+        Compiler_CompileCond(self, node->binop.left, negate);
+        size_t right = IR_Builder_NewBlock(&self->ir);
+        IR_Builder_Patch(&self->ir, &self->holes[run_right], mark, right);
+        IR_Builder_SetBlock(&self->ir, right);
+        Compiler_CompileCond(self, node->binop.right, negate);
+        return;
+    }
+    if(node->type == NodeType_Int)
+    {
+        IR_Builder_Jmp(&self->ir, 0);
+        IR_HoleList_PushValue(&self->holes[(Ast_Int(self->ast, index) != 0) != negate], (IR_Hole){ self->ir.block, false });
+        return;
+    }
 
-            Compiler__WriteNoIndent(self, ".global %s", ((AstNode_Proc*)node)->name);
-            Compiler__Begin(self, "%s:", ((AstNode_Proc*)node)->name);
+    IR_Builder_Br(&self->ir, Compiler_CompileNode(self, index), 0, 0);
+    IR_HoleList_PushValue(&self->holes[!negate], (IR_Hole){ self->ir.block, false });
+    IR_HoleList_PushValue(&self->holes[negate], (IR_Hole){ self->ir.block, true });
+}
 
-            // TODO: Arguments.
+// The value of &&, || or !: 1 if it holds and 0 if not. A ! of anything else only
+// compares with 0, the others branch to keep their short-circuit.
+IR_Value Compiler_CompileLogical(Compiler* self, AstIndex index)
+{
+    const AstNode* node = Ast_Node(self->ast, index);
+    if(node->type == NodeType_UnOp && !Compiler__IsLogical(Ast_Node(self->ast, node->unop.value)))
+        return IR_Builder_Unary(&self->ir, IR_OpType_Not, Compiler_CompileNode(self, node->unop.value));
 
-            for(size_t i = 0; i < sizeof(Compiler__saved_regs) / sizeof(char*); ++i)
-                Compiler__Write(self, "push %s", Compiler__saved_regs[i]);
+    // Both sides store to a local, the SSA builder makes a phi out of it.
+    size_t slot = IR_Builder_NewSlot(&self->ir);
+    size_t mark_true = self->holes[true].count, mark_false = self->holes[false].count;
+    Compiler_CompileCond(self, index, false);
 
-            Compiler__Write(self, "mov rbp, rsp");
+    size_t yes = IR_Builder_NewBlock(&self->ir);
+    IR_Builder_Patch(&self->ir, &self->holes[true], mark_true, yes);
+    IR_Builder_SetBlock(&self->ir, yes);
+    IR_Builder_Store(&self->ir, slot, IR_VALUE_IMM(1));
+    size_t yes_end = self->ir.block;
 
-            
-            Compiler_CompileNode(self, ((AstNode_Proc*)node)->body);
-            if(!self->ret_written) Compiler__GenerateReturn(self);
-            Compiler__End(self);
-        } break;
+    size_t no = IR_Builder_NewBlock(&self->ir);
+    IR_Builder_Patch(&self->ir, &self->holes[false], mark_false, no);
+    IR_Builder_SetBlock(&self->ir, no);
+    IR_Builder_Store(&self->ir, slot, IR_VALUE_IMM(0));
+
+    size_t exit = IR_Builder_NewBlock(&self->ir);
+    IR_Builder_Jmp(&self->ir, exit);
+    IR_Builder_SetBlock(&self->ir, yes_end);
+    IR_Builder_Jmp(&self->ir, exit);
+    IR_Builder_SetBlock(&self->ir, exit);
+    return IR_Builder_Load(&self->ir, slot);
+}
+
+// Lowers `index` into the current block of `self->ir` and returns its value, if it has one.
+// BinOpType and IR_OpType list the binary operators in the same order.
+IR_Value Compiler_CompileNode(Compiler* self, AstIndex index)
+{
+    const AstNode* node = Ast_Node(self->ast, index);
+    switch(node->type)
+    {
         case NodeType_Block:
         {
-            for(size_t i = 0; i < ((AstNode_Block*)node)->nodes.count; ++i)
-            {
-                Compiler_CompileNode(self, ((AstNode_Block*)node)->nodes.data[i]);
-                // self->ret_written = false;
-                // will this work? if(self->ret_written) break;
-            }
+            uint32_t count = Ast_ListCount(self->ast, node->block.stmts);
+            const AstIndex* stmts = Ast_ListItems(self->ast, node->block.stmts);
+            for(uint32_t i = 0; i < count; ++i)
+                Compiler_CompileNode(self, stmts[i]);
         } break;
         case NodeType_FCall:
         {
-            AstNode_FCall* n = (AstNode_FCall*)node;
+            uint32_t arg_count = Ast_ListCount(self->ast, node->fcall.args);
+            const AstIndex* args = Ast_ListItems(self->ast, node->fcall.args);
 
-            // Since we do not use any of those registers in code, we don't need to save/restore them.
-            static char* registers[] = { "rdi", "rsi", "rdx", "rcx", "r8", "r9" };
-            size_t reg_count = sizeof(registers) / sizeof(registers[0]);
-            
-            if(n->args.count > reg_count)
+            static const size_t reg_count = 6;
+            if(arg_count > reg_count)
             {
                 fprintf(stderr, "Passing more than %ld arguments to a function "
                         "is currently not supported. Arguments will be truncated.\n", reg_count);
             }
 
-            size_t actual_arg_count = n->args.count > reg_count ? reg_count : n->args.count;
+            size_t actual_arg_count = arg_count > reg_count ? reg_count : arg_count;
 
+            // All arguments are computed before any of them is passed.
+            size_t mark = self->arg_scratch.count;
             for(size_t i = 0; i < actual_arg_count; ++i)
             {
-                Compiler_CompileNode(self, n->args.data[i]);
-                Compiler__Write(self, "mov %s, rax", registers[i]);
+                IR_Value arg = Compiler_CompileNode(self, args[i]);
+                IR_ValueList_PushValue(&self->arg_scratch, arg);
             }
+            for(size_t i = 0; i < actual_arg_count; ++i)
+                IR_Builder_Arg(&self->ir, i, self->arg_scratch.data[mark + i]);
+            self->arg_scratch.count = mark;
 
-            if(n->func->type != NodeType_Iden)
+            const AstNode* func = Ast_Node(self->ast, node->fcall.func);
+            if(func->type != NodeType_Iden)
             {
                 fprintf(stderr, "Calling a function pointer is not currently supported.");
+                return IR_VALUE_IMM(0);
             }
-            
-            Compiler__Write(self, "call %s", ((AstNode_Iden*)n->func)->iden);
+
+            return IR_Builder_Call(&self->ir, func->iden.name, actual_arg_count);
         } break;
         case NodeType_If:
         {
-            AstNode_If* n = (AstNode_If*)node;
-
-            // TODO: Check if the the condition is one of the '>', '<', '==', '!=' or
-            //       similar nodes and instead of computing the node as a binary operation,
-            //       use the inverse of the corresponding jmp instr.
-            Compiler_CompileNode(self, n->cond);
-            Compiler__Write(self, "cmp rax, 0");
+            size_t mark_true = self->holes[true].count, mark_false = self->holes[false].count;
+            Compiler_CompileCond(self, node->branch.cond, false);
 
-            int label_exit = self->label_no++;
-            int label_else = n->othr ? self->label_no++ : label_exit;
+            size_t then = IR_Builder_NewBlock(&self->ir);
+            IR_Builder_Patch(&self->ir, &self->holes[true], mark_true, then);
+            IR_Builder_SetBlock(&self->ir, then);
+            Compiler_CompileNode(self, node->branch.body);
+            size_t then_end = self->ir.block;
 
-            Compiler__Write(self, "je .L%d", label_else);
-            Compiler_CompileNode(self, n->body);
-
-            if(n->othr)
+            size_t othr_end = 0;
+            if(node->branch.othr)
             {
-                // We don't need to jump if there is no else branch
-                Compiler__Write(self, "jmp .L%d", label_exit);
+                size_t othr = IR_Builder_NewBlock(&self->ir);
+                IR_Builder_Patch(&self->ir, &self->holes[false], mark_false, othr);
+                IR_Builder_SetBlock(&self->ir, othr);
+                Compiler_CompileNode(self, node->branch.othr);
+                othr_end = self->ir.block;
+            }
 
-                Compiler__WriteNoIndent(self, ".L%d:", label_else);
-                Compiler_CompileNode(self, n->othr);
+            // The jumps out of the branches are only added once the exit exists.
+            size_t exit = IR_Builder_NewBlock(&self->ir);
+            IR_Builder_Patch(&self->ir, &self->holes[false], mark_false, exit);
+            IR_Builder_SetBlock(&self->ir, then_end);
+            if(!IR_Builder_IsTerminated(&self->ir)) IR_Builder_Jmp(&self->ir, exit);
+            if(node->branch.othr)
+            {
+                IR_Builder_SetBlock(&self->ir, othr_end);
+                if(!IR_Builder_IsTerminated(&self->ir)) IR_Builder_Jmp(&self->ir, exit);
             }
-            
-            Compiler__WriteNoIndent(self, ".L%d:", label_exit);
+            IR_Builder_SetBlock(&self->ir, exit);
+        } break;
+        case NodeType_While:
+        {
+            // The loop is rotated: the condition is tested once on the way in and then at
+            // the bottom of every iteration. An iteration takes only that branch as long as
+            // IR_LeaveSSA can put the copies of the values it carries around before it,
+            // otherwise they get a block on the back edge and a jump of their own. The
+            // block before the body is the preheader, invariant code is hoisted there.
+            size_t mark_true = self->holes[true].count, mark_false = self->holes[false].count;
+            Compiler_CompileCond(self, node->loop.cond, false);
+
+            size_t preheader = IR_Builder_NewBlock(&self->ir);
+            IR_Builder_Patch(&self->ir, &self->holes[true], mark_true, preheader);
+            IR_Builder_SetBlock(&self->ir, preheader);
+            size_t body = IR_Builder_NewBlock(&self->ir);
+            IR_Builder_Jmp(&self->ir, body);
+
+            IR_Builder_SetBlock(&self->ir, body);
+            Compiler_CompileNode(self, node->loop.body);
+            if(!IR_Builder_IsTerminated(&self->ir))
+            {
+                Compiler_CompileCond(self, node->loop.cond, false);
+                IR_Builder_Patch(&self->ir, &self->holes[true], mark_true, body);
+            }
+
+            size_t exit = IR_Builder_NewBlock(&self->ir);
+            IR_Builder_Patch(&self->ir, &self->holes[false], mark_false, exit);
+            IR_Builder_SetBlock(&self->ir, exit);
         } break;
         case NodeType_Int:
         {
-            Compiler__Write(self, "mov rax, %ld", ((AstNode_Int*)node)->value);
+            return IR_VALUE_IMM(Ast_Int(self->ast, index));
         } break;
         case NodeType_Decl:
         {
             if(self->current_proc == NULL) { Compiler__Error(self, "Global variables are not supported for now."); break; }
-            size_t v_stack_offset = self->last_stack_offset;
-            self->last_stack_offset += 8; // TODO: Variable size
+            size_t slot = IR_Builder_NewSlot(&self->ir);
 
-            VariableHashMap_PushValue(&self->current_proc->vars, (Variable){
-                /* name:   */ ((AstNode_Decl*)node)->name, // TODO: AllocStringCopy & Free
-                /* offset: */ v_stack_offset
+            VariableHashMap_Insert(&self->current_proc->vars, node->decl.name, (Variable){
+                /* name: */ node->decl.name,
+                /* slot: */ slot
             });
 
-
-            if(((AstNode_Decl*)node)->value != NULL)
-            {
-                AstNode_Iden* i = AstNode_Iden_Create(((AstNode_Decl*)node)->name);
-                AstNode_BinOp* s = AstNode_BinOp_Create(BinOpType_Set, (AstNode*)i, ((AstNode_Decl*)node)->value);
-                char* offset_string = Compiler__StackOffsetString(v_stack_offset);
-                Compiler_CompileNode(self, (AstNode*)s);
-                Compiler__Write(self, "sub rsp, 8"); // Because and 'push' instruction will overwrite.
-                Compiler__Write(self, "mov %s, rax", offset_string);
-
-                free(offset_string);
-                AstNode_BinOp_Free(s);
-            }
+            if(node->decl.value != AST_NONE)
+                IR_Builder_Store(&self->ir, slot, Compiler_CompileNode(self, node->decl.value));
         } break;
         case NodeType_Iden:
         {
-            if(self->current_proc == NULL)
-            {
-                Compiler__Error(self, "Global variables are not supported.");
-                break;
-            }
-            Variable* v = VariableHashMap_Find(&self->current_proc->vars, ((AstNode_Iden*)node)->iden, &CompareVariableKey);
-            char* loc = Compiler__StackOffsetString(v->stack_offset);
-            Compiler__Write(self, "mov rax, %s", loc);
-            // Compiler__WriteBinInstr(self, "mov", loc);
-            free(loc);
+            Variable* v = Compiler__FindVariable(self, node->iden.name);
+            if(!v) return IR_VALUE_IMM(0);
+            return IR_Builder_Load(&self->ir, v->slot);
         } break;
         case NodeType_BinOp:
         {
-            AstNode* lhs = ((AstNode_BinOp*)node)->left;
-            AstNode* rhs = ((AstNode_BinOp*)node)->right;
-            switch(((AstNode_BinOp*)node)->type)
+            AstIndex lhs = node->binop.left;
+            AstIndex rhs = node->binop.right;
+            if(node->op == BinOpType_Set)
             {
-                case BinOpType_Set:
-                {
-                    if(!Compiler__IsAssignable(self, lhs)) { Compiler__Error(self, "Cannot assign!"); break; }
-                    Variable* v = VariableHashMap_Find(&self->current_proc->vars, ((AstNode_Iden*)lhs)->iden, &CompareVariableKey);
+                if(!Compiler__IsAssignable(self, lhs)) { Compiler__Error(self, "Cannot assign!"); break; }
+                Variable* v = Compiler__FindVariable(self, Ast_Node(self->ast, lhs)->iden.name);
+                IR_Value value = Compiler_CompileNode(self, rhs);
+                if(v) IR_Builder_Store(&self->ir, v->slot, value);
+                return value;
+            }
 
-                    char* var_loc = Compiler__StackOffsetString(v->stack_offset);
-                    self->pref_out_reg = var_loc;
-                    Compiler_CompileNode(self, rhs);
-                } break;
+            if(node->op == BinOpType_And || node->op == BinOpType_Cor) return Compiler_CompileLogical(self, index);
 
-#define BIN_IMPL_BASE Compiler_CompileNode(self, rhs); \
-                      Compiler__Write(self, "push rax"); \
-                      Compiler_CompileNode(self, lhs); \
-                      Compiler__Write(self, "pop rbx");
-
-                case BinOpType_Add: { BIN_IMPL_BASE; Compiler__Write(self, "add rax, rbx"); } break;
-                case BinOpType_Sub: { BIN_IMPL_BASE; Compiler__Write(self, "sub rax, rbx"); } break;
-#define BIN_IMPL_BASE_CMP(NAME_STR)  BIN_IMPL_BASE; \
-                                     Compiler__Write(self, "cmp rax, rbx"); \
-                                     Compiler__Write(self, "set" NAME_STR " al"); \
-                                     Compiler__Write(self, "movzx rax, al");
-                                     // ^^ Could have "xor rax, rax" before but GCC uses this so...
-
-                case BinOpType_Lst: { BIN_IMPL_BASE_CMP("l"); } break;
-                case BinOpType_Leq: { BIN_IMPL_BASE_CMP("le"); } break;
-                case BinOpType_Grt: { BIN_IMPL_BASE_CMP("g"); } break;
-                case BinOpType_Geq: { BIN_IMPL_BASE_CMP("ge"); } break;
-#undef BIN_IMPL_BASE_CMP
-#undef BIN_IMPL_BASE
-                default: Compiler__Error(self, "This binary operation is not yet implemented!");
-            }
+            IR_Value left = Compiler_CompileNode(self, lhs);
+            IR_Value right = Compiler_CompileNode(self, rhs);
+            return IR_Builder_Binary(&self->ir, (enum IR_OpType)node->op, left, right);
+        } break;
+        case NodeType_UnOp:
+        {
+            if(node->op == UnOpType_Not) return Compiler_CompileLogical(self, index);
+            return IR_Builder_Unary(&self->ir, IR_OpType_Neg, Compiler_CompileNode(self, node->unop.value));
         } break;
         case NodeType_Return:
         {
-            // Value already in RAX.
-            Compiler_CompileNode(self, ((AstNode_Return*)node)->value);
-            Compiler__GenerateReturn(self);
-            self->ret_written = true;
+            IR_Value value = node->ret.value ? Compiler_CompileNode(self, node->ret.value) : IR_VALUE_IMM(0);
+            IR_Builder_Ret(&self->ir, value);
         } break;
-        default: Compiler__Write(self, "# Did not compile node of type %s.", NodeType_ToString2(node->type)); break;
+        default: Compiler__ErrorFormat(self, "Did not compile node of type %s.", NodeType_ToString(node->type)); break;
+    }
+    return IR_VALUE_NONE;
+}
+
+// Lowers a procedure to IR, optimizes it and emits its assembly.
+void Compiler_CompileProc(Compiler* self, AstIndex index)
+{
+    TimingPoint start = Timing_Start(TimingPhase_Codegen);
+    const AstNode* node = Ast_Node(self->ast, index);
+    Procedure proc;
+    Procedure_Initialize(&proc, node->proc.name);
+    // The last definition is kept, like the inliner does, so that the rest still compiles.
+    Procedure* old = ProcedureHashMap_Find(&self->procs, proc.name);
+    if(old)
+    {
+        Compiler__ErrorFormat(self, "Procedure '%s' is defined more than once.", Symbol_Name(proc.name));
+        Procedure_Free(old);
+    }
+    self->current_proc = ProcedureHashMap_Insert(&self->procs, proc.name, proc);
+
+    IR_Proc ir;
+    IR_Proc_Initialize(&ir, node->proc.name);
+    IR_Builder_Begin(&self->ir, &ir);
+
+    // Parameters are copied to locals, so they can be assigned like any other variable.
+    // All of them are taken first, the code generator moves them in at once.
+    uint32_t param_count = Ast_ListCount(self->ast, node->proc.params);
+    const Symbol* params = Ast_ListItems(self->ast, node->proc.params);
+    size_t mark = self->arg_scratch.count;
+    for(uint32_t i = 0; i < param_count; ++i)
+        IR_ValueList_PushValue(&self->arg_scratch, IR_Builder_Param(&self->ir, i));
+    for(uint32_t i = 0; i < param_count; ++i)
+    {
+        size_t slot = IR_Builder_NewSlot(&self->ir);
+        VariableHashMap_Insert(&self->current_proc->vars, params[i], (Variable){ params[i], slot });
+        IR_Builder_Store(&self->ir, slot, self->arg_scratch.data[mark + i]);
+    }
+    self->arg_scratch.count = mark;
+    ir.param_count = param_count;
+
+    Compiler_CompileNode(self, node->proc.body);
+    if(!IR_Builder_IsTerminated(&self->ir)) IR_Builder_Ret(&self->ir, IR_VALUE_IMM(0));
+    Timing_Stop(TimingPhase_Codegen, start);
+
+    if(Compiler_Optimize)
+    {
+        start = Timing_Start(TimingPhase_Optimize);
+        IR_Inliner_Run(&self->inliner, &ir);
+        IR_Inliner_Add(&self->inliner, &ir, node->proc.inlining);
+        IR_Optimize(&ir, &self->scratch);
+        Arena_Reset(&self->scratch);
+        Timing_Stop(TimingPhase_Optimize, start);
     }
+    if(Compiler_EmitIR) IR_Proc_Dump(&ir, stdout);
+
+    start = Timing_Start(TimingPhase_Codegen);
+    self->x86.optimize = Compiler_Optimize;
+    Generator_x86_64_EmitProc(&self->x86, &ir, &self->scratch);
+    Arena_Reset(&self->scratch);
+    Timing_Stop(TimingPhase_Codegen, start);
+
+    IR_Proc_Free(&ir);
+    self->current_proc = NULL;
 }
 
 int System(const char *cmd)
@@ -1142,6 +1547,8 @@ int System_Format(const char* format, ...)
 }
 
 bool Compiler_SaveDebugData = false;
+// The built-in encoder only writes ELF objects and no debug data, `as` does the rest.
+bool Compiler_ExternalAssembler = WLANG_TARGET != WLANG_TARGET_LINUX;
 
 int Command_Assembler(const char* input_name, const char* output_name)
 {
@@ -1160,25 +1567,59 @@ int Command_Linker(const char* input_name, const char* output_name)
 }
 
 bool Compiler_DontLink = false;
+bool Compiler_Run = false;
 bool Compiler_DontCompile = false;
+bool Compiler_BenchLexer = false;
 
-int Build(const char* input_name, const char* output_name)
+// Makes the object from `object` if there is one and else by assembling `input_name`,
+// then links it unless only an object is wanted. An object of our own that doesn't call
+// anything from elsewhere is linked without ld.
+int Build(const char* input_name, X86_Object* object, const char* output_name)
 {
+    if(object && !Compiler_DontLink && !object->errors)
+    {
+        TimingPoint start = Timing_Start(TimingPhase_Encode);
+        X86_LinkResult linked = X86_Link(object, 1, Symbol_Intern("_start", 6), output_name);
+        Timing_Stop(TimingPhase_Encode, start);
+        if(linked == X86_LinkResult_Done) return 0;
+        if(linked == X86_LinkResult_Failed) return 1;
+    }
+
     char tmp_file[] = "/tmp/test_assem_out_XXXXXX";
-    mkstemp(tmp_file);
+    if(!Compiler_DontLink) mkstemp(tmp_file);
 
     const char* o_file = Compiler_DontLink ? output_name : tmp_file;
 
     int ret = 0;
-    if((ret = Command_Assembler(input_name, o_file)) != 0)
+    if(object)
     {
-        fprintf(stderr, "\033[0;31mError:\033[0;0m Assembler command failed with exit code %d!\n", ret);
-        return ret;
+        TimingPoint start = Timing_Start(TimingPhase_Encode);
+        bool written = object->errors == 0 && X86_Object_WriteElf(object, o_file);
+        Timing_Stop(TimingPhase_Encode, start);
+        if(!written)
+        {
+            fprintf(stderr, "\033[0;31mError:\033[0;0m Could not write the object file '%s'!\n", o_file);
+            return 1;
+        }
+    }
+    else
+    {
+        TimingPoint start = Timing_Start(TimingPhase_Assemble);
+        ret = Command_Assembler(input_name, o_file);
+        Timing_Stop(TimingPhase_Assemble, start);
+        if(ret != 0)
+        {
+            fprintf(stderr, "\033[0;31mError:\033[0;0m Assembler command failed with exit code %d!\n", ret);
+            return ret;
+        }
     }
 
     if(!Compiler_DontLink)
     {
-        if((ret = Command_Linker(o_file, output_name)) != 0)
+        TimingPoint start = Timing_Start(TimingPhase_Link);
+        ret = Command_Linker(o_file, output_name);
+        Timing_Stop(TimingPhase_Link, start);
+        if(ret != 0)
         {
             fprintf(stderr, "\033[0;31mError:\033[0;0m Linker command failed with exit code %d!\n", ret);
             return ret;
@@ -1193,59 +1634,130 @@ char* Compile_OutputAssemblyFile = NULL;
 
 int Compile(const char* input_file, const char* output_file)
 {
+    // Without -s the assembly is only written out when `as` is going to read it.
+    X86_Object object;
+    X86_Object_Initialize(&object);
+    bool integrated = Compiler_Run || (!Compiler_ExternalAssembler && !Compiler_SaveDebugData);
+    // Out here as `as` reads it after the output is written.
+    char temp_filename[] = "/tmp/test_compl_out_XXXXXX";
+
+    LexScan_Select();
+    if(Compiler_BenchLexer)
+    {
+        Symbol_InitializeTable();
+        int ret = Lexer_Benchmark(input_file);
+        Symbol_FreeTable();
+        return ret;
+    }
+
     if(!Compiler_DontCompile)
     {
+        Symbol_InitializeTable();
+
         Lexer lexer;
-        Lexer_Initialize(&lexer, input_file);
-        Lexer_LexFile(&lexer);
+        if(!Lexer_Initialize(&lexer, input_file, true)) return 1;
 
-        // for(size_t i = 0; i < lexer.tokens.count; ++i)
+        // Lexer_LexFile(&lexer); // Needs a non-streaming lexer.
+        // for(size_t i = 0; i < lexer.tokens.kinds.count; ++i)
         // {
-        //     Token* t = &lexer.tokens.data[i];
+        //     int kind = lexer.tokens.kinds.data[i];
         //     printf("Token: ");
-        //     if(t->value == NULL) printf("'%c'", t->type);
-        //     else printf("\"%s\" - %s", t->value, TokenType_ToString(t->type));
+        //     if(kind >= TokenType__Last) printf("'%c'", kind);
+        //     else printf("\"%.*s\" - %s", (int)lexer.tokens.lengths.data[i],
+        //                 lexer.source.data + lexer.tokens.offsets.data[i], TokenType_ToString(kind));
         //     printf("\n");
         // }
 
         Parser parser;
         Parser_Initialize(&parser, &lexer);
 
-        char temp_filename[] = "/tmp/test_compl_out_XXXXXX";
-        mkstemp(temp_filename);
-        if(!Compile_OutputAssemblyFile)
+        if(!Compile_OutputAssemblyFile && !integrated)
+        {
+            mkstemp(temp_filename);
             Compile_OutputAssemblyFile = temp_filename;
+        }
 
-        FILE* f = fopen(Compile_OutputAssemblyFile, "w");
+        FILE* f = Compile_OutputAssemblyFile ? fopen(Compile_OutputAssemblyFile, "w") : NULL;
 
         Compiler compiler;
         Compiler_Initialize(&compiler, f);
+        compiler.ast = &parser.ast;
+        compiler.x86.text = f != NULL;
+        compiler.x86.object = integrated ? &object : NULL;
         Compiler_WriteHeaders(&compiler);
-        
-        while(Lexer_Peek(&lexer)->type != TokenType_Eof)
+
+        while(Lexer_Peek(&lexer) != TokenType_Eof)
         {
-            AstNode_Proc* node = Parser_ParseProc(&parser);
-            Compiler_CompileNode(&compiler, (AstNode*)node);
-            AssemblyOutput_Flush(&compiler.output);
+            // The parser pulls tokens from the lexer, which times itself.
+            TimingPoint start = Timing_Start(TimingPhase_Parse), lexing = Timing.phases[TimingPhase_Lex];
+            AstIndex node = Parser_ParseProc(&parser);
+            Timing_Stop(TimingPhase_Parse, start);
+            Timing_Exclude(TimingPhase_Parse, TimingPhase_Lex, lexing);
+
+            Compiler_CompileProc(&compiler, node);
+
+            Timing.procs++;
+            Timing.nodes += parser.ast.nodes.count - 1;
+            // Written out in large pieces rather than after every procedure.
+            if(f && compiler.x86.gen.output.count >= ASSEMBLY_OUTPUT_FLUSH_SIZE)
+            {
+                start = Timing_Start(TimingPhase_Flush);
+                AssemblyOutput_Flush(&compiler.x86.gen.output, f);
+                Timing_Stop(TimingPhase_Flush, start);
+            }
 
             if(Compiler_IsDebug)
             {
-                AstNode_Show((AstNode*)node, 0);
+                AstNode_Show(&parser.ast, node, 0);
                 fputc('\n', stdout);
             }
+
+            Parser_ReleaseNodes(&parser);
         }
 
+        Timing.lines = compiler.x86.gen.output.lines;
+        if(f)
+        {
+            TimingPoint start = Timing_Start(TimingPhase_Flush);
+            AssemblyOutput_Flush(&compiler.x86.gen.output, f);
+            Timing_Stop(TimingPhase_Flush, start);
+        }
+
+        Timing.tokens = lexer.lexed;
         Lexer_Free(&lexer);
 
 
         Compiler_Free(&compiler);
 
-        fclose(f);
+        Timing.bytes = f ? (size_t)ftell(f) : object.text.count;
+        if(f) fclose(f);
 
         Parser_Free(&parser);
-        if(Compiler_IsDebug) return 0;
+        if(Compiler_IsDebug)
+        {
+            if(Timing.enabled) Timing_Print(stdout);
+            if(Compiler_PrintStats) { Generator_x86_64_PrintStats(stdout); X86_Peephole_PrintStats(stdout); }
+            Symbol_FreeTable();
+            X86_Object_Free(&object);
+            return 0;
+        }
+    }
+    // The object still names its symbols through the table.
+    if(Compiler_Run && !Compiler_DontCompile)
+    {
+        if(Timing.enabled) Timing_Print(stdout);
+        if(Compiler_PrintStats) { Generator_x86_64_PrintStats(stdout); X86_Peephole_PrintStats(stdout); }
+        long result = 0;
+        bool ran = object.errors == 0 && X86_Run(&object, 1, Symbol_Intern("main", 4), &result);
+        Symbol_FreeTable();
+        X86_Object_Free(&object);
+        return ran ? (int)result : 1;
     }
-    int ret = Build(Compile_OutputAssemblyFile, output_file);
+    int ret = Build(Compile_OutputAssemblyFile, Compiler_DontCompile || !integrated ? NULL : &object, output_file);
+    Symbol_FreeTable();
+    X86_Object_Free(&object);
+    if(Timing.enabled) Timing_Print(stdout);
+    if(Compiler_PrintStats) { Generator_x86_64_PrintStats(stdout); X86_Peephole_PrintStats(stdout); }
     return ret == 0 ? 0 : 1;
 }
 
@@ -1254,13 +1766,22 @@ int CLI(int argc, char* argv[])
     if(argc < 2) {
         fprintf(stderr, "Usage:\n");
         fprintf(stderr, "\t%s <input files> [flags]\n", argv[0]);
+        fprintf(stderr, "\t(use - as the input file to read from stdin)\n");
         fprintf(stderr, "Flags:\n");
         fprintf(stderr, "\t-o <file>\tset output file\n");
         fprintf(stderr, "\t-s <file>\tset output assembly file\n");
         fprintf(stderr, "\t-d\t\tset debug mode\n");
         fprintf(stderr, "\t-g\t\tassemble and link with debug data\n");
+        fprintf(stderr, "\t-as\t\tassemble with the system assembler instead of the built-in one\n");
         fprintf(stderr, "\t-c\t\tdo not link, only compile\n");
         fprintf(stderr, "\t-z\t\tdo not compile, just repeat the assembler and linker commands\n");
+        fprintf(stderr, "\t-run\t\trun main in memory and exit with what it returns, without any files\n");
+        fprintf(stderr, "\t-bench-lex\tbenchmark the lexer's scanning kernels on the input\n");
+        fprintf(stderr, "\t-time-report\tprint the time spent in each phase of the compiler\n");
+        fprintf(stderr, "\t-emit-ir\tprint the IR of each procedure\n");
+        fprintf(stderr, "\t-O0\t\tdo not optimize the IR or the assembly\n");
+        fprintf(stderr, "\t-stats\t\tprint how often each selection and peephole pattern applied\n");
+        fprintf(stderr, "\t-inline-report\tprint which calls were inlined and why\n");
         return 1;
     }
 
@@ -1270,8 +1791,18 @@ int CLI(int argc, char* argv[])
     char last_opt = 0;
     for(int i = 1; i < argc; ++i)
     {
-        if(argv[i][0] == '-')
+        if(argv[i][0] == '-' && argv[i][1] != '\0')
         {
+            // Long flags, none of them take a value.
+            if(StringEqual(argv[i], "-bench-lex")) { Compiler_BenchLexer = true; last_opt = 0; continue; }
+            if(StringEqual(argv[i], "-time-report")) { Timing.enabled = true; last_opt = 0; continue; }
+            if(StringEqual(argv[i], "-emit-ir")) { Compiler_EmitIR = true; last_opt = 0; continue; }
+            if(StringEqual(argv[i], "-O0")) { Compiler_Optimize = false; last_opt = 0; continue; }
+            if(StringEqual(argv[i], "-stats")) { Compiler_PrintStats = true; last_opt = 0; continue; }
+            if(StringEqual(argv[i], "-inline-report")) { Compiler_ReportInlining = true; last_opt = 0; continue; }
+            if(StringEqual(argv[i], "-as")) { Compiler_ExternalAssembler = true; last_opt = 0; continue; }
+            if(StringEqual(argv[i], "-run")) { Compiler_Run = true; last_opt = 0; continue; }
+
             last_opt = argv[i][1];
             switch(last_opt) {
                 case 'd': Compiler_IsDebug = true; break;
@@ -0,0 +1,62 @@
+#include <wlang/timing.h>
+#include <wlang/util.h>
+#include <sys/resource.h>
+
+TimingReport Timing;
+
+static const char* TimingPhase_ToString(TimingPhase phase)
+{
+    switch(phase)
+    {
+    case TimingPhase_Lex: return "lex";
+    case TimingPhase_Parse: return "parse";
+    case TimingPhase_Codegen: return "codegen";
+    case TimingPhase_Optimize: return "optimize";
+    case TimingPhase_Flush: return "flush";
+    case TimingPhase_Encode: return "encode";
+    case TimingPhase_Assemble: return "assemble";
+    case TimingPhase_Link: return "link";
+    default: return "<UNKNOWN>";
+    }
+}
+
+static double Timing__Seconds(struct timeval tv) { return tv.tv_sec + tv.tv_usec * 1e-6; }
+
+TimingPoint Timing_Now(bool children)
+{
+    struct rusage usage;
+    getrusage(children ? RUSAGE_CHILDREN : RUSAGE_SELF, &usage);
+    return (TimingPoint){
+        /* wall: */ Clock_Seconds(),
+        /* cpu:  */ Timing__Seconds(usage.ru_utime) + Timing__Seconds(usage.ru_stime)
+    };
+}
+
+// Avoids dividing by zero for phases too short for the clock.
+static double Timing__Rate(size_t count, double seconds) { return seconds > 0 ? count / seconds : 0; }
+
+void Timing_Print(FILE* f)
+{
+    TimingPoint total = { 0, 0 };
+    fprintf(f, "Time report:\n");
+    fprintf(f, "  %-10s %12s %12s\n", "phase", "wall (ms)", "cpu (ms)");
+    for(int i = 0; i < TimingPhase__Last; ++i)
+    {
+        fprintf(f, "  %-10s %12.3f %12.3f%s\n", TimingPhase_ToString(i),
+                Timing.phases[i].wall * 1e3, Timing.phases[i].cpu * 1e3,
+                i >= TimingPhase_Assemble ? "  (child)" : "");
+        total.wall += Timing.phases[i].wall;
+        total.cpu += Timing.phases[i].cpu;
+    }
+    fprintf(f, "  %-10s %12.3f %12.3f\n", "total", total.wall * 1e3, total.cpu * 1e3);
+
+    double emit = Timing.phases[TimingPhase_Codegen].wall + Timing.phases[TimingPhase_Flush].wall;
+    fprintf(f, "Counts:\n");
+    fprintf(f, "  %-10s %12zu  (%.0f tokens/s)\n", "tokens", Timing.tokens,
+            Timing__Rate(Timing.tokens, Timing.phases[TimingPhase_Lex].wall));
+    fprintf(f, "  %-10s %12zu  (%.0f nodes/s)\n", "nodes", Timing.nodes,
+            Timing__Rate(Timing.nodes, Timing.phases[TimingPhase_Parse].wall));
+    fprintf(f, "  %-10s %12zu\n", "procs", Timing.procs);
+    fprintf(f, "  %-10s %12zu  (%.0f lines/s)\n", "lines", Timing.lines, Timing__Rate(Timing.lines, emit));
+    fprintf(f, "  %-10s %12zu\n", "bytes", Timing.bytes);
+}
@@ -0,0 +1,63 @@
+#ifndef WLANG_HEADER_TIMING_
+#define WLANG_HEADER_TIMING_
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+//:==========----------- Compile Time Report -----------==========://
+
+typedef enum
+{
+    TimingPhase_Lex,
+    TimingPhase_Parse,
+    TimingPhase_Codegen,
+    TimingPhase_Optimize,
+    TimingPhase_Flush,
+    TimingPhase_Encode,   // Writing the object file or executable without `as` and `ld`.
+    TimingPhase_Assemble, // External, CPU time is that of the child process.
+    TimingPhase_Link,     // Same.
+    TimingPhase__Last
+} TimingPhase;
+
+typedef struct { double wall, cpu; } TimingPoint;
+
+typedef struct
+{
+    bool enabled;
+    TimingPoint phases[TimingPhase__Last];
+    size_t tokens, nodes, procs, lines, bytes;
+} TimingReport;
+
+// Filled in by the driver when `-time-report` is given. The phases are only timed
+// while `enabled` is set; the counts are kept per procedure, so they are cheap anyway.
+extern TimingReport Timing;
+
+// Current wall clock and CPU time, the latter of this process or of its finished children.
+TimingPoint Timing_Now(bool children);
+
+static inline TimingPoint Timing_Start(TimingPhase phase)
+{
+    if(!Timing.enabled) return (TimingPoint){ 0, 0 };
+    return Timing_Now(phase >= TimingPhase_Assemble);
+}
+
+static inline void Timing_Stop(TimingPhase phase, TimingPoint start)
+{
+    if(!Timing.enabled) return;
+    TimingPoint now = Timing_Now(phase >= TimingPhase_Assemble);
+    Timing.phases[phase].wall += now.wall - start.wall;
+    Timing.phases[phase].cpu += now.cpu - start.cpu;
+}
+
+// Takes the time `inner` got since it was at `before` out of `outer`, for a phase that
+// runs inside another one.
+static inline void Timing_Exclude(TimingPhase outer, TimingPhase inner, TimingPoint before)
+{
+    if(!Timing.enabled) return;
+    Timing.phases[outer].wall -= Timing.phases[inner].wall - before.wall;
+    Timing.phases[outer].cpu -= Timing.phases[inner].cpu - before.cpu;
+}
+
+void Timing_Print(FILE* f);
+
+#endif//WLANG_HEADER_TIMING_
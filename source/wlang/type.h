@@ -2,103 +2,234 @@
 #define WLANG_HEADER_TYPE_
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <wlang/pim.h>
 
 //:==========----------- Generic Types -----------==========://
 
 #define LIST(T) T##List
 #define LISTFN(T, NAME) T##List_##NAME
+#define LIST_MIN_CAPACITY 8
+
+// Growable vector: `count` elements are in use out of `capacity` allocated.
+// Pushing grows the capacity geometrically, so building a list is amortized O(n).
+// What is pushed or appended may come from the list itself, it is read before or
+// found again after growing moves the elements.
 #define DECLARE_LIST_TYPE(T) \
     typedef struct {\
         T* data; \
         size_t count; \
+        size_t capacity; \
     } LIST(T); \
     void LISTFN(T, Initialize)(LIST(T)* self); \
-    void LISTFN(T, _IncrSize)(LIST(T)* self); \
+    void LISTFN(T, Reserve)(LIST(T)* self, size_t capacity); \
+    void LISTFN(T, ShrinkToFit)(LIST(T)* self); \
+    void LISTFN(T, _Grow)(LIST(T)* self, size_t min_capacity); \
     T* LISTFN(T, PushValue)(LIST(T)* self, T value); \
     T* LISTFN(T, PushRef)(LIST(T)* self, T* value); \
+    T* LISTFN(T, Append)(LIST(T)* self, const T* values, size_t count); \
+    void LISTFN(T, Clear)(LIST(T)* self); \
     void LISTFN(T, Free)(LIST(T)* self); \
     void LISTFN(T, ForEachRef)(LIST(T)* self, void (*func)(T*)); \
     void LISTFN(T, ForEach)(LIST(T)* self, void (*func)(T));
 
 #define DEFINE_LIST_TYPE(T) \
     void LISTFN(T, Initialize)(LIST(T)* self) \
-    { self->count = 0; self->data = NULL; } \
-    void LISTFN(T, _IncrSize)(LIST(T)* self) \
-    { if(self->count == 0) self->data = malloc(sizeof(T) * (++self->count)); \
-      else self->data = realloc(self->data, sizeof(T) * (++self->count)); } \
+    { self->count = 0; self->capacity = 0; self->data = NULL; } \
+    void LISTFN(T, Reserve)(LIST(T)* self, size_t capacity) \
+    { if(capacity <= self->capacity) return; \
+      self->data = realloc(self->data, sizeof(T) * capacity); self->capacity = capacity; } \
+    void LISTFN(T, ShrinkToFit)(LIST(T)* self) \
+    { if(self->count == self->capacity) return; \
+      if(self->count == 0) { free(self->data); self->data = NULL; self->capacity = 0; return; } \
+      self->data = realloc(self->data, sizeof(T) * self->count); self->capacity = self->count; } \
+    void LISTFN(T, _Grow)(LIST(T)* self, size_t min_capacity) \
+    { size_t c = self->capacity ? self->capacity * 2 : LIST_MIN_CAPACITY; \
+      while(c < min_capacity) c *= 2; \
+      LISTFN(T, Reserve)(self, c); } \
     T* LISTFN(T, PushValue)(LIST(T)* self, T value) \
-    { LISTFN(T, _IncrSize)(self); self->data[self->count - 1] = value; return &self->data[self->count - 1]; } \
+    { if(self->count == self->capacity) LISTFN(T, _Grow)(self, self->count + 1); \
+      self->data[self->count] = value; return &self->data[self->count++]; } \
     T* LISTFN(T, PushRef)(LIST(T)* self, T* value) \
-    { LISTFN(T, _IncrSize)(self); self->data[self->count - 1] = *value; return &self->data[self->count - 1]; } \
+    { T copy = *value; \
+      if(self->count == self->capacity) LISTFN(T, _Grow)(self, self->count + 1); \
+      self->data[self->count] = copy; return &self->data[self->count++]; } \
+    T* LISTFN(T, Append)(LIST(T)* self, const T* values, size_t count) \
+    { if(self->count + count > self->capacity) \
+      { uintptr_t at = (uintptr_t)values, start = (uintptr_t)self->data; \
+        bool inside = self->data && at >= start && at < start + sizeof(T) * self->count; \
+        LISTFN(T, _Grow)(self, self->count + count); \
+        if(inside) values = self->data + (at - start) / sizeof(T); } \
+      if(count) memcpy(&self->data[self->count], values, sizeof(T) * count); \
+      self->count += count; return &self->data[self->count - count]; } \
+    void LISTFN(T, Clear)(LIST(T)* self) \
+    { self->count = 0; } \
     void LISTFN(T, Free)(LIST(T)* self) \
-    { free(self->data); self->count = 0; self->data = NULL; } \
+    { free(self->data); self->count = 0; self->capacity = 0; self->data = NULL; } \
     void LISTFN(T, ForEachRef)(LIST(T)* self, void (*func)(T*)) \
     { for(size_t i = 0; i < self->count; ++i) func(&self->data[i]); } \
     void LISTFN(T, ForEach)(LIST(T)* self, void (*func)(T)) \
     { for(size_t i = 0; i < self->count; ++i) func(self->data[i]); }
 
-// TODO: This is not a Hash Map, just a list with a linear search!
+// Open-addressing hash map with linear probing. Entries are kept in a dense array in
+// insertion order, so iterating `data` is deterministic; `slots` indexes into it.
+// Removed entries leave a tombstone slot and a dead entry until the next rehash.
+// Growing the map compacts `data`, so pointers into it are invalidated like a list's.
 #define HASHMAP(T) T##HashMap
 #define HASHMAPFN(T, NAME) T##HashMap_##NAME
+#define HASHMAP_MIN_SLOTS 16
+#define HASHMAP_SLOT_EMPTY 0
+#define HASHMAP_SLOT_TOMBSTONE 1
+#define HASHMAP_SLOT_FIRST 2
+#define HASHMAP_HASH_MASK (SIZE_MAX >> 1)
+#define HASHMAP_HASH_DEAD SIZE_MAX
 #define DECLARE_HASHMAP_TYPE(T, K) \
     typedef struct {\
         PIM_OWN T* data; \
-        size_t count; \
+        PIM_OWN size_t* hashes; \
+        size_t count, capacity, live; \
+        PIM_OWN size_t* slots; \
+        size_t slot_count, used_slots; \
+        size_t (*hash)(K); \
+        bool (*equal)(T*, K); \
     } HASHMAP(T); \
-    void HASHMAPFN(T, Initialize)(HASHMAP(T)* self); \
-    void HASHMAPFN(T, _IncrSize)(HASHMAP(T)* self); \
-    T* HASHMAPFN(T, PushValue)(HASHMAP(T)* self, T value); \
-    T* HASHMAPFN(T, PushRef)(HASHMAP(T)* self, T* value); \
+    void HASHMAPFN(T, Initialize)(HASHMAP(T)* self, size_t (*hash)(K), bool (*equal)(T*, K)); \
+    void HASHMAPFN(T, Reserve)(HASHMAP(T)* self, size_t count); \
+    void HASHMAPFN(T, _Rehash)(HASHMAP(T)* self, size_t slot_count); \
+    size_t* HASHMAPFN(T, _FindSlot)(HASHMAP(T)* self, K key, size_t hash); \
+    T* HASHMAPFN(T, Insert)(HASHMAP(T)* self, K key, T value); \
+    T* HASHMAPFN(T, Find)(HASHMAP(T)* self, K key); \
+    bool HASHMAPFN(T, Remove)(HASHMAP(T)* self, K key); \
+    void HASHMAPFN(T, Clear)(HASHMAP(T)* self); \
     void HASHMAPFN(T, Free)(HASHMAP(T)* self); \
     void HASHMAPFN(T, ForEachRef)(HASHMAP(T)* self, void (*func)(T*)); \
-    void HASHMAPFN(T, ForEach)(HASHMAP(T)* self, void (*func)(T)); \
-    T* HASHMAPFN(T, Find)(HASHMAP(T)* self, K key, bool (*cmp)(T*, K));
+    void HASHMAPFN(T, ForEach)(HASHMAP(T)* self, void (*func)(T));
 
 #define DEFINE_HASHMAP_TYPE(T, K) \
-    void HASHMAPFN(T, Initialize)(HASHMAP(T)* self) \
-    { self->count = 0; self->data = NULL; } \
-    void HASHMAPFN(T, _IncrSize)(HASHMAP(T)* self) \
-    { if(self->count == 0) self->data = malloc(sizeof(T) * (++self->count)); \
-      else self->data = realloc(self->data, sizeof(T) * (++self->count)); } \
-    T* HASHMAPFN(T, PushValue)(HASHMAP(T)* self, T value) \
-    { HASHMAPFN(T, _IncrSize)(self); self->data[self->count - 1] = value; return &self->data[self->count - 1]; } \
-    T* HASHMAPFN(T, PushRef)(HASHMAP(T)* self, T* value) \
-    { HASHMAPFN(T, _IncrSize)(self); self->data[self->count - 1] = *value; return &self->data[self->count - 1]; } \
+    void HASHMAPFN(T, Initialize)(HASHMAP(T)* self, size_t (*hash)(K), bool (*equal)(T*, K)) \
+    { self->data = NULL; self->hashes = NULL; self->count = self->capacity = self->live = 0; \
+      self->slots = NULL; self->slot_count = self->used_slots = 0; \
+      self->hash = hash; self->equal = equal; } \
+    void HASHMAPFN(T, _Rehash)(HASHMAP(T)* self, size_t slot_count) \
+    { size_t n = 0; \
+      for(size_t i = 0; i < self->count; ++i) if(self->hashes[i] != HASHMAP_HASH_DEAD) \
+      { self->data[n] = self->data[i]; self->hashes[n] = self->hashes[i]; ++n; } \
+      self->count = n; \
+      free(self->slots); self->slots = calloc(slot_count, sizeof(size_t)); \
+      self->slot_count = slot_count; self->used_slots = n; \
+      for(size_t i = 0; i < n; ++i) \
+      { size_t s = self->hashes[i] & (slot_count - 1); \
+        while(self->slots[s] != HASHMAP_SLOT_EMPTY) s = (s + 1) & (slot_count - 1); \
+        self->slots[s] = i + HASHMAP_SLOT_FIRST; } } \
+    void HASHMAPFN(T, Reserve)(HASHMAP(T)* self, size_t count) \
+    { if(count > self->capacity) \
+      { self->data = realloc(self->data, sizeof(T) * count); \
+        self->hashes = realloc(self->hashes, sizeof(size_t) * count); self->capacity = count; } \
+      size_t slot_count = self->slot_count ? self->slot_count : HASHMAP_MIN_SLOTS; \
+      while(slot_count * 3 < count * 4) slot_count *= 2; \
+      if(slot_count != self->slot_count) HASHMAPFN(T, _Rehash)(self, slot_count); } \
+    size_t* HASHMAPFN(T, _FindSlot)(HASHMAP(T)* self, K key, size_t hash) \
+    { if(self->slot_count == 0) return NULL; \
+      size_t mask = self->slot_count - 1; \
+      for(size_t s = hash & mask;; s = (s + 1) & mask) \
+      { size_t e = self->slots[s]; \
+        if(e == HASHMAP_SLOT_EMPTY) return NULL; \
+        if(e != HASHMAP_SLOT_TOMBSTONE && self->hashes[e - HASHMAP_SLOT_FIRST] == hash \
+           && self->equal(&self->data[e - HASHMAP_SLOT_FIRST], key)) return &self->slots[s]; } } \
+    T* HASHMAPFN(T, Insert)(HASHMAP(T)* self, K key, T value) \
+    { size_t hash = self->hash(key) & HASHMAP_HASH_MASK; \
+      size_t* found = HASHMAPFN(T, _FindSlot)(self, key, hash); \
+      if(found) { self->data[*found - HASHMAP_SLOT_FIRST] = value; return &self->data[*found - HASHMAP_SLOT_FIRST]; } \
+      if((self->used_slots + 1) * 4 > self->slot_count * 3) \
+      { size_t slot_count = self->slot_count ? self->slot_count : HASHMAP_MIN_SLOTS; \
+        while(slot_count * 3 < (self->live + 1) * 4) slot_count *= 2; \
+        HASHMAPFN(T, _Rehash)(self, slot_count); } \
+      if(self->count == self->capacity && self->live < self->count) \
+        HASHMAPFN(T, _Rehash)(self, self->slot_count); \
+      if(self->count == self->capacity) \
+      { size_t c = self->capacity ? self->capacity * 2 : LIST_MIN_CAPACITY; \
+        self->data = realloc(self->data, sizeof(T) * c); \
+        self->hashes = realloc(self->hashes, sizeof(size_t) * c); self->capacity = c; } \
+      size_t mask = self->slot_count - 1, s = hash & mask; \
+      while(self->slots[s] > HASHMAP_SLOT_TOMBSTONE) s = (s + 1) & mask; \
+      if(self->slots[s] == HASHMAP_SLOT_EMPTY) self->used_slots++; \
+      self->slots[s] = self->count + HASHMAP_SLOT_FIRST; \
+      self->data[self->count] = value; self->hashes[self->count] = hash; self->live++; \
+      return &self->data[self->count++]; } \
+    T* HASHMAPFN(T, Find)(HASHMAP(T)* self, K key) \
+    { size_t* found = HASHMAPFN(T, _FindSlot)(self, key, self->hash(key) & HASHMAP_HASH_MASK); \
+      return found ? &self->data[*found - HASHMAP_SLOT_FIRST] : NULL; } \
+    bool HASHMAPFN(T, Remove)(HASHMAP(T)* self, K key) \
+    { size_t* found = HASHMAPFN(T, _FindSlot)(self, key, self->hash(key) & HASHMAP_HASH_MASK); \
+      if(!found) return false; \
+      self->hashes[*found - HASHMAP_SLOT_FIRST] = HASHMAP_HASH_DEAD; \
+      *found = HASHMAP_SLOT_TOMBSTONE; self->live--; return true; } \
+    void HASHMAPFN(T, Clear)(HASHMAP(T)* self) \
+    { self->count = self->live = self->used_slots = 0; \
+      if(self->slots) memset(self->slots, 0, sizeof(size_t) * self->slot_count); } \
     void HASHMAPFN(T, Free)(HASHMAP(T)* self) \
-    { free(self->data); self->count = 0; self->data = NULL; } \
+    { free(self->data); free(self->hashes); free(self->slots); \
+      self->data = NULL; self->hashes = NULL; self->slots = NULL; \
+      self->count = self->capacity = self->live = self->slot_count = self->used_slots = 0; } \
     void HASHMAPFN(T, ForEachRef)(HASHMAP(T)* self, void (*func)(T*)) \
-    { for(size_t i = 0; i < self->count; ++i) func(&self->data[i]); } \
+    { for(size_t i = 0; i < self->count; ++i) if(self->hashes[i] != HASHMAP_HASH_DEAD) func(&self->data[i]); } \
     void HASHMAPFN(T, ForEach)(HASHMAP(T)* self, void (*func)(T)) \
-    { for(size_t i = 0; i < self->count; ++i) func(self->data[i]); } \
-    T* HASHMAPFN(T, Find)(HASHMAP(T)* self, K key, bool (*cmp)(T*, K)) \
-    { for(size_t i = 0; i < self->count; ++i) if(cmp(&self->data[i], key)) \
-      return &self->data[i]; return NULL; }
+    { for(size_t i = 0; i < self->count; ++i) if(self->hashes[i] != HASHMAP_HASH_DEAD) func(self->data[i]); }
+
+// FNV-1a, used as the hash function of string-keyed maps.
+static inline size_t Hash_String(const char* s)
+{
+    size_t h = 14695981039346656037ULL;
+    for(; *s; ++s) h = (h ^ (unsigned char)*s) * 1099511628211ULL;
+    return h;
+}
 
+static inline size_t Hash_Bytes(const char* s, size_t length)
+{
+    size_t h = 14695981039346656037ULL;
+    for(size_t i = 0; i < length; ++i) h = (h ^ (unsigned char)s[i]) * 1099511628211ULL;
+    return h;
+}
+
+// Finalizer from splitmix64, spreads small integer keys (like symbol ids) over the table.
+static inline size_t Hash_Integer(size_t x)
+{
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
 
 typedef char* CStr;
-void CStr_Free(char* s) { free(s); }
+static inline void CStr_Free(char* s) { free(s); }
 DECLARE_LIST_TYPE(CStr);
 
 typedef struct {
     char* data;
     size_t size;
+    size_t capacity;
 } DynamicString;
 
 
-void DynamicString_Initialize(DynamicString* self)
-{ self->data = NULL; self->size = 0; }
+static inline void DynamicString_Initialize(DynamicString* self)
+{ self->data = NULL; self->size = 0; self->capacity = 0; }
 
-void DynamicString__IncrSize(DynamicString* self)
+static inline void DynamicString__IncrSize(DynamicString* self)
 {
-    if(self->size == 0) self->data = malloc(++self->size + 1);
-    else self->data = realloc(self->data, ++self->size + 1);
-    self->data[self->size] = '\0';
+    if(self->size + 1 >= self->capacity)
+    {
+        self->capacity = self->capacity ? self->capacity * 2 : 16;
+        self->data = realloc(self->data, self->capacity);
+    }
+    self->data[++self->size] = '\0';
 }
-void DynamicString_Add(DynamicString* self, char value) { DynamicString__IncrSize(self); self->data[self->size - 1] = value; }
-void DynamicString_Free(DynamicString* self) { free(self->data); self->size = 0; self->data = NULL; }
-void DynamicString_CopyFrom(DynamicString* self, const char* source, size_t size) {
+static inline void DynamicString_Add(DynamicString* self, char value) { DynamicString__IncrSize(self); self->data[self->size - 1] = value; }
+static inline void DynamicString_Clear(DynamicString* self) { self->size = 0; if(self->data) self->data[0] = '\0'; }
+static inline void DynamicString_Free(DynamicString* self) { free(self->data); self->size = 0; self->capacity = 0; self->data = NULL; }
+static inline void DynamicString_CopyFrom(DynamicString* self, const char* source, size_t size) {
     self->size = size ? size : strlen(source);
     if(self->data != NULL) free(self->data);
+    self->capacity = self->size + 1;
     self->data = malloc(self->size + 1);
     memcpy(self->data, source, self->size + 1);
 }
@@ -4,6 +4,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
+#include <time.h>
 
 static inline int fpeekc(FILE* f) { int tmp = fgetc(f); ungetc(tmp, f); return tmp; }
 
@@ -17,6 +18,13 @@ static inline char* AllocStringCopy(const char* source)
 static inline bool StringEqual(const char* a, const char* b)
 { return strcmp(a, b) == 0; }
 
+static inline double Clock_Seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
 static inline bool StringStartsWith(const char* src, const char* sub)
 { return strncmp(src, sub, strlen(sub)) == 0; }
 
@@ -0,0 +1 @@
+proc main() { int x = 4; é return x + 1; }
@@ -0,0 +1,3 @@
+proc sum(n, k) { int s = 0; int i = 0; while(i < n) { s = s + i * k; i = i + 1; } return s; }
+proc f(d, n) { int x = 0; if(d != 0) { x = 10 / d; } return x + n; }
+proc main() { int s = 0; int i = 0; while(i < 10) { s = s + i; i = i + 1; } return s + sum(4, 2) + f(2, 1); }
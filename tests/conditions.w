@@ -0,0 +1,27 @@
+proc safe(a, b) { if(b != 0 && a / b > 1) return 1; return 0; }
+proc either(a, b) { if(b == 0 || a / b > 1) return 1; return 0; }
+proc notv(x) { return !x; }
+proc andv(a, b) { return a && b; }
+proc orv(a, b) { return a || b; }
+proc neg(x) { return -x; }
+proc nested(a, b, c) { if(!(a < b && b < c) || c == 7) return 1; else return 0; }
+proc cnt(n) { int r = 0; if(n > 0 && n < 10) r = r + 1; if(!(n > 5)) r = r + 2; if(n == 3 || n == 4 && n != 0) r = r + 4; return r; }
+proc main() {
+    int r = 0;
+    r = r + safe(10, 0);
+    r = r + safe(10, 2) * 2;
+    r = r + either(10, 0) * 4;
+    r = r + notv(0) * 8;
+    r = r + notv(5) * 100;
+    r = r + andv(3, 4) * 16;
+    r = r + andv(3, 0) * 100;
+    r = r + orv(0, 9) * 32;
+    r = r + orv(0, 0) * 100;
+    r = r + neg(-5) * 1;
+    r = r + nested(1, 2, 3) * 100;
+    r = r + nested(3, 2, 1);
+    r = r + cnt(3);
+    r = r + cnt(8) * 10;
+    if(1 && !0) r = r + 1;
+    return r;
+}
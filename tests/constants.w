@@ -0,0 +1,12 @@
+proc branchy(x) {
+    int a = 3; int b = a * 4;
+    if(b > 10) { a = b - 2; } else { a = x; }
+    return a + 1;
+}
+proc looped(x) {
+    int k = 5; int i = 0;
+    while(i < x) { k = k * 1; i = i + 1; }
+    return k + 2;
+}
+proc trap(x) { if(x > 100) { return 1 / 0; } return x; }
+proc main() { return branchy(0) + looped(9) + trap(3); }
@@ -0,0 +1,3 @@
+proc f(x) { x + 1; int unused = x * 2; return 3; x = 9; }
+proc g(x) { int y = x * 7; if(x > 5) { return x; } else { return 1; } return y; }
+proc main() { int y = f(1); return y + g(9); }
@@ -0,0 +1,3 @@
+proc f() { return 1; }
+proc f() { return 2; }
+proc main() { return f(); }
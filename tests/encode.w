@@ -0,0 +1,57 @@
+noinline proc wide(x) return x + 12345678901 - 12345678900;
+noinline proc many(a, b, c, d, e, f) {
+    int x1 = a * b; int x2 = b * c; int x3 = c * d; int x4 = d * e; int x5 = e * f; int x6 = f * a;
+    int x7 = a * c; int x8 = b * d; int x9 = a + c; int y1 = b + d; int y2 = c + e; int y3 = d + f;
+    int y4 = e + a; int y5 = f + b; int y6 = a - f; int y7 = b - e; int y8 = c - f; int y9 = d - e;
+    return x1+x2+x3+x4+x5+x6+x7+x8+x9+y1+y2+y3+y4+y5+y6+y7+y8+y9 + a+b+c+d+e+f;
+}
+noinline proc rem(a, b) return a - a / b * b;
+noinline proc big(n) {
+    int s = 0; int i = 0;
+    while(i < n) {
+        s = s + i * 0 + (s / 2) - 1000;
+        s = s + i * 1 + (s / 3) - 1001;
+        s = s + i * 2 + (s / 4) - 1002;
+        s = s + i * 3 + (s / 5) - 1003;
+        s = s + i * 4 + (s / 6) - 1004;
+        s = s + i * 5 + (s / 7) - 1005;
+        s = s + i * 6 + (s / 8) - 1006;
+        s = s + i * 7 + (s / 9) - 1007;
+        s = s + i * 8 + (s / 10) - 1008;
+        s = s + i * 9 + (s / 11) - 1009;
+        s = s + i * 10 + (s / 12) - 1010;
+        s = s + i * 11 + (s / 13) - 1011;
+        s = s + i * 12 + (s / 14) - 1012;
+        s = s + i * 13 + (s / 15) - 1013;
+        s = s + i * 14 + (s / 16) - 1014;
+        s = s + i * 15 + (s / 17) - 1015;
+        s = s + i * 16 + (s / 18) - 1016;
+        s = s + i * 17 + (s / 19) - 1017;
+        s = s + i * 18 + (s / 20) - 1018;
+        s = s + i * 19 + (s / 21) - 1019;
+        s = s + i * 20 + (s / 22) - 1020;
+        s = s + i * 21 + (s / 23) - 1021;
+        s = s + i * 22 + (s / 24) - 1022;
+        s = s + i * 23 + (s / 25) - 1023;
+        s = s + i * 24 + (s / 26) - 1024;
+        s = s + i * 25 + (s / 27) - 1025;
+        s = s + i * 26 + (s / 28) - 1026;
+        s = s + i * 27 + (s / 29) - 1027;
+        s = s + i * 28 + (s / 30) - 1028;
+        s = s + i * 29 + (s / 31) - 1029;
+        s = s + i * 30 + (s / 32) - 1030;
+        s = s + i * 31 + (s / 33) - 1031;
+        s = s + i * 32 + (s / 34) - 1032;
+        s = s + i * 33 + (s / 35) - 1033;
+        s = s + i * 34 + (s / 36) - 1034;
+        s = s + i * 35 + (s / 37) - 1035;
+        s = s + i * 36 + (s / 38) - 1036;
+        s = s + i * 37 + (s / 39) - 1037;
+        s = s + i * 38 + (s / 40) - 1038;
+        s = s + i * 39 + (s / 41) - 1039;
+        i = i + 1;
+    }
+    if(s < 0) s = 0 - s;
+    return rem(s, 200);
+}
+proc main() return rem(wide(5) + many(1,2,3,4,5,6) + big(3), 256);
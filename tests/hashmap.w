@@ -0,0 +1,84 @@
+proc p0() { return 0; }
+proc p1() { return 1; }
+proc p2() { return 2; }
+proc p3() { return 3; }
+proc p4() { return 4; }
+proc p5() { return 5; }
+proc p6() { return 6; }
+proc p7() { return 7; }
+proc p8() { return 8; }
+proc p9() { return 9; }
+proc p10() { return 10; }
+proc p11() { return 11; }
+proc p12() { return 12; }
+proc p13() { return 13; }
+proc p14() { return 14; }
+proc p15() { return 15; }
+proc p16() { return 16; }
+proc p17() { return 17; }
+proc p18() { return 18; }
+proc p19() { return 19; }
+proc p20() { return 20; }
+proc p21() { return 21; }
+proc p22() { return 22; }
+proc p23() { return 23; }
+proc p24() { return 24; }
+proc p25() { return 25; }
+proc p26() { return 26; }
+proc p27() { return 27; }
+proc p28() { return 28; }
+proc p29() { return 29; }
+proc p30() { return 30; }
+proc p31() { return 31; }
+proc p32() { return 32; }
+proc p33() { return 33; }
+proc p34() { return 34; }
+proc p35() { return 35; }
+proc p36() { return 36; }
+proc p37() { return 37; }
+proc p38() { return 38; }
+proc p39() { return 39; }
+proc vars() {
+    int v0 = 0;
+    int v1 = 2;
+    int v2 = 4;
+    int v3 = 6;
+    int v4 = 8;
+    int v5 = 10;
+    int v6 = 12;
+    int v7 = 14;
+    int v8 = 16;
+    int v9 = 18;
+    int v10 = 20;
+    int v11 = 22;
+    int v12 = 24;
+    int v13 = 26;
+    int v14 = 28;
+    int v15 = 30;
+    int v16 = 32;
+    int v17 = 34;
+    int v18 = 36;
+    int v19 = 38;
+    int v20 = 40;
+    int v21 = 42;
+    int v22 = 44;
+    int v23 = 46;
+    int v24 = 48;
+    int v25 = 50;
+    int v26 = 52;
+    int v27 = 54;
+    int v28 = 56;
+    int v29 = 58;
+    int v30 = 60;
+    int v31 = 62;
+    int v32 = 64;
+    int v33 = 66;
+    int v34 = 68;
+    int v35 = 70;
+    int v36 = 72;
+    int v37 = 74;
+    int v38 = 76;
+    int v39 = 78;
+    return v0 + v1 + v2 + v3 + v4 + v5 + v6 + v7 + v8 + v9 + v10 + v11 + v12 + v13 + v14 + v15 + v16 + v17 + v18 + v19 + v20 + v21 + v22 + v23 + v24 + v25 + v26 + v27 + v28 + v29 + v30 + v31 + v32 + v33 + v34 + v35 + v36 + v37 + v38 + v39;
+}
+proc main() { return vars() - (p0() + p1() + p2() + p3() + p4() + p5() + p6() + p7() + p8() + p9() + p10() + p11() + p12() + p13() + p14() + p15() + p16() + p17() + p18() + p19() + p20() + p21() + p22() + p23() + p24() + p25() + p26() + p27() + p28() + p29() + p30() + p31() + p32() + p33() + p34() + p35() + p36() + p37() + p38() + p39()) - 700; }
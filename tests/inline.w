@@ -0,0 +1,19 @@
+proc add3(a, b, c) { return a + b + c; }
+proc twice(x) { return add3(x, x, 0); }
+proc fact(n) { if(n < 2) { return 1; } return n * fact(n - 1); }
+proc big(x) {
+    int s = x; int i = 0;
+    while(i < 3) {
+        s = s * 3 + 1; s = s - x; s = s * 5 + i; s = s - 7; s = s + x * 2; s = s - i;
+        s = s * 3 + 1; s = s - x; s = s * 5 + i; s = s - 7; s = s + x * 2; s = s - i;
+        s = s * 3 + 1; s = s - x; s = s * 5 + i; s = s - 7; s = s + x * 2; s = s - i;
+        s = s * 3 + 1; s = s - x; s = s * 5 + i; s = s - 7; s = s + x * 2; s = s - i;
+        s = s * 3 + 1; s = s - x; s = s * 5 + i; s = s - 7; s = s + x * 2; s = s - i;
+        s = s * 3 + 1; s = s - x; s = s * 5 + i; s = s - 7; s = s + x * 2; s = s - i;
+        s = s * 3 + 1; s = s - x; s = s * 5 + i; s = s - 7; s = s + x * 2; s = s - i;
+        s = s * 3 + 1; s = s - x; s = s * 5 + i; s = s - 7; s = s + x * 2; s = s - i;
+        i = i + 1;
+    }
+    return s;
+}
+proc main() { return twice(4) + fact(4) + big(1) - big(2); }
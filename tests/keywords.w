@@ -0,0 +1,14 @@
+proc returns(iff, whilex) { return iff - whilex; }
+proc _if(int1, procs) { int elsewhere = int1 * 2; return elsewhere + procs; }
+proc inline_(noinlin, noinlines) { return noinlin * 10 + noinlines; }
+proc main()
+{
+    int retur = 40;
+    int returnn = 2;
+    int If = 7;
+    int While_ = 3;
+    if(retur > returnn) retur = returns(retur, returnn);
+    else retur = 0;
+    while(While_ > 0) { If = If + 1; While_ = While_ - 1; }
+    return retur + _if(If, 1) + inline_(returnn, If);
+}
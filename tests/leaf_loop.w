@@ -0,0 +1,12 @@
+proc mix(a, b) {
+    int v0 = a; int v1 = a + 1; int v2 = a + 2; int v3 = a + 3;
+    int v4 = a + 4; int v5 = a + 5; int v6 = a + 6; int v7 = a + 7;
+    int i = 0;
+    while(i < b) {
+        v0 = v0 + v1; v1 = v1 + v2; v2 = v2 + v3; v3 = v3 + v4;
+        v4 = v4 + v5; v5 = v5 + v6; v6 = v6 + v7; v7 = v7 + v0;
+        i = i + 1;
+    }
+    return v0 + v1 + v2 + v3 + v4 + v5 + v6 + v7;
+}
+proc main() { return mix(1, 3); }
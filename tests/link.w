@@ -0,0 +1,5 @@
+proc main() { return fib(10) + six(1, 2, 3, 4, 5, 6) + odd(7); }
+proc fib(n) { if(n < 2) return n; return fib(n - 1) + fib(n - 2); }
+proc six(a, b, c, d, e, f) { return a + b + c + d + e + f * 10; }
+proc even(n) { if(n == 0) return 1; return odd(n - 1); }
+proc odd(n) { if(n == 0) return 0; return even(n - 1); }
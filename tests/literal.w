@@ -0,0 +1,2 @@
+proc big() { return 9_223_372_036_854_775_808; }
+proc main() { return 9223372036854775807 - 9_223_372_036_854_775_800; }
@@ -0,0 +1,11 @@
+proc swaps(n) {
+    int a = 1; int b = 2; int i = 0;
+    while(i < n) { int t = a; a = b; b = t; i = i + 1; }
+    return a * 10 + b;
+}
+proc rotate(n) {
+    int a = 1; int b = 2; int c = 3; int i = 0;
+    while(i < n) { int t = a; a = b; b = c; c = t; i = i + 1; }
+    return a * 100 + b * 10 + c;
+}
+proc main() { return swaps(3) + rotate(4) - 200; }
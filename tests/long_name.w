@@ -0,0 +1,2 @@
+noinline proc a_procedure_name_long_enough_that_its_calls_and_labels_do_not_fit_the_line_length_the_assembly_buffer_guesses_xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx(n) { int s = 0; while(n > 0) { s = s + n; n = n - 1; } return s; }
+proc main() { return a_procedure_name_long_enough_that_its_calls_and_labels_do_not_fit_the_line_length_the_assembly_buffer_guesses_xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx(10) + 3; }
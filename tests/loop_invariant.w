@@ -0,0 +1,16 @@
+proc guarded(n, d) {
+    int s = 0; int i = 0;
+    while(i < n) { if(d != 0) { s = s + 100 / d; } i = i + 1; }
+    return s;
+}
+proc never(n, d) {
+    int s = 0; int i = 0;
+    while(i < n) { s = s + 100 / d; i = i + 1; }
+    return s;
+}
+proc scaled(n, k) {
+    int s = 0; int i = 0;
+    while(i < n) { s = s + k * 3 + 1; i = i + 1; }
+    return s;
+}
+proc main() { return guarded(5, 0) + guarded(2, 7) + never(0, 0) + scaled(4, 2); }
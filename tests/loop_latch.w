@@ -0,0 +1,11 @@
+proc fib(n) {
+    int a = 0; int b = 1;
+    while(n > 0) { int t = a + b; a = b; b = t; n = n - 1; }
+    return a;
+}
+proc sum(n, k) {
+    int s = 0; int i = 0;
+    while(i < n) { s = s + i * k; i = i + 1; }
+    return s;
+}
+proc main() { return fib(10) + sum(4, 2); }
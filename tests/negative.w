@@ -0,0 +1,2 @@
+proc down(n) { int s = 0; while(n > 0) { s = s - n; n = n - 1; } return s; }
+proc main() { return down(3); }
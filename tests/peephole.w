@@ -0,0 +1,5 @@
+noinline proc sign(x) { if(x > 0) return 1; if(x < 0) return 2; return 3; }
+noinline proc flag(x, y) { int f = x == y; if(f) return 4; return 5; }
+noinline proc same(x) { int y = x; int z = y; return z; }
+noinline proc count(n) { int s = 0; while(n != 0) { s = s + 2; n = n - 1; } return s; }
+proc main() { return sign(5) + sign(-5) * 10 + sign(0) * 100 + flag(1, 1) + flag(1, 2) + same(7) + count(3); }
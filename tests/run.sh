@@ -0,0 +1,76 @@
+#!/bin/sh
+# Usage: run.sh <compiler> <test.w> <work directory>
+#
+# Compiles a test program and checks it against the lines of <test>.expect:
+#   exit N        it exits with N, both linked to a file and with -run
+#   flags F...    compiler flags for all of it
+#   s TEXT        a line of the assembly contains TEXT, from the line the last `s` matched on
+#   s-not TEXT    no line of the assembly contains TEXT
+#   ir TEXT       the same for what the compiler prints to stdout: the -emit-ir output and reports
+#   ir-not TEXT
+#   error TEXT    the same for what the compiler prints to stderr, which is otherwise empty
+#   as            the built-in encoder gives the same code as the system assembler
+#   stdin         the compiler reads the program from a pipe, as `-`
+compiler=$1; test=$2; work=$3
+name=$(basename "$test" .w)
+expect=${test%.w}.expect
+mkdir -p "$work"
+out=$work/$name
+status=0
+
+fail() { echo "$name: $*"; status=1; }
+
+flags=$(sed -n 's/^flags //p' "$expect")
+
+# Runs the compiler on the test program, given as a file or through a pipe.
+compile() {
+    if grep -q '^stdin$' "$expect"; then cat "$test" | "$compiler" - "$@"
+    else "$compiler" "$test" "$@"; fi
+}
+
+# -emit-ir prints while compiling, so one run gives the IR, the assembly and the program.
+compile $flags -emit-ir -o "$out" -s "$out.s" > "$out.ir" 2> "$out.err" || fail "does not compile"
+if ! grep -q '^error ' "$expect" && [ -s "$out.err" ]; then fail "compiler errors:"; cat "$out.err"; fi
+
+# Ordered and negative matches of `kind` lines against a file.
+check() {
+    awk -v kind="$1" -v name="$name" '
+        FNR == NR {
+            if(index($0, kind " ") == 1) want[++n] = substr($0, length(kind) + 2)
+            else if(index($0, kind "-not ") == 1) never[++m] = substr($0, length(kind) + 6)
+            next
+        }
+        {
+            for(j = 1; j <= m; ++j) if(index($0, never[j])) { printf "%s: %s has \"%s\": %s\n", name, kind, never[j], $0; bad = 1 }
+            while(i < n && index($0, want[i + 1])) ++i
+        }
+        END {
+            if(i < n) { printf "%s: %s has no \"%s\" after the earlier matches\n", name, kind, want[i + 1]; bad = 1 }
+            exit bad
+        }' "$expect" "$2" || status=1
+}
+check s "$out.s"
+check ir "$out.ir"
+check error "$out.err"
+
+code=$(sed -n 's/^exit //p' "$expect")
+if [ -n "$code" ]; then
+    "$out"; got=$?
+    [ "$got" = "$code" ] || fail "exits with $got, expected $code"
+    compile $flags -run > /dev/null 2>&1; got=$?
+    [ "$got" = "$code" ] || fail "-run exits with $got, expected $code"
+fi
+
+if grep -q '^as$' "$expect"; then
+    if command -v as > /dev/null && command -v objcopy > /dev/null; then
+        compile $flags -c -o "$out.o" -s "$out.s" > /dev/null 2>&1
+        as "$out.s" -o "$out.as.o"
+        objcopy -O binary --only-section=.text "$out.o" "$out.bin"
+        objcopy -O binary --only-section=.text "$out.as.o" "$out.as.bin"
+        cmp -s "$out.bin" "$out.as.bin" || fail "the encoder and the system assembler differ"
+    else
+        echo "$name: no system assembler to compare the encoder with"
+    fi
+fi
+
+exit $status
@@ -0,0 +1,14 @@
+noinline proc idx(x, y) return x + y * 8;
+noinline proc idx2(x, y) return y * 4 + x;
+noinline proc sc(x) return x * 3 + x * 5 + x * 9;
+noinline proc sh(x) return x * 16;
+noinline proc three(a, b, c) { int s = a + b; int t = a - 7; return s * c + t + a + b + c; }
+noinline proc cnt(n) { int i = 0; int k = 0; while(i < n) { k = k + 1; i = i + 1; } return k - 1; }
+noinline proc less(x) { if(5 < x) return 1; if(5 >= x) return 2; return 3; }
+noinline proc neg(x) return x - 1 + (0 - x) * 2;
+noinline proc wrap(x) return x - (0 - 9223372036854775807 - 1);
+proc main() {
+    int r = idx(3, 2) + idx2(1, 2) + sc(2) + sh(2) + three(1, 2, 3);
+    r = r + cnt(10) + less(7) + less(5) * 10 + neg(4) + wrap(1) - 1;
+    return r;
+}
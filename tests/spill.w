@@ -0,0 +1,48 @@
+noinline proc g(x) { return x + 1; }
+proc main() {
+  int v0 = g(0);
+  int v1 = g(1);
+  int v2 = g(2);
+  int v3 = g(3);
+  int v4 = g(4);
+  int v5 = g(5);
+  int v6 = g(6);
+  int v7 = g(7);
+  int v8 = g(8);
+  int v9 = g(9);
+  int v10 = g(10);
+  int v11 = g(11);
+  int v12 = g(12);
+  int v13 = g(13);
+  int v14 = g(14);
+  int v15 = g(15);
+  int v16 = g(16);
+  int v17 = g(17);
+  int v18 = g(18);
+  int v19 = g(19);
+  int i = 0; int s = 0;
+  while(i < 3) {
+    v0 = v0 + g(i);
+    v1 = v1 + g(i);
+    v2 = v2 + g(i);
+    v3 = v3 + g(i);
+    v4 = v4 + g(i);
+    v5 = v5 + g(i);
+    v6 = v6 + g(i);
+    v7 = v7 + g(i);
+    v8 = v8 + g(i);
+    v9 = v9 + g(i);
+    v10 = v10 + g(i);
+    v11 = v11 + g(i);
+    v12 = v12 + g(i);
+    v13 = v13 + g(i);
+    v14 = v14 + g(i);
+    v15 = v15 + g(i);
+    v16 = v16 + g(i);
+    v17 = v17 + g(i);
+    v18 = v18 + g(i);
+    v19 = v19 + g(i);
+    i = i + 1;
+  }
+  return v0 + v1 + v2 + v3 + v4 + v5 + v6 + v7 + v8 + v9 + v10 + v11 + v12 + v13 + v14 + v15 + v16 + v17 + v18 + v19;
+}
@@ -0,0 +1,3 @@
+proc square(x) { return x * x; }
+proc big() { return 99999999999999999999; }
+proc main() { return square(6) + 5; }
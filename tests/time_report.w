@@ -0,0 +1,2 @@
+proc twice(x) { return x + x; }
+proc main() { return twice(21); }
@@ -0,0 +1,20 @@
+proc pick(a, b, c, d, e, f) { if(a > b) { if(c > d) return e; else return f; } else { return a + b + c + d + e + f; } }
+proc walk(n)
+{
+    int total = 0;
+    int i = 0;
+    while(i < n)
+    {
+        int j = 0;
+        while(j < i)
+        {
+            if(j == 2) total = total + 100;
+            else if(j > 2 && i > 5) { total = total + 10; }
+            else { total = total + 1; }
+            j = j + 1;
+        }
+        i = i + 1;
+    }
+    return total;
+}
+proc main() { return walk(8) - pick(1, 2, 3, 4, 5, 6) + pick(9, 2, 3, 4, 5, 6) + pick(9, 2, 8, 4, 5, 6) - 400; }
@@ -0,0 +1,4 @@
+proc sum(x) { return (x - 0) + (x*1 - 1) + (x*1*1 - 2) + (x - 3) + (x*1 - 4) + (x*1*1 - 5) + (x - 6) + (x*1 - 7) + (x*1*1 - 8) + (x - 9) + (x*1 - 10) + (x*1*1 - 11) + (x - 12) + (x*1 - 13) + (x*1*1 - 14) + (x - 15) + (x*1 - 16) + (x*1*1 - 17) + (x - 18) + (x*1 - 19) + (x*1*1 - 20) + (x - 21) + (x*1 - 22) + (x*1*1 - 23) + (x - 24) + (x*1 - 25) + (x*1*1 - 26) + (x - 27) + (x*1 - 28) + (x*1*1 - 29) + (x - 30) + (x*1 - 31) + (x*1*1 - 32) + (x - 33) + (x*1 - 34) + (x*1*1 - 35) + (x - 36) + (x*1 - 37) + (x*1*1 - 38) + (x - 39); }
+proc nest(x) { return ((((((((((((((((((((((((((((((x + 1) + 1) + 1) + 1) + 1) + 1) + 1) + 1) + 1) + 1) + 1) + 1) + 1) + 1) + 1) + 1) + 1) + 1) + 1) + 1) + 1) + 1) + 1) + 1) + 1) + 1) + 1) + 1) + 1) + 1); }
+proc main() { return sum(100) - nest(10) - 2971; }
+proc broken() { return 1 + ; }